@@ -0,0 +1,138 @@
+/*
+ * FrameAllocations.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ *
+ * Plays a long game headlessly, recording it and drawing every frame to a curses screen nobody sees,
+ * and counts the heap allocations made once the game got going.
+ * Exits with 1 when a single tick or draw allocated.
+ * Build it together with every file in src/ but TextSnake.cpp, and link ncursesw.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <ncurses.h>
+
+#include "../src/SnakeUtils.h"
+#include "../src/ReplayUtils.h"
+
+using namespace TextSnake;
+
+namespace {
+
+	// Allocations made so far.
+	unsigned long long totalAllocations = 0;
+
+	// Frames played before counting, so curses and the game can set themselves up.
+	const unsigned int WARMUP_FRAMES = 1000;
+
+	// Frames counted.
+	const unsigned int TOTAL_FRAMES = 200000;
+
+	// Where the replay of every game goes.
+	const char* REPLAY_FILENAME = "/dev/null";
+
+}
+
+void* operator new(std::size_t size) {
+	totalAllocations++;
+
+	void* memory = std::malloc(size ? size : 1);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	return memory;
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+
+int main() {
+	// Draw to a screen that goes nowhere.
+	FILE* nowhere = std::fopen("/dev/null", "w");
+	SCREEN* screen = newterm("xterm", nowhere, stdin);
+	if (screen == nullptr) {
+		std::fprintf(stderr, "Couldn't open a curses screen.\n");
+		return 1;
+	}
+	InitColors();
+
+	Game game;
+	Snake snake;
+	SeedRandom(game.random, 1);
+	game.level = nullptr;
+	game.scoreSaver = nullptr;
+	game.scoreLoader = nullptr;
+	game.isWrapModeOn = false;
+	game.layout.generation = 0;
+	game.layout.screenSize.x = 80;
+	game.layout.screenSize.y = 24;
+	InitLeaderboard(game.highScores);
+	InitGame(game);
+	UpdateMoveTiming(game, Constants::DEFAULT_CELL_ASPECT_RATIO);
+	InitSnake(snake, game);
+	SpawnApple(game, snake);
+	game.currentState = State::SHOW_MAIN_GAME;
+	UpdateScreen(game);
+
+	// Record every game, the same way the game loop does.
+	ReplayRecorder recorder;
+	recorder.isRecording = false;
+
+	unsigned long long allocationsBefore = 0;
+	unsigned int totalApples = 0;
+	for (unsigned int frame = 0; frame < WARMUP_FRAMES + TOTAL_FRAMES; frame++) {
+		if (frame == WARMUP_FRAMES)
+			allocationsBefore = totalAllocations;
+
+		// Chase the apple so the snake keeps growing, it dies every now and then on its own tail.
+		int input = ERR;
+		if (game.apple.position.x > snake.currentPosition.x)		input = static_cast<int>(CursesUtils::ArrowKey::RIGHT);
+		else if (game.apple.position.x < snake.currentPosition.x)	input = static_cast<int>(CursesUtils::ArrowKey::LEFT);
+		else if (game.apple.position.y > snake.currentPosition.y)	input = static_cast<int>(CursesUtils::ArrowKey::DOWN);
+		else if (game.apple.position.y < snake.currentPosition.y)	input = static_cast<int>(CursesUtils::ArrowKey::UP);
+
+		if (!recorder.isRecording)
+			BeginRecording(recorder, game, snake);
+		RecordTick(recorder, game, snake, input);
+
+		std::size_t tailBefore = GetTailLength(snake);
+		SimulateTick(game, snake, input);
+		if (GetTailLength(snake) > tailBefore)
+			totalApples++;
+
+		// Keep playing forever, a new recording starts with the next tick.
+		if (game.currentState != State::SHOW_MAIN_GAME) {
+			EndRecording(recorder, REPLAY_FILENAME);
+
+			game.lives = Constants::TOTAL_LIVES;
+			game.currentState = State::SHOW_MAIN_GAME;
+			UpdateScreen(game);
+		}
+
+		if (UpdateScreenCache(game)) {
+			erase();
+			Draw(game, snake);
+			refresh();
+		}
+	}
+
+	unsigned long long frameAllocations = totalAllocations - allocationsBefore;
+
+	endwin();
+	delscreen(screen);
+	std::fclose(nowhere);
+
+	std::printf("%llu allocations in %u frames (%u apples eaten)\n", frameAllocations, TOTAL_FRAMES, totalApples);
+
+	return (frameAllocations == 0) ? 0 : 1;
+}
@@ -0,0 +1,306 @@
+/*
+ * GoldenFrames.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ *
+ * Draws every screen of the game to a virtual screen and compares the frames against the golden
+ * ones in bench/golden/, then times the in game frame and counts what it touches.
+ * Exits with 1 when a frame doesn't match its golden one.
+ * Build it together with every file in src/ but TextSnake.cpp, and link ncursesw:
+ *
+ *   g++ -std=c++17 -O2 bench/GoldenFrames.cpp <src files but TextSnake.cpp> -lncursesw -o GoldenFrames
+ *   ./GoldenFrames             compares the frames
+ *   ./GoldenFrames --update    writes the frames as the new golden ones
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "../src/SnakeUtils.h"
+#include "../src/GlyphUtils.h"
+
+using namespace TextSnake;
+
+namespace {
+
+	// Where the golden frames are.
+	const char* GOLDEN_DIRECTORY = "bench/golden/";
+
+	// Size of the virtual screen.
+	const int SCREEN_COLUMNS = 80;
+	const int SCREEN_ROWS = 24;
+
+	// Ticks played before the in game frame is taken, long enough for an item to show up.
+	const unsigned int GAME_TICKS = Constants::ITEM_SPAWN_TICKS + Constants::LOOP_FPS;
+
+	// Tail grown before the frame with Unicode glyphs is taken, long enough to turn a few corners.
+	const std::size_t WIDE_GAME_TAIL_PIECES = 12;
+
+	// Frames drawn for the render benchmark.
+	const unsigned int BENCH_FRAMES = 20000;
+
+	/*
+	 * Sets up a game the same way every time.
+	 */
+	void InitGoldenGame(Game& game, Snake& snake) {
+		SeedRandom(game.random, 1);
+		game.level = nullptr;
+		game.scoreSaver = nullptr;
+		game.scoreLoader = nullptr;
+		game.isWrapModeOn = false;
+		game.layout.generation = 0;
+		game.layout.screenSize.x = CursesUtils::GetColumns();
+		game.layout.screenSize.y = CursesUtils::GetRows();
+
+		InitLeaderboard(game.highScores);
+		InitGame(game);
+		UpdateMoveTiming(game, Constants::DEFAULT_CELL_ASPECT_RATIO);
+		InitSnake(snake, game);
+		SpawnApple(game, snake);
+		InitMenu(game);
+		InitColors();
+		InitGlyphTable(glyphTable, false);
+
+		// A few high scores to show.
+		const char* names[] = { "ALICE", "BOB", "CAROL", "DAVE" };
+		for (unsigned int i = 0; i < 4; i++) {
+			Score score;
+			score.name = names[i];
+			score.score = 100 * (i + 1);
+			InsertScore(game.highScores, score);
+		}
+	}
+
+	/*
+	 * Steers the snake towards the apple.
+	 */
+	int ChaseApple(const Game& game, const Snake& snake) {
+		if (game.apple.position.x > snake.currentPosition.x)		return static_cast<int>(CursesUtils::ArrowKey::RIGHT);
+		else if (game.apple.position.x < snake.currentPosition.x)	return static_cast<int>(CursesUtils::ArrowKey::LEFT);
+		else if (game.apple.position.y > snake.currentPosition.y)	return static_cast<int>(CursesUtils::ArrowKey::DOWN);
+		else if (game.apple.position.y < snake.currentPosition.y)	return static_cast<int>(CursesUtils::ArrowKey::UP);
+
+		return ERR;
+	}
+
+	/*
+	 * Draws a frame the way the game loop does.
+	 */
+	void DrawFrame(Game& game, const Snake& snake) {
+		UpdateScreen(game);
+
+		if (UpdateScreenCache(game)) {
+			CursesUtils::ClearScreen();
+			Draw(game, snake);
+			CursesUtils::RefreshScreen();
+		}
+	}
+
+	void SetUpMainMenu(Game& game, Snake&) {
+		game.currentState = State::SHOW_MAIN_MENU;
+	}
+
+	void SetUpMainGame(Game& game, Snake& snake) {
+		game.currentState = State::SHOW_MAIN_GAME;
+		UpdateScreen(game);
+
+		for (unsigned int tick = 0; tick < GAME_TICKS; tick++)
+			SimulateTick(game, snake, ChaseApple(game, snake));
+	}
+
+	void SetUpMainGameWide(Game& game, Snake& snake) {
+		InitGlyphTable(glyphTable, true);
+		SetUpMainGame(game, snake);
+
+		while (GetTailLength(snake) < WIDE_GAME_TAIL_PIECES && game.currentState == State::SHOW_MAIN_GAME)
+			SimulateTick(game, snake, ChaseApple(game, snake));
+	}
+
+	void SetUpGameOver(Game& game, Snake&) {
+		game.currentState = State::SHOW_GAME_OVER;
+		game.finalScore.score = 250;
+		game.finalRank = GetScoreRank(game.highScores, game.finalScore.score);
+	}
+
+	void SetUpHighScores(Game& game, Snake&) {
+		game.currentState = State::SHOW_HIGH_SCORES;
+	}
+
+	/*
+	 * A screen with a golden frame.
+	 */
+	struct GoldenScreen {
+		const char* name;
+		void (*setUp)(Game&, Snake&);
+	};
+
+	const GoldenScreen SCREENS[] = {
+		{ "MainMenu", SetUpMainMenu },
+		{ "MainGame", SetUpMainGame },
+		{ "MainGameWide", SetUpMainGameWide },
+		{ "GameOver", SetUpGameOver },
+		{ "HighScores", SetUpHighScores }
+	};
+
+	/*
+	 * Reads a whole file, returns false when it isn't there.
+	 */
+	bool ReadFile(const std::string& filename, std::string& contents) {
+		FILE* file = std::fopen(filename.c_str(), "r");
+		if (file == nullptr)
+			return false;
+
+		char buffer[4096];
+		std::size_t bytesRead;
+		while ((bytesRead = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+			contents.append(buffer, bytesRead);
+
+		std::fclose(file);
+		return true;
+	}
+
+	/*
+	 * Writes a whole file.
+	 */
+	bool WriteFile(const std::string& filename, const std::string& contents) {
+		FILE* file = std::fopen(filename.c_str(), "w");
+		if (file == nullptr)
+			return false;
+
+		std::fwrite(contents.data(), 1, contents.size(), file);
+		return std::fclose(file) == 0;
+	}
+
+	/*
+	 * Prints the first line two frames differ on.
+	 */
+	void PrintFirstDifference(const std::string& expected, const std::string& actual) {
+		std::size_t expectedStart = 0;
+		std::size_t actualStart = 0;
+
+		for (unsigned int line = 1; ; line++) {
+			std::size_t expectedEnd = expected.find('\n', expectedStart);
+			std::size_t actualEnd = actual.find('\n', actualStart);
+
+			std::string expectedLine = expected.substr(expectedStart, expectedEnd - expectedStart);
+			std::string actualLine = actual.substr(actualStart, actualEnd - actualStart);
+
+			if (expectedLine != actualLine || expectedEnd == std::string::npos || actualEnd == std::string::npos) {
+				std::printf("  line %u\n  expected: %s\n  actual:   %s\n", line, expectedLine.c_str(), actualLine.c_str());
+				return;
+			}
+
+			expectedStart = expectedEnd + 1;
+			actualStart = actualEnd + 1;
+		}
+	}
+
+	/*
+	 * Times the in game frame on the virtual screen and prints what it touches on average.
+	 */
+	void BenchmarkMainGame() {
+		CursesUtils::VirtualScreen screen;
+		CursesUtils::InitVirtualScreen(screen, SCREEN_COLUMNS, SCREEN_ROWS);
+		CursesUtils::UseVirtualScreen(&screen);
+
+		Game game;
+		Snake snake;
+		InitGoldenGame(game, snake);
+		SetUpMainGame(game, snake);
+
+		// Only count the frames being timed.
+		CursesUtils::InitVirtualScreen(screen, SCREEN_COLUMNS, SCREEN_ROWS);
+		CursesUtils::ResetStyleCache();
+
+		std::chrono::duration<double, std::nano> drawing(0);
+		for (unsigned int frame = 0; frame < BENCH_FRAMES; frame++) {
+			SimulateTick(game, snake, ChaseApple(game, snake));
+
+			// Keep playing forever.
+			if (game.currentState != State::SHOW_MAIN_GAME) {
+				game.lives = Constants::TOTAL_LIVES;
+				game.currentState = State::SHOW_MAIN_GAME;
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			DrawFrame(game, snake);
+			drawing += std::chrono::steady_clock::now() - start;
+		}
+
+		CursesUtils::UseVirtualScreen(nullptr);
+
+		const CursesUtils::StyleCache& style = CursesUtils::styleCache;
+		std::printf("in game frame: %.1f ns, %.1f cells written, %.1f cells changed, %.1f bytes per frame\n",
+		            drawing.count() / BENCH_FRAMES,
+		            static_cast<double>(screen.totalCellsWritten) / screen.totalFrames,
+		            static_cast<double>(screen.totalCellsChanged) / screen.totalFrames,
+		            static_cast<double>(screen.totalBytes) / screen.totalFrames);
+		std::printf("in game frame: %.1f style toggles, %.1f style calls, %.1f elided per frame\n",
+		            static_cast<double>(style.totalToggles) / screen.totalFrames,
+		            static_cast<double>(style.totalCalls) / screen.totalFrames,
+		            static_cast<double>(style.totalToggles - style.totalCalls) / screen.totalFrames);
+	}
+
+}
+
+
+int main(int argc, char* argv[]) {
+	bool isUpdating = (argc == 2) && (std::strcmp(argv[1], "--update") == 0);
+	if (argc > 1 && !isUpdating) {
+		std::fprintf(stderr, "Usage: %s [--update]\n", argv[0]);
+		return 2;
+	}
+
+	unsigned int totalMismatches = 0;
+
+	for (const GoldenScreen& golden : SCREENS) {
+		// Every screen gets drawn from a brand new game on a blank screen.
+		CursesUtils::VirtualScreen screen;
+		CursesUtils::InitVirtualScreen(screen, SCREEN_COLUMNS, SCREEN_ROWS);
+		CursesUtils::UseVirtualScreen(&screen);
+
+		Game game;
+		Snake snake;
+		InitGoldenGame(game, snake);
+		golden.setUp(game, snake);
+		DrawFrame(game, snake);
+
+		CursesUtils::UseVirtualScreen(nullptr);
+
+		std::string frame = CursesUtils::DumpVirtualScreen(screen);
+		std::string filename = std::string(GOLDEN_DIRECTORY) + golden.name + ".txt";
+
+		std::printf("%-12s %5llu cells written %5llu changed %6llu bytes %3llu style calls %3llu elided  ", golden.name,
+		            screen.frameCellsWritten, screen.frameCellsChanged, screen.frameBytes, CursesUtils::styleCache.frameCalls,
+		            CursesUtils::styleCache.frameToggles - CursesUtils::styleCache.frameCalls);
+
+		if (isUpdating) {
+			if (!WriteFile(filename, frame)) {
+				std::printf("couldn't write %s\n", filename.c_str());
+				return 2;
+			}
+
+			std::printf("written\n");
+			continue;
+		}
+
+		std::string expected;
+		if (!ReadFile(filename, expected)) {
+			std::printf("no golden frame, create it with --update\n");
+			totalMismatches++;
+		} else if (expected != frame) {
+			std::printf("MISMATCH\n");
+			PrintFirstDifference(expected, frame);
+			totalMismatches++;
+		} else {
+			std::printf("ok\n");
+		}
+	}
+
+	BenchmarkMainGame();
+
+	return (totalMismatches == 0) ? 0 : 1;
+}
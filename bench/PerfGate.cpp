@@ -0,0 +1,460 @@
+/*
+ * PerfGate.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ *
+ * Runs the tick, wrapping tick, draw, apple spawn and timer wheel benchmarks several times and compares their medians
+ * against the baseline stored in bench/PerfBaseline.json.
+ * Exits with 1 when any of them got slower than the noise allows, with a report of what regressed.
+ * Build it together with every file in src/ but TextSnake.cpp, and link ncursesw:
+ *
+ *   g++ -std=c++17 -O2 bench/PerfGate.cpp <src files but TextSnake.cpp> -lncursesw -o PerfGate
+ *   ./PerfGate                       compares against bench/PerfBaseline.json
+ *   ./PerfGate --baseline <file>     compares against another baseline
+ *   ./PerfGate --update              measures and writes the baseline instead
+ *
+ * Baselines only mean something on the machine they were measured on, refresh them with --update
+ * whenever the gate moves to another one.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <ncurses.h>
+
+#include "../src/SnakeUtils.h"
+
+using namespace TextSnake;
+
+namespace {
+
+	// Baseline used when none is given.
+	const char* DEFAULT_BASELINE_FILENAME = "bench/PerfBaseline.json";
+
+	// Times each benchmark is measured, the median of them is the one compared.
+	const unsigned int REPETITIONS = 15;
+
+	// Work done per repetition.
+	const unsigned int TICKS_PER_REPETITION = 2000000;
+	const unsigned int FRAMES_PER_REPETITION = 20000;
+	const unsigned int SPAWNS_PER_REPETITION = 200000;
+	const unsigned int TIMER_TICKS_PER_REPETITION = 200000;
+
+	// Timers kept pending while the wheel turns, a tick should cost the same with a few or thousands.
+	const unsigned int PENDING_TIMERS = 10000;
+
+	// Longest delay the timers get scheduled with again.
+	const unsigned int MAX_TIMER_DELAY = 4096;
+
+	// Tail the snake has while spawning apples, a crowded board is the slow case.
+	const std::size_t SPAWN_TAIL_PIECES = 1500;
+
+	// Scale turning a MAD into a standard deviation for normally distributed noise.
+	const double MAD_TO_SIGMA = 1.4826;
+
+	// Deviations of noise a median may move before it counts as a regression.
+	const double NOISE_SIGMAS = 3.0;
+
+	// Smallest slowdown reported, anything below it is lost in run to run noise anyway.
+	const double MIN_RELATIVE_SLOWDOWN = 0.05;
+
+	// Board the benchmarks play on.
+	const int BOARD_WIDTH = 80;
+	const int BOARD_HEIGHT = 24;
+
+	/*
+	 * Measurements of a single benchmark.
+	 */
+	struct BenchResult {
+		const char* name;
+		double median;
+		double mad;
+	};
+
+	/*
+	 * Sets up a game in the middle of a match, on a board with walls or wrapping around.
+	 */
+	void InitGateGame(Game& game, Snake& snake, const bool isWrapModeOn = false) {
+		SeedRandom(game.random, 1);
+		game.level = nullptr;
+		game.scoreSaver = nullptr;
+		game.scoreLoader = nullptr;
+		game.isWrapModeOn = isWrapModeOn;
+		game.layout.generation = 0;
+		game.layout.screenSize.x = BOARD_WIDTH;
+		game.layout.screenSize.y = BOARD_HEIGHT;
+		InitLeaderboard(game.highScores);
+		InitGame(game);
+		UpdateMoveTiming(game, Constants::DEFAULT_CELL_ASPECT_RATIO);
+		InitSnake(snake, game);
+		SpawnApple(game, snake);
+		game.currentState = State::SHOW_MAIN_GAME;
+		UpdateScreen(game);
+	}
+
+	/*
+	 * Steers the snake towards the apple.
+	 */
+	int ChaseApple(const Game& game, const Snake& snake) {
+		if (game.apple.position.x > snake.currentPosition.x)		return static_cast<int>(CursesUtils::ArrowKey::RIGHT);
+		else if (game.apple.position.x < snake.currentPosition.x)	return static_cast<int>(CursesUtils::ArrowKey::LEFT);
+		else if (game.apple.position.y > snake.currentPosition.y)	return static_cast<int>(CursesUtils::ArrowKey::DOWN);
+		else if (game.apple.position.y < snake.currentPosition.y)	return static_cast<int>(CursesUtils::ArrowKey::UP);
+
+		return ERR;
+	}
+
+	/*
+	 * Keeps the match going after the snake ran out of lives.
+	 */
+	void KeepPlaying(Game& game) {
+		if (game.currentState != State::SHOW_MAIN_GAME) {
+			game.lives = Constants::TOTAL_LIVES;
+			game.currentState = State::SHOW_MAIN_GAME;
+			UpdateScreen(game);
+		}
+	}
+
+	/*
+	 * Nanoseconds per headless tick, on a board with walls or wrapping around.
+	 */
+	double MeasureTicks(unsigned long long& checksum, const bool isWrapModeOn) {
+		Game game;
+		Snake snake;
+		InitGateGame(game, snake, isWrapModeOn);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (unsigned int tick = 0; tick < TICKS_PER_REPETITION; tick++) {
+			SimulateTick(game, snake, ChaseApple(game, snake));
+			KeepPlaying(game);
+		}
+
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		checksum += game.currentScore + GetTailLength(snake);
+
+		return elapsed.count() / TICKS_PER_REPETITION;
+	}
+
+	/*
+	 * Nanoseconds per headless tick.
+	 */
+	double MeasureTick(unsigned long long& checksum) {
+		return MeasureTicks(checksum, false);
+	}
+
+	/*
+	 * Nanoseconds per headless tick in wrap mode, which should cost the same as a normal one.
+	 */
+	double MeasureWrap(unsigned long long& checksum) {
+		return MeasureTicks(checksum, true);
+	}
+
+	/*
+	 * Nanoseconds per drawn frame, curses diffing and output included.
+	 */
+	double MeasureDraw(unsigned long long& checksum) {
+		Game game;
+		Snake snake;
+		InitGateGame(game, snake);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (unsigned int frame = 0; frame < FRAMES_PER_REPETITION; frame++) {
+			SimulateTick(game, snake, ChaseApple(game, snake));
+			KeepPlaying(game);
+
+			UpdateScreenCache(game);
+			erase();
+			Draw(game, snake);
+			refresh();
+		}
+
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		checksum += game.currentScore;
+
+		return elapsed.count() / FRAMES_PER_REPETITION;
+	}
+
+	/*
+	 * Nanoseconds per apple spawned next to a long snake.
+	 */
+	double MeasureSpawn(unsigned long long& checksum) {
+		Game game;
+		Snake snake;
+		InitGateGame(game, snake);
+
+		// Lay a long tail over the board, row by row.
+		for (std::size_t i = 0; i < SPAWN_TAIL_PIECES; i++) {
+			TailPiece piece = {};
+			piece.currentPosition.x = Constants::X_MIN + static_cast<int>(i % (BOARD_WIDTH - Constants::X_MIN));
+			piece.currentPosition.y = Constants::Y_MIN + static_cast<int>(i / (BOARD_WIDTH - Constants::X_MIN));
+			piece.previousPosition = piece.currentPosition;
+			PushTailPiece(snake, piece);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (unsigned int spawn = 0; spawn < SPAWNS_PER_REPETITION; spawn++) {
+			game.isAppleOnScreen = false;
+			SpawnApple(game, snake);
+			checksum += game.apple.position.x;
+		}
+
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+		return elapsed.count() / SPAWNS_PER_REPETITION;
+	}
+
+	/*
+	 * Nanoseconds per timer wheel tick with thousands of timers pending, expired ones scheduled again.
+	 */
+	double MeasureTimers(unsigned long long& checksum) {
+		TimerWheel wheel;
+		InitTimerWheel(wheel, PENDING_TIMERS);
+
+		RandomGenerator random;
+		SeedRandom(random, 1);
+
+		for (unsigned int i = 0; i < PENDING_TIMERS; i++)
+			ScheduleTimer(wheel, RandomBelow(random, MAX_TIMER_DELAY) + 1, i, 0);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (unsigned int tick = 0; tick < TIMER_TICKS_PER_REPETITION; tick++) {
+			AdvanceTimers(wheel, [&wheel, &random, &checksum](const uint32_t event, const uint32_t) {
+				checksum += event;
+				ScheduleTimer(wheel, RandomBelow(random, MAX_TIMER_DELAY) + 1, event, 0);
+			});
+		}
+
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+		return elapsed.count() / TIMER_TICKS_PER_REPETITION;
+	}
+
+	/*
+	 * Median of the given samples, they get sorted.
+	 */
+	double Median(std::vector<double>& samples) {
+		std::sort(samples.begin(), samples.end());
+
+		std::size_t middle = samples.size() / 2;
+		if (samples.size() % 2 == 1)
+			return samples[middle];
+
+		return (samples[middle - 1] + samples[middle]) / 2.0;
+	}
+
+	/*
+	 * Runs a benchmark REPETITIONS times and keeps the median and the median absolute deviation.
+	 */
+	BenchResult RunBenchmark(const char* name, double (*measure)(unsigned long long&), unsigned long long& checksum) {
+		std::vector<double> samples;
+		samples.reserve(REPETITIONS);
+
+		// One untimed run to warm the caches up.
+		measure(checksum);
+
+		for (unsigned int i = 0; i < REPETITIONS; i++)
+			samples.push_back(measure(checksum));
+
+		BenchResult result;
+		result.name = name;
+		result.median = Median(samples);
+
+		for (std::size_t i = 0; i < samples.size(); i++)
+			samples[i] = std::fabs(samples[i] - result.median);
+
+		result.mad = Median(samples);
+
+		return result;
+	}
+
+	/*
+	 * Writes the results as the new baseline.
+	 */
+	bool WriteBaseline(const char* filename, const std::vector<BenchResult>& results) {
+		FILE* file = std::fopen(filename, "w");
+		if (file == nullptr)
+			return false;
+
+		std::fprintf(file, "{\n");
+		std::fprintf(file, "\t\"unit\": \"ns\",\n");
+		std::fprintf(file, "\t\"repetitions\": %u,\n", REPETITIONS);
+		std::fprintf(file, "\t\"benchmarks\": {\n");
+
+		for (std::size_t i = 0; i < results.size(); i++) {
+			std::fprintf(file, "\t\t\"%s\": { \"median\": %.3f, \"mad\": %.3f }%s\n",
+			             results[i].name, results[i].median, results[i].mad,
+			             (i + 1 < results.size()) ? "," : "");
+		}
+
+		std::fprintf(file, "\t}\n");
+		std::fprintf(file, "}\n");
+
+		return std::fclose(file) == 0;
+	}
+
+	/*
+	 * Reads the whole baseline file.
+	 */
+	bool ReadFile(const char* filename, std::string& contents) {
+		FILE* file = std::fopen(filename, "r");
+		if (file == nullptr)
+			return false;
+
+		char buffer[4096];
+		std::size_t bytesRead;
+		while ((bytesRead = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+			contents.append(buffer, bytesRead);
+
+		std::fclose(file);
+		return true;
+	}
+
+	/*
+	 * Finds the number stored under the given key, starting the search at the given position.
+	 * Only understands the flat layout WriteBaseline produces.
+	 */
+	bool FindNumber(const std::string& json, std::size_t from, const char* key, double& value) {
+		std::string quotedKey = std::string("\"") + key + "\"";
+
+		std::size_t keyPosition = json.find(quotedKey, from);
+		if (keyPosition == std::string::npos)
+			return false;
+
+		std::size_t colon = json.find(':', keyPosition + quotedKey.size());
+		if (colon == std::string::npos)
+			return false;
+
+		char* end = nullptr;
+		value = std::strtod(json.c_str() + colon + 1, &end);
+
+		return end != json.c_str() + colon + 1;
+	}
+
+	/*
+	 * Finds the baseline of a benchmark.
+	 */
+	bool FindBaseline(const std::string& json, const char* name, BenchResult& baseline) {
+		std::string quotedName = std::string("\"") + name + "\"";
+
+		std::size_t namePosition = json.find(quotedName);
+		if (namePosition == std::string::npos)
+			return false;
+
+		baseline.name = name;
+		return FindNumber(json, namePosition, "median", baseline.median) &&
+		       FindNumber(json, namePosition, "mad", baseline.mad);
+	}
+
+	/*
+	 * Slowest median the current run may have before it counts as a regression.
+	 * The noise of both runs is taken into account, so a noisy machine gets a wider margin.
+	 */
+	double RegressionThreshold(const BenchResult& baseline, const BenchResult& current) {
+		double noise = NOISE_SIGMAS * MAD_TO_SIGMA * std::max(baseline.mad, current.mad);
+		double minimum = MIN_RELATIVE_SLOWDOWN * baseline.median;
+
+		return baseline.median + std::max(noise, minimum);
+	}
+
+}
+
+
+int main(int argc, char* argv[]) {
+	const char* baselineFilename = DEFAULT_BASELINE_FILENAME;
+	bool isUpdating = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--update") == 0)
+			isUpdating = true;
+		else if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+			baselineFilename = argv[++i];
+		else {
+			std::fprintf(stderr, "Usage: %s [--baseline <file>] [--update]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	// Draw to a screen that goes nowhere.
+	FILE* nowhere = std::fopen("/dev/null", "w");
+	SCREEN* screen = newterm("xterm", nowhere, stdin);
+	if (screen == nullptr) {
+		std::fprintf(stderr, "Couldn't open a curses screen.\n");
+		return 2;
+	}
+	InitColors();
+
+	unsigned long long checksum = 0;
+	std::vector<BenchResult> results;
+	results.push_back(RunBenchmark("tick", MeasureTick, checksum));
+	results.push_back(RunBenchmark("wrap", MeasureWrap, checksum));
+	results.push_back(RunBenchmark("draw", MeasureDraw, checksum));
+	results.push_back(RunBenchmark("spawn", MeasureSpawn, checksum));
+	results.push_back(RunBenchmark("timers", MeasureTimers, checksum));
+
+	endwin();
+	delscreen(screen);
+	std::fclose(nowhere);
+
+	if (isUpdating) {
+		if (!WriteBaseline(baselineFilename, results)) {
+			std::fprintf(stderr, "Couldn't write the baseline to %s.\n", baselineFilename);
+			return 2;
+		}
+
+		for (std::size_t i = 0; i < results.size(); i++)
+			std::printf("%-8s %10.2f ns (MAD %.2f)\n", results[i].name, results[i].median, results[i].mad);
+		std::printf("Baseline written to %s (checksum %llu)\n", baselineFilename, checksum);
+
+		return 0;
+	}
+
+	std::string json;
+	if (!ReadFile(baselineFilename, json)) {
+		std::fprintf(stderr, "Couldn't read the baseline %s, create one with --update.\n", baselineFilename);
+		return 2;
+	}
+
+	std::printf("%-8s %12s %12s %9s %12s  %s\n", "bench", "baseline ns", "current ns", "change", "limit ns", "result");
+
+	unsigned int totalRegressions = 0;
+	for (std::size_t i = 0; i < results.size(); i++) {
+		const BenchResult& current = results[i];
+
+		BenchResult baseline;
+		if (!FindBaseline(json, current.name, baseline)) {
+			std::printf("%-8s %12s %12.2f %9s %12s  %s\n", current.name, "-", current.median, "-", "-", "no baseline");
+			continue;
+		}
+
+		double threshold = RegressionThreshold(baseline, current);
+		double change = (current.median - baseline.median) / baseline.median * 100.0;
+		bool isRegression = current.median > threshold;
+
+		if (isRegression)
+			totalRegressions++;
+
+		std::printf("%-8s %12.2f %12.2f %+8.1f%% %12.2f  %s\n",
+		            current.name, baseline.median, current.median, change, threshold,
+		            isRegression ? "REGRESSION" : "ok");
+	}
+
+	if (totalRegressions > 0) {
+		std::printf("%u benchmark(s) got slower than %s allows (checksum %llu)\n", totalRegressions, baselineFilename, checksum);
+		return 1;
+	}
+
+	std::printf("No regressions (checksum %llu)\n", checksum);
+
+	return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * RulesBenchmark.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ *
+ * Compares the in game tick compiled for fixed rules against the same tick
+ * reading its rules from the game at run time.
+ * Build it together with every file in src/ but TextSnake.cpp.
+ */
+
+#include <chrono>
+#include <cstdio>
+
+#include "../src/SnakeUtils.h"
+#include "../src/SnakeRules.h"
+
+using namespace TextSnake;
+
+namespace {
+
+	// Board used by both versions.
+	const int BOARD_WIDTH = 80;
+	const int BOARD_HEIGHT = 24;
+
+	// Ticks simulated per run.
+	const unsigned int TOTAL_TICKS = 20000000;
+
+	// Rules known at compile time.
+	typedef FixedRules<BOARD_WIDTH, BOARD_HEIGHT, true> BenchRules;
+
+	/*
+	 * Sets up a game on the benchmark's board.
+	 */
+	void InitBenchGame(Game& game, Snake& snake) {
+		SeedRandom(game.random, 1);
+		game.level = nullptr;
+		game.scoreSaver = nullptr;
+		game.scoreLoader = nullptr;
+		game.isWrapModeOn = true;
+		InitLeaderboard(game.highScores);
+		InitGame(game);
+
+		game.boardSize.x = BOARD_WIDTH;
+		game.boardSize.y = BOARD_HEIGHT;
+		game.currentState = State::SHOW_MAIN_GAME;
+
+		InitSnake(snake, game);
+		SpawnApple(game, snake);
+	}
+
+	/*
+	 * Runs the given tick over and over, steering the snake around, and returns the nanoseconds per tick.
+	 */
+	template <typename Rules>
+	double RunTicks(unsigned long long& checksum) {
+		Game game;
+		Snake snake;
+		InitBenchGame(game, snake);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (unsigned int tick = 0; tick < TOTAL_TICKS; tick++) {
+			// Turn every now and then so the snake doesn't just go straight.
+			if (tick % 13 == 0)
+				snake.currentDirection = static_cast<Direction>((static_cast<int>(snake.currentDirection) + 1) % 4);
+
+			UpdateMainGame<Rules>(game, snake);
+
+			// Keep playing forever.
+			if (game.currentState != State::SHOW_MAIN_GAME) {
+				game.lives = Constants::TOTAL_LIVES;
+				game.currentState = State::SHOW_MAIN_GAME;
+			}
+		}
+
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+		// Keep the compiler from throwing the work away.
+		checksum += game.currentScore + snake.currentPosition.x + snake.currentPosition.y;
+
+		return elapsed.count() / TOTAL_TICKS;
+	}
+
+}
+
+
+int main() {
+	unsigned long long checksum = 0;
+
+	double runtimeTick = RunTicks<RuntimeRules>(checksum);
+	double fixedTick = RunTicks<BenchRules>(checksum);
+
+	std::printf("%-32s %8.2f ns/tick\n", "RuntimeRules", runtimeTick);
+	std::printf("%-32s %8.2f ns/tick\n", "FixedRules<80, 24, wrapping>", fixedTick);
+	std::printf("speedup: %.2fx (checksum %llu)\n", runtimeTick / fixedTick, checksum);
+
+	return 0;
+}
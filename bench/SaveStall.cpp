@@ -0,0 +1,163 @@
+/*
+ * SaveStall.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ *
+ * Plays game after game with a background score saver stuck on a slow disk, and checks the game loop keeps
+ * ticking while the scores wait their turn: no tick may take longer than a frame, the game over screen included.
+ * Then it stops the saver and checks every score made it to the journal, in fewer writes than there were scores.
+ * Exits with 1 when any of that doesn't hold.
+ * Build it together with every file in src/ but TextSnake.cpp, and link ncursesw and pthreads:
+ *
+ *   g++ -std=c++17 -O2 -pthread bench/SaveStall.cpp <src files but TextSnake.cpp> -lncursesw -o SaveStall
+ *   ./SaveStall
+ *
+ * It writes SaveStall.journal and SaveStall.bin in the current directory, and removes them when it's done.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../src/SnakeUtils.h"
+#include "../src/JournalUtils.h"
+
+using namespace TextSnake;
+
+namespace {
+
+	// Where the scores go.
+	const char* JOURNAL_FILENAME = "SaveStall.journal";
+	const char* SNAPSHOT_FILENAME = "SaveStall.bin";
+	const char* SNAPSHOT_TEMPORARY_FILENAME = "SaveStall.bin.tmp";
+
+	// How long the slow disk takes for every write, longer than a game lasts.
+	const unsigned int SLOW_SAVE_MILLIS = 1000;
+
+	// Games played, each one ends with a score to save.
+	const unsigned int TOTAL_GAMES = 8;
+
+	// The loop runs a tick every millisecond, fast forward compared to the game's but still slow enough
+	// for the writes to overlap a lot of ticks.
+	const std::chrono::milliseconds TICK_PERIOD(1);
+
+	// A small board, the snake runs into its walls in no time.
+	const int BOARD_WIDTH = 20;
+	const int BOARD_HEIGHT = 10;
+
+	// Longest a tick can take without the loop missing a frame.
+	const double FRAME_MILLIS = 1000.0 / Constants::LOOP_FPS;
+
+	/*
+	 * Saves the scores like the game does, after waiting for the slow disk.
+	 */
+	bool SaveSlowly(const std::vector<Score>& scores, const char* journalFilename, const char* snapshotFilename,
+	                const std::size_t compactionSize, const std::size_t maxScores) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(SLOW_SAVE_MILLIS));
+		return AppendScoresToJournal(scores, journalFilename, snapshotFilename, compactionSize, maxScores);
+	}
+
+	/*
+	 * Removes whatever a previous run left behind.
+	 */
+	void RemoveFiles() {
+		unlink(JOURNAL_FILENAME);
+		unlink(SNAPSHOT_FILENAME);
+		unlink(SNAPSHOT_TEMPORARY_FILENAME);
+	}
+
+}
+
+
+int main() {
+	RemoveFiles();
+
+	ScoreSaver saver;
+	StartScoreSaver(saver, JOURNAL_FILENAME, SNAPSHOT_FILENAME, Constants::HIGH_SCORES_COMPACTION_SIZE,
+	                Constants::MAX_HIGH_SCORES, SaveSlowly);
+
+	Game game;
+	Snake snake;
+	SeedRandom(game.random, 1);
+	game.level = nullptr;
+	game.scoreSaver = &saver;
+	game.scoreLoader = nullptr;
+	game.isWrapModeOn = false;
+	game.layout.generation = 0;
+	game.layout.screenSize.x = BOARD_WIDTH;
+	game.layout.screenSize.y = BOARD_HEIGHT;
+	InitLeaderboard(game.highScores);
+	FirstInit(game, snake);
+	InitMenu(game);
+
+	unsigned int totalGames = 0;
+	uint64_t totalTicks = 0;
+	double slowestTick = 0.0;
+	double slowestSavingTick = 0.0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	while (totalGames < TOTAL_GAMES) {
+		// Enter gets through the menu, saves the score on the game over screen and leaves the high scores.
+		// The snake is left alone in game, it goes straight for a wall.
+		// Keys go by the screen being shown, which only catches up with the state on the next tick.
+		bool isSaving = (game.currentScreen == Screen::GAME_OVER);
+		int input = (game.currentScreen == Screen::MAIN_GAME) ? ERR : static_cast<int>(Constants::ENTER_KEY);
+
+		auto tickStart = std::chrono::steady_clock::now();
+		SimulateTick(game, snake, input);
+		std::chrono::duration<double, std::milli> tickTime = std::chrono::steady_clock::now() - tickStart;
+
+		slowestTick = std::max(slowestTick, tickTime.count());
+		if (isSaving) {
+			slowestSavingTick = std::max(slowestSavingTick, tickTime.count());
+			totalGames++;
+		}
+
+		totalTicks++;
+
+		std::this_thread::sleep_until(tickStart + TICK_PERIOD);
+	}
+
+	std::chrono::duration<double, std::milli> playTime = std::chrono::steady_clock::now() - start;
+
+	// Quitting waits for whatever is still queued.
+	auto stopStart = std::chrono::steady_clock::now();
+	StopScoreSaver(saver);
+	std::chrono::duration<double, std::milli> stopTime = std::chrono::steady_clock::now() - stopStart;
+
+	std::vector<Score> savedScores;
+	LoadScoresFromJournal(savedScores, JOURNAL_FILENAME, SNAPSHOT_FILENAME);
+	RemoveFiles();
+
+	std::printf("%u games, %llu ticks in %.1f ms with every write taking %u ms\n", totalGames,
+	            static_cast<unsigned long long>(totalTicks), playTime.count(), SLOW_SAVE_MILLIS);
+	std::printf("slowest tick %.3f ms, slowest game over tick %.3f ms (a frame is %.1f ms)\n",
+	            slowestTick, slowestSavingTick, FRAME_MILLIS);
+	std::printf("stopping took %.1f ms, %llu scores saved in %llu writes, %zu on disk, %llu failed\n", stopTime.count(),
+	            static_cast<unsigned long long>(saver.totalSaved), static_cast<unsigned long long>(saver.totalBatches),
+	            savedScores.size(), static_cast<unsigned long long>(saver.totalFailed));
+
+	bool isOk = true;
+
+	if (slowestTick >= FRAME_MILLIS) {
+		std::printf("FAILED: a tick took longer than a frame\n");
+		isOk = false;
+	}
+
+	if (saver.totalSaved != TOTAL_GAMES || savedScores.size() != TOTAL_GAMES) {
+		std::printf("FAILED: not every score got saved\n");
+		isOk = false;
+	}
+
+	if (saver.totalBatches >= TOTAL_GAMES) {
+		std::printf("FAILED: scores queued together weren't written together\n");
+		isOk = false;
+	}
+
+	return isOk ? 0 : 1;
+}
@@ -0,0 +1,468 @@
+/*
+ * SnakeFuzz.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ *
+ * Throws random inputs at the in game logic and checks that nothing impossible
+ * happens after every single tick:
+ *
+ * - Lives stay between 0 and the starting lives.
+ * - The score never goes down.
+ * - The head is on the board.
+ * - Every tail piece is right next to the piece (or head) before it.
+ * - No two pieces of the snake are on the same cell.
+ * - The apple is on the board, on a free cell.
+ *
+ * It also moves the main menu's selector around and checks exactly one entry is selected.
+ *
+ * When a game breaks one of them, its inputs get shrunk down to as few as still break it
+ * and saved as a replay ("FuzzFailure.replay"), which can be watched with --replay.
+ *
+ * Usage: SnakeFuzz [seconds] [seed]
+ * Build it together with every file in src/ but TextSnake.cpp, and link ncursesw.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <ncurses.h>
+
+#include "../src/SnakeUtils.h"
+#include "../src/SnakeRules.h"
+#include "../src/ReplayUtils.h"
+
+using namespace TextSnake;
+
+namespace {
+
+	// Where a failing game gets saved.
+	const char* FAILURE_REPLAY_FILENAME = "FuzzFailure.replay";
+
+	// Longest game tried, in ticks.
+	const uint32_t MAX_CASE_TICKS = 4096;
+
+	// Board sizes tried.
+	const int MIN_BOARD_WIDTH = 4;
+	const int MAX_BOARD_WIDTH = 40;
+	const int MIN_BOARD_HEIGHT = Constants::Y_MIN + 3;
+	const int MAX_BOARD_HEIGHT = 30;
+
+	// Inputs that steer the snake.
+	const int ARROWS[] = {
+		static_cast<int>(CursesUtils::ArrowKey::UP),
+		static_cast<int>(CursesUtils::ArrowKey::RIGHT),
+		static_cast<int>(CursesUtils::ArrowKey::DOWN),
+		static_cast<int>(CursesUtils::ArrowKey::LEFT)
+	};
+
+	/*
+	 * Everything needed to play the same game again.
+	 */
+	struct FuzzCase {
+		uint64_t seed;
+		Vector2D boardSize;
+		bool isWrapping;
+		bool isOneCellPerTick;
+		std::vector<int> inputs;
+	};
+
+	/*
+	 * How a game went: how many ticks it lasted and the invariant it broke on its last tick, if any.
+	 */
+	struct FuzzResult {
+		const char* invariant;
+		uint32_t ticks;
+	};
+
+	/*
+	 * Sets a new game up the way the case says.
+	 */
+	void SetUpCase(const FuzzCase& fuzzCase, Game& game, Snake& snake) {
+		SeedRandom(game.random, fuzzCase.seed);
+		game.level = nullptr;
+		game.scoreSaver = nullptr;
+		game.scoreLoader = nullptr;
+		game.isWrapModeOn = fuzzCase.isWrapping;
+		game.layout.generation = 0;
+		game.layout.screenSize = fuzzCase.boardSize;
+		InitLeaderboard(game.highScores);
+		InitGame(game);
+
+		UpdateMoveTiming(game, Constants::DEFAULT_CELL_ASPECT_RATIO);
+
+		// Move a cell every tick so more happens per tick.
+		if (fuzzCase.isOneCellPerTick) {
+			game.moveTiming.distancePerFrame = Constants::MOVE_PRECISION;
+			game.moveTiming.horizontalCellCost = Constants::MOVE_PRECISION;
+			game.moveTiming.verticalCellCost = Constants::MOVE_PRECISION;
+		}
+
+		InitSnake(snake, game);
+		SpawnApple(game, snake);
+
+		game.currentState = State::SHOW_MAIN_GAME;
+		UpdateScreen(game);
+	}
+
+	/*
+	 * Tells whether two cells are next to each other, across the borders when the board wraps around.
+	 */
+	bool AreNeighbors(const Game& game, const Vector2D& a, const Vector2D& b) {
+		int dx = std::abs(a.x - b.x);
+		int dy = std::abs(a.y - b.y);
+
+		if (game.rules.isWrapping) {
+			dx = std::min(dx, game.boardSize.x - Constants::X_MIN - dx);
+			dy = std::min(dy, game.boardSize.y - Constants::Y_MIN - dy);
+		}
+
+		return dx + dy == 1;
+	}
+
+	/*
+	 * Tells whether a cell is on the board.
+	 */
+	bool IsOnBoard(const Game& game, const Vector2D& p) {
+		return p.x >= Constants::X_MIN && p.x < game.boardSize.x && p.y >= Constants::Y_MIN && p.y < game.boardSize.y;
+	}
+
+	/*
+	 * Returns the first invariant the game breaks, nullptr when there's none.
+	 * occupied: Scratch grid as big as the board.
+	 */
+	const char* CheckInvariants(const Game& game, const Snake& snake, const unsigned int previousScore,
+	                            std::vector<unsigned char>& occupied) {
+		if (game.lives > Constants::TOTAL_LIVES)
+			return "lives in range";
+
+		if (game.currentScore < previousScore)
+			return "score never goes down";
+
+		// Nothing else to check once the game's over.
+		if (game.currentState != State::SHOW_MAIN_GAME)
+			return nullptr;
+
+		if (!IsOnBoard(game, snake.currentPosition))
+			return "head on the board";
+
+		// Only a snake that was invincible during this life may have moved through its own tail,
+		// it's left tangled until it dies.
+		bool mayOverlap = game.effects.invincibility.index >= 0;
+
+		// Body.
+		occupied.assign(static_cast<std::size_t>(game.boardSize.x) * game.boardSize.y, 0);
+		occupied[snake.currentPosition.y * game.boardSize.x + snake.currentPosition.x] = 1;
+
+		Vector2D previous = snake.currentPosition;
+		for (std::size_t i = 0; i < GetTailLength(snake); i++) {
+			const Vector2D& piece = GetTailPiece(snake, i).currentPosition;
+
+			if (!IsOnBoard(game, piece))
+				return "tail on the board";
+
+			if (!AreNeighbors(game, previous, piece))
+				return "body contiguous";
+
+			unsigned char& cell = occupied[piece.y * game.boardSize.x + piece.x];
+			if (cell && !mayOverlap)
+				return "no overlapping pieces";
+
+			cell++;
+			previous = piece;
+		}
+
+		// The snake's occupancy counts the same pieces, and once its free cells are listed they're the empty ones apples go on.
+		std::size_t totalEmptyAppleCells = 0;
+		for (int y = Constants::Y_MIN; y < game.boardSize.y; y++) {
+			for (int x = Constants::X_MIN; x < game.boardSize.x; x++) {
+				unsigned char count = occupied[y * game.boardSize.x + x];
+				if (CountOccupants(snake.occupancy, x, y) != count)
+					return "occupancy counts the snake";
+
+				if (count == 0 && !RuntimeRules::IsWall(game, x, y) && RuntimeRules::IsAppleZone(game, x, y))
+					totalEmptyAppleCells++;
+			}
+		}
+
+		if (snake.occupancy.isListingFreeCells && snake.occupancy.freeCells.size() - snake.occupancy.totalStaleCells != totalEmptyAppleCells)
+			return "occupancy lists the free cells";
+
+		// Apple.
+		if (game.isAppleOnScreen) {
+			if (!IsOnBoard(game, game.apple.position))
+				return "apple on the board";
+
+			if (occupied[game.apple.position.y * game.boardSize.x + game.apple.position.x])
+				return "apple on a free cell";
+		}
+
+		// Item.
+		if (game.isItemOnScreen) {
+			if (!IsOnBoard(game, game.item.position))
+				return "item on the board";
+
+			if (game.isAppleOnScreen && (game.item.position.x == game.apple.position.x) && (game.item.position.y == game.apple.position.y))
+				return "item not on the apple";
+
+			if (!IsTimerPending(game.timers, game.item.expiryTimer))
+				return "item expires";
+		}
+
+		// The next item, the item on the board and the three effects are all the timers there can be.
+		if (game.timers.totalPending > 5)
+			return "no leaked timers";
+
+		return nullptr;
+	}
+
+	/*
+	 * Picks the input that takes the snake towards the apple, or a random one every now and then.
+	 */
+	int PickChasingInput(RandomGenerator& rng, const Game& game, const Snake& snake) {
+		if (RandomBelow(rng, 8) == 0)
+			return ARROWS[RandomBelow(rng, 4)];
+
+		if (game.apple.position.x > snake.currentPosition.x)	return static_cast<int>(CursesUtils::ArrowKey::RIGHT);
+		if (game.apple.position.x < snake.currentPosition.x)	return static_cast<int>(CursesUtils::ArrowKey::LEFT);
+		if (game.apple.position.y > snake.currentPosition.y)	return static_cast<int>(CursesUtils::ArrowKey::DOWN);
+		if (game.apple.position.y < snake.currentPosition.y)	return static_cast<int>(CursesUtils::ArrowKey::UP);
+
+		return ERR;
+	}
+
+	/*
+	 * Plays a case and returns whether it broke an invariant.
+	 * chaser: When given, the case's inputs get replaced as it goes by ones chasing the apple,
+	 * so the snake grows long. The case keeps them, so it can be played again without a chaser.
+	 */
+	bool RunCase(FuzzCase& fuzzCase, FuzzResult& result, std::vector<unsigned char>& occupied,
+	             RandomGenerator* chaser = nullptr) {
+		Game game;
+		Snake snake;
+		SetUpCase(fuzzCase, game, snake);
+
+		result.invariant = nullptr;
+		result.ticks = 0;
+
+		while (result.ticks < fuzzCase.inputs.size()) {
+			unsigned int previousScore = game.currentScore;
+
+			if (chaser != nullptr)
+				fuzzCase.inputs[result.ticks] = PickChasingInput(*chaser, game, snake);
+
+			SimulateTick(game, snake, fuzzCase.inputs[result.ticks]);
+			result.ticks++;
+
+			result.invariant = CheckInvariants(game, snake, previousScore, occupied);
+			if (result.invariant != nullptr)
+				return true;
+
+			// The case is over with the game.
+			if (game.currentState != State::SHOW_MAIN_GAME)
+				break;
+		}
+
+		return false;
+	}
+
+	/*
+	 * Makes up a random case.
+	 */
+	void MakeCase(RandomGenerator& rng, FuzzCase& fuzzCase) {
+		fuzzCase.seed = (static_cast<uint64_t>(NextRandom(rng)) << 32) | NextRandom(rng);
+		fuzzCase.boardSize.x = MIN_BOARD_WIDTH + static_cast<int>(RandomBelow(rng, MAX_BOARD_WIDTH - MIN_BOARD_WIDTH + 1));
+		fuzzCase.boardSize.y = MIN_BOARD_HEIGHT + static_cast<int>(RandomBelow(rng, MAX_BOARD_HEIGHT - MIN_BOARD_HEIGHT + 1));
+		fuzzCase.isWrapping = RandomBelow(rng, 2) == 0;
+		fuzzCase.isOneCellPerTick = RandomBelow(rng, 4) != 0;
+
+		// Mostly nothing pressed, turning every now and then.
+		fuzzCase.inputs.resize(1 + RandomBelow(rng, MAX_CASE_TICKS));
+		for (std::size_t i = 0; i < fuzzCase.inputs.size(); i++)
+			fuzzCase.inputs[i] = (RandomBelow(rng, 4) == 0) ? ARROWS[RandomBelow(rng, 4)] : ERR;
+	}
+
+	/*
+	 * Shrinks a failing case to as few ticks and inputs as still break the same invariant.
+	 */
+	void ShrinkCase(FuzzCase& fuzzCase, FuzzResult& failure, std::vector<unsigned char>& occupied) {
+		const char* invariant = failure.invariant;
+		FuzzResult candidateFailure;
+
+		// Nothing after the failing tick matters.
+		fuzzCase.inputs.resize(failure.ticks);
+
+		bool isShrinking = true;
+		while (isShrinking) {
+			isShrinking = false;
+
+			// Try dropping chunks of ticks, from big chunks to single ticks.
+			for (std::size_t chunk = fuzzCase.inputs.size() / 2; chunk > 0; chunk /= 2) {
+				for (std::size_t start = 0; start + chunk <= fuzzCase.inputs.size(); ) {
+					FuzzCase candidate = fuzzCase;
+					candidate.inputs.erase(candidate.inputs.begin() + start, candidate.inputs.begin() + start + chunk);
+
+					if (!candidate.inputs.empty() && RunCase(candidate, candidateFailure, occupied) &&
+							candidateFailure.invariant == invariant) {
+						candidate.inputs.resize(candidateFailure.ticks);
+						fuzzCase = candidate;
+						failure = candidateFailure;
+						isShrinking = true;
+					} else {
+						start += chunk;
+					}
+				}
+			}
+
+			// Try not pressing anything on ticks that have an input.
+			for (std::size_t i = 0; i < fuzzCase.inputs.size(); i++) {
+				if (fuzzCase.inputs[i] == ERR)
+					continue;
+
+				FuzzCase candidate = fuzzCase;
+				candidate.inputs[i] = ERR;
+
+				if (RunCase(candidate, candidateFailure, occupied) && candidateFailure.invariant == invariant) {
+					candidate.inputs.resize(candidateFailure.ticks);
+					fuzzCase = candidate;
+					failure = candidateFailure;
+					isShrinking = true;
+				}
+			}
+		}
+	}
+
+	/*
+	 * Saves a case as a replay.
+	 */
+	bool SaveCaseReplay(const FuzzCase& fuzzCase, const char* filename) {
+		Game game;
+		Snake snake;
+		SetUpCase(fuzzCase, game, snake);
+
+		ReplayRecorder recorder;
+		recorder.isKeyframeNeeded = false;
+		BeginRecording(recorder, game, snake);
+
+		for (std::size_t tick = 0; tick < fuzzCase.inputs.size(); tick++) {
+			RecordTick(recorder, game, snake, fuzzCase.inputs[tick]);
+			SimulateTick(game, snake, fuzzCase.inputs[tick]);
+		}
+
+		return EndRecording(recorder, filename);
+	}
+
+	/*
+	 * Moves the menu selector around randomly, returns false when it didn't end up with exactly one entry selected.
+	 */
+	bool FuzzMenu(RandomGenerator& rng) {
+		Game game;
+		Snake snake;
+		SeedRandom(game.random, NextRandom(rng));
+		game.level = nullptr;
+		game.scoreSaver = nullptr;
+		game.scoreLoader = nullptr;
+		game.isWrapModeOn = false;
+		game.layout.generation = 0;
+		game.layout.screenSize.x = 80;
+		game.layout.screenSize.y = 24;
+		InitLeaderboard(game.highScores);
+		InitGame(game);
+		InitMenu(game);
+
+		// Some extra entries so the wrapping around gets tried with more than two.
+		std::size_t extraEntries = RandomBelow(rng, 4);
+		for (std::size_t i = 0; i < extraEntries; i++) {
+			MenuEntry entry = game.mainMenuEntries.back();
+			entry.isSelected = false;
+			game.mainMenuEntries.push_back(entry);
+		}
+
+		for (int i = 0; i < 64; i++) {
+			int input = (RandomBelow(rng, 2) == 0) ? static_cast<int>(CursesUtils::ArrowKey::UP) :
+			                                         static_cast<int>(CursesUtils::ArrowKey::DOWN);
+			ApplyInput(input, game, snake);
+			UpdateMainMenu(game);
+
+			std::size_t totalSelected = 0;
+			for (std::size_t e = 0; e < game.mainMenuEntries.size(); e++)
+				totalSelected += game.mainMenuEntries[e].isSelected ? 1 : 0;
+
+			if (totalSelected != 1)
+				return false;
+		}
+
+		return true;
+	}
+
+}
+
+
+int main(int argc, char* argv[]) {
+	double seconds = (argc > 1) ? std::atof(argv[1]) : 10.0;
+	uint64_t seed = (argc > 2) ? std::strtoull(argv[2], nullptr, 0) :
+	                             static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+	RandomGenerator rng;
+	SeedRandom(rng, seed);
+	std::printf("Fuzzing for %.1fs with seed %llu\n", seconds, static_cast<unsigned long long>(seed));
+
+	std::vector<unsigned char> occupied;
+	FuzzCase fuzzCase;
+	FuzzResult result;
+
+	uint64_t totalCases = 0;
+	uint64_t totalTicks = 0;
+	uint64_t totalMenus = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed(0);
+
+	while (elapsed.count() < seconds) {
+		// Menu.
+		if (!FuzzMenu(rng)) {
+			std::printf("FAILED: main menu doesn't have exactly one entry selected\n");
+			return 1;
+		}
+		totalMenus++;
+
+		// Game.
+		MakeCase(rng, fuzzCase);
+		// Half the games chase the apple.
+		RandomGenerator* chaser = (RandomBelow(rng, 2) == 0) ? &rng : nullptr;
+
+		if (RunCase(fuzzCase, result, occupied, chaser)) {
+			std::printf("FAILED: \"%s\" broken at tick %u (board %dx%d%s)\n", result.invariant, result.ticks - 1,
+			            fuzzCase.boardSize.x, fuzzCase.boardSize.y, fuzzCase.isWrapping ? ", wrapping" : "");
+
+			ShrinkCase(fuzzCase, result, occupied);
+
+			std::size_t totalInputs = 0;
+			for (std::size_t i = 0; i < fuzzCase.inputs.size(); i++)
+				totalInputs += (fuzzCase.inputs[i] != ERR) ? 1 : 0;
+
+			std::printf("Shrunk to %zu ticks with %zu inputs (seed %llu)\n", fuzzCase.inputs.size(), totalInputs,
+			            static_cast<unsigned long long>(fuzzCase.seed));
+
+			if (SaveCaseReplay(fuzzCase, FAILURE_REPLAY_FILENAME))
+				std::printf("Saved as %s\n", FAILURE_REPLAY_FILENAME);
+
+			return 1;
+		}
+
+		totalCases++;
+		totalTicks += result.ticks;
+
+		// Don't ask for the time after every single case.
+		if ((totalCases & 63) == 0)
+			elapsed = std::chrono::steady_clock::now() - start;
+	}
+
+	std::printf("%llu games, %llu ticks (%.0f ticks/s), %llu menus, no failures\n",
+	            static_cast<unsigned long long>(totalCases), static_cast<unsigned long long>(totalTicks),
+	            totalTicks / elapsed.count(), static_cast<unsigned long long>(totalMenus));
+
+	return 0;
+}
@@ -0,0 +1,342 @@
+/*
+ * SnakeStress.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ *
+ * Plays a snake of the given length on a board of the given size along a path going through
+ * every cell, until it fills the whole board and wins, and prints how long a tick takes as the
+ * snake grows. A tick should cost the same with a few pieces or with the whole board.
+ * Then it packs the whole board long tail, and checks it walks and unpacks back to the same one.
+ * Exits with 1 when the snake doesn't win, or its tail doesn't come back the same.
+ * Build it together with every file in src/ but TextSnake.cpp, and link ncursesw:
+ *
+ *   g++ -std=c++17 -O2 bench/SnakeStress.cpp <src files but TextSnake.cpp> -lncursesw -o SnakeStress
+ *   ./SnakeStress                        200x126 board, starting 16 cells long
+ *   ./SnakeStress 400 252 50000          400x252 board (100000 cells), starting 50000 cells long
+ *
+ * The path needs an even number of rows or of columns to loop back on itself.
+ * Filling a board takes about a quarter of its cells squared ticks, big boards are better started long.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../src/SnakeUtils.h"
+#include "../src/SnakeRules.h"
+#include "../src/BodyUtils.h"
+
+using namespace TextSnake;
+
+namespace {
+
+	// Board and snake used when none are given.
+	const int DEFAULT_COLUMNS = 200;
+	const int DEFAULT_ROWS = 126;
+	const std::size_t DEFAULT_LENGTH = 16;
+
+	// Lengths are reported in this many groups, from the starting one to the whole board.
+	const unsigned int TOTAL_BUCKETS = 10;
+
+	// Ticks timed together, timing every single one would cost more than the tick itself.
+	const unsigned int TICKS_PER_SAMPLE = 4096;
+
+	/*
+	 * Time spent on the ticks played while the snake was within a range of lengths.
+	 */
+	struct LengthBucket {
+		std::size_t minLength;
+		std::size_t maxLength;
+		uint64_t ticks;
+		double nanos;
+	};
+
+	/*
+	 * Path through every cell of the board, coming back to where it started.
+	 * It goes right along the first row, zigzags down through the other ones leaving the first column
+	 * out, and goes back up the first column. Boards with an odd number of rows get walked transposed.
+	 */
+	struct Path {
+		int columns;
+		int rows;
+		bool isTransposed;
+	};
+
+	/*
+	 * Tells where the path goes from a cell, with the rows being even.
+	 */
+	Direction GetNextDirection(const int columns, const int rows, const int column, const int row) {
+		// First row, to the right and then down.
+		if (row == 0)
+			return (column < columns - 1) ? Direction::RIGHT : Direction::DOWN;
+
+		// Back up the first column.
+		if (column == 0)
+			return Direction::UP;
+
+		// Odd rows go left down to the second column, the last one goes on into the first column.
+		if (row % 2 == 1) {
+			if (column > 1)		return Direction::LEFT;
+			return (row == rows - 1) ? Direction::LEFT : Direction::DOWN;
+		}
+
+		// Even rows go right.
+		return (column < columns - 1) ? Direction::RIGHT : Direction::DOWN;
+	}
+
+	/*
+	 * Tells where the path goes from a cell of the board.
+	 */
+	Direction GetNextDirection(const Path& path, const Vector2D& p) {
+		int column = p.x - Constants::X_MIN;
+		int row = p.y - Constants::Y_MIN;
+
+		if (!path.isTransposed)
+			return GetNextDirection(path.columns, path.rows, column, row);
+
+		// Walk the board with its rows as columns, and turn the direction back.
+		switch (GetNextDirection(path.rows, path.columns, row, column)) {
+			case Direction::UP:		return Direction::LEFT;
+			case Direction::RIGHT:	return Direction::DOWN;
+			case Direction::DOWN:	return Direction::RIGHT;
+			case Direction::LEFT:	return Direction::UP;
+		}
+
+		return Direction::UP;
+	}
+
+	/*
+	 * Returns the cell next to the given one in the given direction.
+	 */
+	Vector2D Step(const Vector2D& p, const Direction direction) {
+		Vector2D next = p;
+
+		switch (direction) {
+			case Direction::UP:		next.y--;	break;
+			case Direction::RIGHT:	next.x++;	break;
+			case Direction::DOWN:	next.y++;	break;
+			case Direction::LEFT:	next.x--;	break;
+		}
+
+		return next;
+	}
+
+	/*
+	 * Sets up a game on the board with the snake lying along the path, its end in the top left corner.
+	 */
+	void InitStressGame(Game& game, Snake& snake, const Path& path, const std::size_t length) {
+		SeedRandom(game.random, 1);
+		game.level = nullptr;
+		game.scoreSaver = nullptr;
+		game.scoreLoader = nullptr;
+		game.isWrapModeOn = false;
+		game.layout.generation = 0;
+		game.layout.screenSize.x = path.columns + Constants::X_MIN;
+		game.layout.screenSize.y = path.rows + Constants::Y_MIN;
+		InitLeaderboard(game.highScores);
+		InitGame(game);
+		InitSnake(snake, game);
+
+		// Walk the path from the corner, the head ends up length - 1 cells along it.
+		std::vector<Vector2D> body(length);
+		body[0].x = Constants::X_MIN;
+		body[0].y = Constants::Y_MIN;
+		for (std::size_t i = 1; i < length; i++)
+			body[i] = Step(body[i - 1], GetNextDirection(path, body[i - 1]));
+
+		snake.currentPosition = body[length - 1];
+		snake.previousPosition = snake.currentPosition;
+		snake.currentDirection = GetNextDirection(path, snake.currentPosition);
+		snake.previousDirection = snake.currentDirection;
+
+		// The tail goes from right behind the head back to the corner.
+		for (std::size_t i = length - 1; i-- > 0;) {
+			TailPiece piece;
+			piece.currentPosition = body[i];
+			piece.previousPosition = body[i];
+			piece.currentDirection = GetNextDirection(path, body[i]);
+			piece.previousDirection = piece.currentDirection;
+			piece.sprite = Constants::SPR_SNAKE_TAIL;
+			piece.color = snake.color;
+			PushTailPiece(snake, piece);
+		}
+
+		// The head moved away from where InitSnake put it.
+		InitOccupancy(snake, game);
+
+		SpawnApple(game, snake);
+		game.currentState = State::SHOW_MAIN_GAME;
+	}
+
+	/*
+	 * Packs the snake's tail, and checks walking it gives the same cells and unpacking it the same tail and cells taken.
+	 * Prints how much smaller the packed tail is and how long each of those took.
+	 * Returns false when anything didn't come back the same.
+	 */
+	bool CheckPackedBody(const Game& game, const Snake& snake) {
+		std::size_t length = GetTailLength(snake);
+
+		auto packStart = std::chrono::steady_clock::now();
+		PackedBody body;
+		bool isPacked = PackBody(snake, game, body);
+		std::chrono::duration<double, std::milli> packTime = std::chrono::steady_clock::now() - packStart;
+
+		if (!isPacked) {
+			std::printf("FAILED: the tail couldn't be packed\n");
+			return false;
+		}
+
+		// Walking it gives every piece's cell, in order.
+		auto walkStart = std::chrono::steady_clock::now();
+		BodyCursor cursor;
+		InitBodyCursor(cursor, body, game);
+
+		bool isSame = true;
+		std::size_t totalCells = 0;
+		Vector2D cell;
+		while (NextBodyCell(cursor, cell)) {
+			const Vector2D& position = GetTailPiece(snake, totalCells).currentPosition;
+			isSame = isSame && (cell.x == position.x) && (cell.y == position.y);
+			totalCells++;
+		}
+		std::chrono::duration<double, std::milli> walkTime = std::chrono::steady_clock::now() - walkStart;
+
+		if (!isSame || totalCells != length) {
+			std::printf("FAILED: walking the packed tail gave other cells\n");
+			return false;
+		}
+
+		// Unpacking it gives back what the rules read, and the same cells taken.
+		Snake unpacked = snake;
+		auto unpackStart = std::chrono::steady_clock::now();
+		UnpackBody(body, game, unpacked);
+		InitOccupancy(unpacked, game);
+		std::chrono::duration<double, std::milli> unpackTime = std::chrono::steady_clock::now() - unpackStart;
+
+		for (std::size_t i = 0; i < length; i++) {
+			const TailPiece& piece = GetTailPiece(snake, i);
+			const TailPiece& unpackedPiece = GetTailPiece(unpacked, i);
+
+			isSame = isSame && (piece.currentPosition.x == unpackedPiece.currentPosition.x) &&
+					(piece.currentPosition.y == unpackedPiece.currentPosition.y) &&
+					(piece.currentDirection == unpackedPiece.currentDirection);
+		}
+
+		if (!isSame || GetTailLength(unpacked) != length || unpacked.occupancy.taken != snake.occupancy.taken) {
+			std::printf("FAILED: unpacking the tail gave another one\n");
+			return false;
+		}
+
+		std::size_t pieceBytes = length * sizeof(TailPiece);
+		std::size_t packedBytes = GetPackedBodySize(body);
+		std::printf("tail of %zu pieces: %zu bytes as pieces, %zu packed (%.0fx smaller, %zu direction runs)\n", length,
+		            pieceBytes, packedBytes, static_cast<double>(pieceBytes) / packedBytes, body.directions.size());
+		std::printf("packed in %.2f ms, walked in %.2f ms, unpacked in %.2f ms\n", packTime.count(), walkTime.count(),
+		            unpackTime.count());
+
+		return true;
+	}
+
+}
+
+
+int main(int argc, char* argv[]) {
+	if (argc != 1 && argc != 3 && argc != 4) {
+		std::fprintf(stderr, "Usage: %s [columns rows [length]]\n", argv[0]);
+		return 2;
+	}
+
+	Path path;
+	path.columns = (argc > 1) ? std::atoi(argv[1]) : DEFAULT_COLUMNS;
+	path.rows = (argc > 2) ? std::atoi(argv[2]) : DEFAULT_ROWS;
+	std::size_t length = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : DEFAULT_LENGTH;
+
+	std::size_t totalCells = static_cast<std::size_t>(path.columns) * path.rows;
+	if (path.columns < 2 || path.rows < 2 || (path.columns % 2 == 1 && path.rows % 2 == 1)) {
+		std::fprintf(stderr, "The board needs at least 2 columns and 2 rows, and an even number of either.\n");
+		return 2;
+	}
+
+	if (length < 1 || length >= totalCells) {
+		std::fprintf(stderr, "The snake has to be at least 1 cell long and shorter than the board.\n");
+		return 2;
+	}
+
+	path.isTransposed = (path.rows % 2 == 1);
+
+	Game game;
+	Snake snake;
+	InitStressGame(game, snake, path, length);
+
+	// Lengths from the starting one to the whole board, split evenly.
+	LengthBucket buckets[TOTAL_BUCKETS];
+	std::size_t lengthRange = totalCells - length + 1;
+	for (unsigned int i = 0; i < TOTAL_BUCKETS; i++) {
+		buckets[i].minLength = length + lengthRange * i / TOTAL_BUCKETS;
+		buckets[i].maxLength = length + lengthRange * (i + 1) / TOTAL_BUCKETS - 1;
+		buckets[i].ticks = 0;
+		buckets[i].nanos = 0.0;
+	}
+
+	std::printf("%dx%d board, %zu cells, starting %zu cells long\n", path.columns, path.rows, totalCells, length);
+
+	uint64_t totalTicks = 0;
+	auto gameStart = std::chrono::steady_clock::now();
+
+	while (game.currentState == State::SHOW_MAIN_GAME) {
+		// The ticks of a sample count towards the length the snake had when it started.
+		std::size_t sampleLength = GetTailLength(snake) + 1;
+		unsigned int bucket = static_cast<unsigned int>((sampleLength - length) * TOTAL_BUCKETS / lengthRange);
+
+		auto sampleStart = std::chrono::steady_clock::now();
+
+		unsigned int sampleTicks = 0;
+		while (sampleTicks < TICKS_PER_SAMPLE && game.currentState == State::SHOW_MAIN_GAME) {
+			// Follow the path, items and effects come and go as usual.
+			Direction direction = GetNextDirection(path, snake.currentPosition);
+			if (direction != snake.currentDirection) {
+				snake.previousDirection = snake.currentDirection;
+				snake.currentDirection = direction;
+			}
+
+			UpdateTimers<RuntimeRules>(game, snake);
+			UpdateMainGame<RuntimeRules>(game, snake);
+			sampleTicks++;
+		}
+
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - sampleStart;
+		buckets[bucket].ticks += sampleTicks;
+		buckets[bucket].nanos += elapsed.count();
+		totalTicks += sampleTicks;
+	}
+
+	std::chrono::duration<double> gameTime = std::chrono::steady_clock::now() - gameStart;
+
+	// How a tick's cost changed along the way.
+	std::printf("%10s %10s %14s %10s\n", "from", "to", "ticks", "ns/tick");
+
+	double fastest = 0.0;
+	double slowest = 0.0;
+	for (unsigned int i = 0; i < TOTAL_BUCKETS; i++) {
+		if (buckets[i].ticks == 0)
+			continue;
+
+		double nanosPerTick = buckets[i].nanos / buckets[i].ticks;
+		std::printf("%10zu %10zu %14llu %10.1f\n", buckets[i].minLength, buckets[i].maxLength,
+		            static_cast<unsigned long long>(buckets[i].ticks), nanosPerTick);
+
+		if (fastest == 0.0 || nanosPerTick < fastest)	fastest = nanosPerTick;
+		if (nanosPerTick > slowest)						slowest = nanosPerTick;
+	}
+
+	std::size_t finalLength = GetTailLength(snake) + 1;
+	std::printf("%s after %llu ticks (%.1f s), %zu cells long, score %u, slowest over fastest %.2fx\n",
+	            game.isWon ? "won" : "LOST", static_cast<unsigned long long>(totalTicks), gameTime.count(),
+	            finalLength, game.currentScore, (fastest > 0.0) ? slowest / fastest : 0.0);
+
+	// The biggest snake there can be, kept as small as it gets.
+	bool isPackedBodyOk = CheckPackedBody(game, snake);
+
+	return (game.isWon && finalLength == totalCells && isPackedBodyOk) ? 0 : 1;
+}
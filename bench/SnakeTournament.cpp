@@ -0,0 +1,474 @@
+/*
+ * SnakeTournament.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ *
+ * Plays the same set of seeded games with each of the given autoplay policies, spread over every core,
+ * and prints how each one did: score, longest snake and ticks survived, with their 95% confidence intervals,
+ * and how far each policy's score is from the first one's, game by game.
+ * The games go through the same in game logic as the real thing, only the inputs come from the policies.
+ * Build it together with every file in src/ but TextSnake.cpp, and link ncursesw and pthreads:
+ *
+ *   g++ -std=c++17 -O2 -pthread bench/SnakeTournament.cpp <src files but TextSnake.cpp> -lncursesw -o SnakeTournament
+ *   ./SnakeTournament                                  every policy, 2000 games each
+ *   ./SnakeTournament --games 10000 greedy cautious    only the given policies
+ *   ./SnakeTournament --wrap --threads 4 --seed 7      on a wrapping board, 4 threads, seeds from 7 on
+ *
+ * Game n of every policy is played with the seed n after the first one, so the policies face the exact same
+ * apples and items as long as they eat them in the same order. Results don't depend on the number of threads.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../src/SnakeUtils.h"
+#include "../src/SnakeRules.h"
+
+using namespace TextSnake;
+
+namespace {
+
+	// Games played per policy when not told otherwise.
+	const unsigned int DEFAULT_GAMES = 2000;
+
+	// First seed played when not told otherwise.
+	const uint64_t DEFAULT_FIRST_SEED = 1;
+
+	// Board every game is played on, the size of a classic terminal.
+	const int BOARD_WIDTH = 80;
+	const int BOARD_HEIGHT = 24;
+
+	// Games still going after this many ticks (a bit over 5 minutes of play) get stopped there.
+	const uint32_t MAX_GAME_TICKS = 20000;
+
+	// Random stream the policies draw from, apart from the game's own.
+	const uint64_t POLICY_RANDOM_STREAM = 0x706f6c696379ULL;
+
+	// Normal quantile for 95% confidence intervals, plenty of games are played for it to hold.
+	const double CONFIDENCE_Z = 1.959964;
+
+	/*
+	 * Picks the input for the coming tick.
+	 * random: Generator of its own, seeded the same for every policy.
+	 */
+	typedef int (*ChooseInput)(const Game& game, const Snake& snake, RandomGenerator& random);
+
+	/*
+	 * An autoplay strategy entered in the tournament.
+	 */
+	struct Policy {
+		const char* name;
+		const char* description;
+		ChooseInput choose;
+	};
+
+	/*
+	 * How a single game went.
+	 */
+	struct GameResult {
+		double score;
+		double maxLength;
+		double ticks;
+		bool isOver;
+	};
+
+	/*
+	 * Mean and 95% confidence interval of a sample, along with a few of its percentiles.
+	 */
+	struct Summary {
+		double mean;
+		double margin;
+		double p10;
+		double median;
+		double p90;
+	};
+
+	const Direction DIRECTIONS[] = { Direction::UP, Direction::RIGHT, Direction::DOWN, Direction::LEFT };
+
+	/*
+	 * Returns the arrow key that steers the snake towards the given direction.
+	 */
+	int ToInput(const Direction direction) {
+		switch (direction) {
+			case Direction::UP:		return static_cast<int>(CursesUtils::ArrowKey::UP);
+			case Direction::RIGHT:	return static_cast<int>(CursesUtils::ArrowKey::RIGHT);
+			case Direction::DOWN:	return static_cast<int>(CursesUtils::ArrowKey::DOWN);
+			case Direction::LEFT:	return static_cast<int>(CursesUtils::ArrowKey::LEFT);
+		}
+
+		return ERR;
+	}
+
+	/*
+	 * Returns the direction going back the other way.
+	 */
+	Direction Reverse(const Direction direction) {
+		switch (direction) {
+			case Direction::UP:		return Direction::DOWN;
+			case Direction::RIGHT:	return Direction::LEFT;
+			case Direction::DOWN:	return Direction::UP;
+			case Direction::LEFT:	return Direction::RIGHT;
+		}
+
+		return direction;
+	}
+
+	/*
+	 * Returns the direction the head went through to get to its cell.
+	 * It takes a few ticks to cross a cell, the snake may have been steered a few times since.
+	 */
+	Direction GetLastMove(const Snake& snake) {
+		int dx = snake.currentPosition.x - snake.previousPosition.x;
+		int dy = snake.currentPosition.y - snake.previousPosition.y;
+
+		// Steps of more than a cell went across a border.
+		if (dx == 1 || dx < -1)		return Direction::RIGHT;
+		if (dx == -1 || dx > 1)		return Direction::LEFT;
+		if (dy == 1 || dy < -1)		return Direction::DOWN;
+		if (dy == -1 || dy > 1)		return Direction::UP;
+
+		// It hasn't moved since it got put on the board.
+		return snake.currentDirection;
+	}
+
+	/*
+	 * Returns the cell next to the head in the given direction, across the borders when the board wraps around.
+	 */
+	Vector2D GetNextCell(const Game& game, const Snake& snake, const Direction direction) {
+		Vector2D next = snake.currentPosition;
+
+		switch (direction) {
+			case Direction::UP:		next.y--;	break;
+			case Direction::RIGHT:	next.x++;	break;
+			case Direction::DOWN:	next.y++;	break;
+			case Direction::LEFT:	next.x--;	break;
+		}
+
+		if (RuntimeRules::IsWrapping(game)) {
+			next.x = RuntimeRules::WrapColumn(game, next.x - Constants::X_MIN) + Constants::X_MIN;
+			next.y = RuntimeRules::WrapRow(game, next.y - Constants::Y_MIN) + Constants::Y_MIN;
+		}
+
+		return next;
+	}
+
+	/*
+	 * Tells whether moving into the cell would cost a life.
+	 */
+	bool IsDeadly(const Game& game, const Snake& snake, const Vector2D& p) {
+		if (p.x < Constants::X_MIN || p.x >= game.boardSize.x || p.y < Constants::Y_MIN || p.y >= game.boardSize.y)
+			return true;
+
+		return RuntimeRules::IsWall(game, p.x, p.y) || CountOccupants(snake.occupancy, p.x, p.y) > 0;
+	}
+
+	/*
+	 * Returns how many moves it takes to get from a cell to another, across the borders when the board wraps around.
+	 */
+	int GetDistance(const Game& game, const Vector2D& a, const Vector2D& b) {
+		int dx = std::abs(a.x - b.x);
+		int dy = std::abs(a.y - b.y);
+
+		if (RuntimeRules::IsWrapping(game)) {
+			dx = std::min(dx, game.boardSize.x - Constants::X_MIN - dx);
+			dy = std::min(dy, game.boardSize.y - Constants::Y_MIN - dy);
+		}
+
+		return dx + dy;
+	}
+
+	/*
+	 * Mashes the arrow keys, now and then.
+	 */
+	int ChooseRandom(const Game&, const Snake&, RandomGenerator& random) {
+		if (RandomBelow(random, 8) != 0)
+			return ERR;
+
+		return ToInput(DIRECTIONS[RandomBelow(random, 4)]);
+	}
+
+	/*
+	 * Heads straight for the apple, whatever is in the way.
+	 */
+	int ChooseGreedy(const Game& game, const Snake& snake, RandomGenerator&) {
+		Direction back = Reverse(GetLastMove(snake));
+		Direction best = snake.currentDirection;
+		int bestDistance = -1;
+
+		for (Direction direction : DIRECTIONS) {
+			if (direction == back)
+				continue;
+
+			int distance = GetDistance(game, GetNextCell(game, snake, direction), game.apple.position);
+			if (bestDistance < 0 || distance < bestDistance) {
+				best = direction;
+				bestDistance = distance;
+			}
+		}
+
+		return ToInput(best);
+	}
+
+	/*
+	 * Heads for the apple too, but never into a wall or the tail when there's any other way.
+	 */
+	int ChooseCautious(const Game& game, const Snake& snake, RandomGenerator& random) {
+		Direction back = Reverse(GetLastMove(snake));
+		Direction best = snake.currentDirection;
+		int bestDistance = -1;
+
+		// Ties get broken at random, or the snake would always curl up the same way.
+		uint32_t offset = RandomBelow(random, 4);
+		for (uint32_t i = 0; i < 4; i++) {
+			Direction direction = DIRECTIONS[(offset + i) % 4];
+			if (direction == back)
+				continue;
+
+			Vector2D next = GetNextCell(game, snake, direction);
+			if (IsDeadly(game, snake, next))
+				continue;
+
+			int distance = GetDistance(game, next, game.apple.position);
+			if (bestDistance < 0 || distance < bestDistance) {
+				best = direction;
+				bestDistance = distance;
+			}
+		}
+
+		return ToInput(best);
+	}
+
+	// Every policy there is, in the order they get played when none are picked.
+	const Policy POLICIES[] = {
+		{ "random", "random arrow keys every now and then", ChooseRandom },
+		{ "greedy", "straight for the apple", ChooseGreedy },
+		{ "cautious", "for the apple, around walls and the tail", ChooseCautious }
+	};
+
+	/*
+	 * Returns the policy with the given name, nullptr when there's none.
+	 */
+	const Policy* FindPolicy(const char* name) {
+		for (const Policy& policy : POLICIES) {
+			if (std::strcmp(policy.name, name) == 0)
+				return &policy;
+		}
+
+		return nullptr;
+	}
+
+	/*
+	 * Plays a whole game with the policy at the controls, until it's over or runs out of time.
+	 */
+	GameResult PlayGame(const Policy& policy, const uint64_t seed, const bool isWrapModeOn) {
+		Game game;
+		Snake snake;
+
+		SeedRandom(game.random, seed);
+		game.level = nullptr;
+		game.scoreSaver = nullptr;
+		game.scoreLoader = nullptr;
+		game.isWrapModeOn = isWrapModeOn;
+		game.layout.generation = 0;
+		game.layout.screenSize.x = BOARD_WIDTH;
+		game.layout.screenSize.y = BOARD_HEIGHT;
+		InitLeaderboard(game.highScores);
+		InitGame(game);
+		UpdateMoveTiming(game, Constants::DEFAULT_CELL_ASPECT_RATIO);
+		InitSnake(snake, game);
+		SpawnApple(game, snake);
+		game.currentState = State::SHOW_MAIN_GAME;
+		UpdateScreen(game);
+
+		RandomGenerator random;
+		SeedRandom(random, seed, POLICY_RANDOM_STREAM);
+
+		GameResult result;
+		result.maxLength = 1.0;
+
+		uint32_t tick = 0;
+		while (tick < MAX_GAME_TICKS && game.currentState == State::SHOW_MAIN_GAME) {
+			SimulateTick(game, snake, policy.choose(game, snake, random));
+			tick++;
+
+			// Losing a life takes the tail away, the longest the snake ever got is what counts.
+			result.maxLength = std::max(result.maxLength, static_cast<double>(GetTailLength(snake) + 1));
+		}
+
+		result.score = game.currentScore;
+		result.ticks = tick;
+		result.isOver = (game.currentState != State::SHOW_MAIN_GAME);
+
+		return result;
+	}
+
+	/*
+	 * Returns the value at the given fraction of a sorted sample.
+	 */
+	double GetPercentile(const std::vector<double>& sorted, const double fraction) {
+		std::size_t index = static_cast<std::size_t>(fraction * (sorted.size() - 1) + 0.5);
+		return sorted[index];
+	}
+
+	/*
+	 * Sums a sample up.
+	 */
+	Summary Summarize(std::vector<double> values) {
+		Summary summary;
+		std::size_t n = values.size();
+
+		double sum = 0.0;
+		for (double value : values)
+			sum += value;
+		summary.mean = sum / n;
+
+		double squares = 0.0;
+		for (double value : values)
+			squares += (value - summary.mean) * (value - summary.mean);
+
+		// Sample standard deviation, over the square root of the games.
+		double standardError = (n > 1) ? std::sqrt(squares / (n - 1)) / std::sqrt(static_cast<double>(n)) : 0.0;
+		summary.margin = CONFIDENCE_Z * standardError;
+
+		std::sort(values.begin(), values.end());
+		summary.p10 = GetPercentile(values, 0.1);
+		summary.median = GetPercentile(values, 0.5);
+		summary.p90 = GetPercentile(values, 0.9);
+
+		return summary;
+	}
+
+	/*
+	 * Prints a line of the report.
+	 */
+	void PrintSummary(const char* policyName, const char* what, const Summary& summary) {
+		std::printf("%-10s %-8s %12.1f %10.1f %12.1f %12.1f %12.1f\n", policyName, what, summary.mean, summary.margin,
+		            summary.p10, summary.median, summary.p90);
+	}
+
+}
+
+
+int main(int argc, char* argv[]) {
+	unsigned int totalGames = DEFAULT_GAMES;
+	unsigned int totalThreads = std::max(1u, std::thread::hardware_concurrency());
+	uint64_t firstSeed = DEFAULT_FIRST_SEED;
+	bool isWrapModeOn = false;
+	std::vector<const Policy*> policies;
+
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = (i + 1 < argc);
+
+		if (std::strcmp(argv[i], "--games") == 0 && hasValue) {
+			totalGames = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		} else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+			totalThreads = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		} else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+			firstSeed = std::strtoull(argv[++i], nullptr, 0);
+		} else if (std::strcmp(argv[i], "--wrap") == 0) {
+			isWrapModeOn = true;
+		} else if (const Policy* policy = FindPolicy(argv[i])) {
+			policies.push_back(policy);
+		} else {
+			std::fprintf(stderr, "Usage: %s [--games <n>] [--threads <n>] [--seed <n>] [--wrap] [policy...]\n", argv[0]);
+			std::fprintf(stderr, "Policies:\n");
+			for (const Policy& policy : POLICIES)
+				std::fprintf(stderr, "  %-10s %s\n", policy.name, policy.description);
+			return 2;
+		}
+	}
+
+	if (totalGames < 2 || totalThreads < 1) {
+		std::fprintf(stderr, "At least 2 games and 1 thread are needed.\n");
+		return 2;
+	}
+
+	// No policy picked means every one of them.
+	if (policies.empty()) {
+		for (const Policy& policy : POLICIES)
+			policies.push_back(&policy);
+	}
+
+	std::printf("%zu policies, %u games each on a %dx%d board%s, seeds %llu to %llu, %u threads\n",
+	            policies.size(), totalGames, BOARD_WIDTH, BOARD_HEIGHT, isWrapModeOn ? " wrapping around" : "",
+	            static_cast<unsigned long long>(firstSeed), static_cast<unsigned long long>(firstSeed + totalGames - 1),
+	            totalThreads);
+
+	// Every result has its own slot, so the threads never share one and the order they finish in doesn't matter.
+	std::size_t totalMatches = policies.size() * totalGames;
+	std::vector<GameResult> results(totalMatches);
+	std::atomic<std::size_t> nextMatch(0);
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+	for (unsigned int i = 0; i < totalThreads; i++) {
+		threads.emplace_back([&]() {
+			// Grab matches one at a time, games can last a few ticks or thousands of them.
+			for (std::size_t match = nextMatch++; match < totalMatches; match = nextMatch++) {
+				const Policy& policy = *policies[match / totalGames];
+				results[match] = PlayGame(policy, firstSeed + match % totalGames, isWrapModeOn);
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	double totalTicks = 0.0;
+	for (const GameResult& result : results)
+		totalTicks += result.ticks;
+
+	std::printf("%.0f ticks in %.2f s (%.1f M ticks/s)\n\n", totalTicks, elapsed.count(), totalTicks / elapsed.count() / 1e6);
+	std::printf("%-10s %-8s %12s %10s %12s %12s %12s\n", "policy", "", "mean", "+/- 95%", "p10", "median", "p90");
+
+	for (std::size_t p = 0; p < policies.size(); p++) {
+		std::vector<double> scores(totalGames);
+		std::vector<double> lengths(totalGames);
+		std::vector<double> ticks(totalGames);
+		std::vector<double> survivals(totalGames);
+
+		for (unsigned int game = 0; game < totalGames; game++) {
+			const GameResult& result = results[p * totalGames + game];
+			scores[game] = result.score;
+			lengths[game] = result.maxLength;
+			ticks[game] = result.ticks;
+			survivals[game] = result.isOver ? 0.0 : 100.0;
+		}
+
+		PrintSummary(policies[p]->name, "score", Summarize(scores));
+		PrintSummary("", "length", Summarize(lengths));
+		PrintSummary("", "ticks", Summarize(ticks));
+
+		Summary survival = Summarize(survivals);
+		std::printf("%-10s %-8s %11.1f%% %9.1f%%\n", "", "alive", survival.mean, survival.margin);
+	}
+
+	// Every policy played the same seeds, comparing them game by game cancels out how lucky each seed was.
+	if (policies.size() > 1) {
+		std::printf("\nscore against %s, game by game:\n", policies[0]->name);
+
+		for (std::size_t p = 1; p < policies.size(); p++) {
+			std::vector<double> differences(totalGames);
+			for (unsigned int game = 0; game < totalGames; game++)
+				differences[game] = results[p * totalGames + game].score - results[game].score;
+
+			Summary difference = Summarize(differences);
+			bool isSignificant = std::fabs(difference.mean) > difference.margin;
+			std::printf("%-10s %+12.1f +/- %.1f%s\n", policies[p]->name, difference.mean, difference.margin,
+			            isSignificant ? ((difference.mean > 0.0) ? "  better" : "  worse") : "  no clear difference");
+		}
+	}
+
+	return 0;
+}
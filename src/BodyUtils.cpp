@@ -0,0 +1,124 @@
+/*
+ * BodyUtils.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#include "BodyUtils.h"
+
+#include <algorithm>
+
+namespace TextSnake {
+
+	bool PackBody(const Snake& snake, const Game& game, PackedBody& body) {
+		std::size_t length = GetTailLength(snake);
+
+		// A step fewer than there are pieces, four to a byte.
+		// Resizing grows the memory kept from the last packing the way pushing does, instead of to the exact size.
+		body.length = static_cast<uint32_t>(length);
+		body.steps.resize((length + 2) / 4);
+		std::fill(body.steps.begin(), body.steps.end(), 0);
+		body.directions.clear();
+
+		if (length == 0)
+			return true;
+
+		// Steps get found by taking them from the first piece on.
+		body.front = GetTailPiece(snake, 0).currentPosition;
+
+		BodyCursor cursor;
+		InitBodyCursor(cursor, body, game);
+
+		for (std::size_t i = 0; i < length; i++) {
+			const TailPiece& piece = GetTailPiece(snake, i);
+
+			// Only the tail's own looks can be told apart from the snake's.
+			if (piece.sprite != Constants::SPR_SNAKE_TAIL || piece.color != snake.color)
+				return false;
+
+			// Find the step that leads from the piece before to this one.
+			if (i > 0) {
+				unsigned int step = 0;
+				for (; step < 4; step++) {
+					BodyCursor stepped = cursor;
+					StepBodyCursor(stepped, step);
+
+					if (stepped.position.x == piece.currentPosition.x && stepped.position.y == piece.currentPosition.y)
+						break;
+				}
+
+				// It isn't a single cell away from the piece before, or not the way a step goes.
+				if (step == 4)
+					return false;
+
+				StepBodyCursor(cursor, step);
+				body.steps[(i - 1) >> 2] |= static_cast<uint8_t>(step << (((i - 1) & 3) * 2));
+			}
+
+			// A new run starts wherever the direction changes.
+			if (body.directions.empty() || body.directions.back().direction != piece.currentDirection)
+				body.directions.push_back({static_cast<uint32_t>(i), piece.currentDirection});
+		}
+
+		return true;
+	}
+
+
+	void UnpackBody(const PackedBody& body, const Game& game, Snake& snake) {
+		if (snake.tail.size() < body.length)
+			snake.tail.resize(body.length);
+
+		snake.tailFront = 0;
+		snake.tailLength = body.length;
+
+		// Positions and directions first.
+		BodyCursor cursor;
+		InitBodyCursor(cursor, body, game);
+
+		std::size_t run = 0;
+		Vector2D cell;
+		while (NextBodyCell(cursor, cell)) {
+			uint32_t i = cursor.next - 1;
+			if (run + 1 < body.directions.size() && body.directions[run + 1].first == i)
+				run++;
+
+			TailPiece& piece = snake.tail[i];
+			piece.currentPosition = cell;
+			piece.currentDirection = body.directions[run].direction;
+			piece.sprite = Constants::SPR_SNAKE_TAIL;
+			piece.color = snake.color;
+		}
+
+		// Then where every piece came from, which is where the one behind it is now.
+		for (uint32_t i = 0; i + 1 < body.length; i++) {
+			snake.tail[i].previousPosition = snake.tail[i + 1].currentPosition;
+			snake.tail[i].previousDirection = snake.tail[i + 1].currentDirection;
+		}
+
+		// Nothing is behind the last one.
+		if (body.length > 0) {
+			TailPiece& last = snake.tail[body.length - 1];
+			last.previousPosition = last.currentPosition;
+			last.previousDirection = last.currentDirection;
+		}
+	}
+
+
+	std::size_t GetPackedBodySize(const PackedBody& body) {
+		return sizeof(body.front) + sizeof(body.length) + body.steps.size() +
+		       sizeof(uint32_t) + body.directions.size() * sizeof(DirectionRun);
+	}
+
+
+	void InitBodyCursor(BodyCursor& cursor, const PackedBody& body, const Game& game) {
+		cursor.position = body.front;
+		cursor.steps = body.steps.data();
+		cursor.next = 0;
+		cursor.length = body.length;
+		cursor.width = game.boardSize.x - Constants::X_MIN;
+		cursor.height = game.boardSize.y - Constants::Y_MIN;
+		cursor.isWrapping = game.rules.isWrapping;
+	}
+
+} /* namespace TextSnake */
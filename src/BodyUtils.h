@@ -0,0 +1,148 @@
+/*
+ * BodyUtils.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#ifndef BODYUTILS_H_
+#define BODYUTILS_H_
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "SnakeUtils.h"
+#include "SnakeRules.h"
+
+namespace TextSnake {
+
+	/*
+	 * A snake's tail packed for keeping or storing, as small as it gets.
+	 *
+	 * Every piece of the tail is one cell away from the one before it, so after the first piece's position
+	 * each piece only takes the direction of that step: 2 bits, four pieces to a byte, instead of a whole TailPiece.
+	 * A step that goes through a border of a wrapping board comes out on the other side, just like the head does.
+	 * The pieces' directions change only where the snake turned, so they're kept as runs of equal directions.
+	 *
+	 * Packing and unpacking keeps everything the rules read from the tail: every piece's position and direction.
+	 * What they never read comes back the way moving the tail lays it out: a piece's previous position and direction
+	 * are the ones of the piece behind it, and every piece has the tail's sprite and the snake's color.
+	 * Tails that can't be packed that way, like one grown past the border of a wrapping board, just aren't.
+	 */
+
+	/*
+	 * Pieces of the tail, from a given one on, going the same direction.
+	 */
+	struct DirectionRun {
+		uint32_t first;
+		Direction direction;
+	};
+
+	/*
+	 * A packed tail.
+	 * front: Position of the first piece, the one right behind the head.
+	 * length: Pieces in the tail.
+	 * steps: Direction from each piece to the next one, 2 bits each starting from the lowest ones, four to a byte.
+	 * directions: Runs of pieces going the same direction, from the first piece to the last one.
+	 */
+	struct PackedBody {
+		Vector2D front;
+		uint32_t length;
+		std::vector<uint8_t> steps;
+		std::vector<DirectionRun> directions;
+	};
+
+	/*
+	 * Goes through the cells of a packed tail, from the first piece to the last one.
+	 * position: Cell of the piece last returned.
+	 * steps: Steps of the tail.
+	 * next: Index of the next piece.
+	 * length: Pieces in the tail.
+	 * width, height: Size of the board, without the HUD.
+	 * isWrapping: Whether steps go through the borders.
+	 */
+	struct BodyCursor {
+		Vector2D position;
+		const uint8_t* steps;
+		uint32_t next;
+		uint32_t length;
+		int width;
+		int height;
+		bool isWrapping;
+	};
+
+	/*
+	 * Packs the snake's tail.
+	 * snake: Snake whose tail gets packed.
+	 * game: Game the snake is played in, for the board's size and whether it wraps.
+	 * body: Packed tail, it keeps its memory from one packing to the next.
+	 * Returns false when the tail can't be packed without losing what the rules read from it.
+	 */
+	bool PackBody(const Snake& snake, const Game& game, PackedBody& body);
+
+	/*
+	 * Lays a packed tail out in the snake's ring, from its start. The snake's occupancy isn't touched.
+	 * body: Packed tail.
+	 * game: Game the tail was packed in.
+	 * snake: Snake getting the tail, the ring only allocates when it's too small.
+	 */
+	void UnpackBody(const PackedBody& body, const Game& game, Snake& snake);
+
+	/*
+	 * Returns how many bytes the packed tail takes when it's stored.
+	 * body: Packed tail.
+	 */
+	std::size_t GetPackedBodySize(const PackedBody& body);
+
+	/*
+	 * Points a cursor to the first piece of a packed tail.
+	 * cursor: Cursor to initialize.
+	 * body: Packed tail to go through, it has to outlive the cursor.
+	 * game: Game the tail was packed in.
+	 */
+	void InitBodyCursor(BodyCursor& cursor, const PackedBody& body, const Game& game);
+
+	/*
+	 * Moves a cursor's position one cell in the given direction, going through the borders when the board wraps.
+	 * cursor: Cursor to move.
+	 * step: Direction, as stored in the steps.
+	 */
+	inline void StepBodyCursor(BodyCursor& cursor, const unsigned int step) {
+		// Up, right, down and left.
+		static const int STEP_X[4] = {0, 1, 0, -1};
+		static const int STEP_Y[4] = {-1, 0, 1, 0};
+
+		cursor.position.x += STEP_X[step];
+		cursor.position.y += STEP_Y[step];
+
+		if (cursor.isWrapping) {
+			cursor.position.x = WrapCoordinate(cursor.position.x - Constants::X_MIN, cursor.width) + Constants::X_MIN;
+			cursor.position.y = WrapCoordinate(cursor.position.y - Constants::Y_MIN, cursor.height) + Constants::Y_MIN;
+		}
+	}
+
+	/*
+	 * Gives the cell of the next piece.
+	 * cursor: Cursor going through a packed tail.
+	 * cell: Gets the cell.
+	 * Returns false once every piece was given.
+	 */
+	inline bool NextBodyCell(BodyCursor& cursor, Vector2D& cell) {
+		if (cursor.next >= cursor.length)
+			return false;
+
+		// The first piece is where the tail starts, every other one is a step away from the one before it.
+		if (cursor.next > 0) {
+			uint32_t stepIndex = cursor.next - 1;
+			StepBodyCursor(cursor, (cursor.steps[stepIndex >> 2] >> ((stepIndex & 3) * 2)) & 3);
+		}
+
+		cursor.next++;
+		cell = cursor.position;
+		return true;
+	}
+
+} /* namespace TextSnake */
+
+#endif /* BODYUTILS_H_ */
@@ -7,13 +7,270 @@
 
 #include "CursesUtils.h"
 
+#include <clocale>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <langinfo.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+
 namespace CursesUtils {
 
+	VirtualScreen* virtualScreen = nullptr;
+
+	StyleCache styleCache = {};
+
+	namespace {
+
+		// Bytes a terminal gets to clear the whole screen ("\x1b[H\x1b[2J").
+		const unsigned int CLEAR_SCREEN_BYTES = 7;
+
+		// Rough size of the escape sequence switching attributes and colors ("\x1b[0;1;32m").
+		const unsigned int STYLE_CHANGE_BYTES = 8;
+
+		// Set by the signal handler, cleared once the resize is handled.
+		volatile sig_atomic_t isResizePending = 0;
+
+		// The terminal, moved off stdout while curses writes into the relay's pipe. -1 when there's no relay.
+		int terminalFd = -1;
+
+		// Read end of the relay's pipe.
+		int relayFd = -1;
+
+		// Passes curses output on to the terminal.
+		std::thread relayThread;
+
+		// Bytes the relay passed on so far.
+		std::atomic<uint64_t> terminalBytes(0);
+
+		/*
+		 * SIGWINCH handler, it only flags the resize since almost nothing is safe to call in here.
+		 */
+		void OnResizeSignal(int) {
+			isResizePending = 1;
+		}
+
+		/*
+		 * File descriptor of the terminal, to ask it for its size.
+		 */
+		int GetTerminalFd() {
+			return (terminalFd >= 0) ? terminalFd : STDOUT_FILENO;
+		}
+
+		/*
+		 * Writes all of a buffer to a file descriptor.
+		 */
+		bool WriteAll(const int fd, const void* bytes, std::size_t size) {
+			const char* p = static_cast<const char*>(bytes);
+
+			while (size > 0) {
+				ssize_t written = write(fd, p, size);
+				if (written <= 0)
+					return false;
+
+				p += written;
+				size -= written;
+			}
+
+			return true;
+		}
+
+		/*
+		 * Relay thread, counts everything curses writes into the pipe and passes it on to the terminal.
+		 * Runs until the last write end of the pipe gets closed.
+		 */
+		void RelayOutput() {
+			char buffer[4096];
+
+			while (true) {
+				ssize_t bytesRead = read(relayFd, buffer, sizeof(buffer));
+				if (bytesRead <= 0)
+					return;
+
+				terminalBytes.fetch_add(static_cast<uint64_t>(bytesRead), std::memory_order_relaxed);
+
+				// Keep draining the pipe even if the terminal went away, curses would block on it otherwise.
+				WriteAll(terminalFd, buffer, static_cast<std::size_t>(bytesRead));
+			}
+		}
+
+		/*
+		 * Swaps stdout for a pipe read by the relay thread, so curses output can be counted.
+		 * curses writes with write() on the descriptor behind its output FILE, so a FILE that counts what goes
+		 * through it never sees a byte; the descriptor itself has to be swapped.
+		 * Returns false when the output can't be relayed, stdout is left alone then.
+		 */
+		bool StartOutputRelay() {
+			// With stdout on a pipe curses sets the terminal modes and takes the size through stderr,
+			// which only works when it's the very same terminal.
+			struct stat outputStat;
+			struct stat errorStat;
+			if (!isatty(STDOUT_FILENO) || !isatty(STDERR_FILENO) ||
+			    fstat(STDOUT_FILENO, &outputStat) != 0 || fstat(STDERR_FILENO, &errorStat) != 0 ||
+			    outputStat.st_rdev != errorStat.st_rdev)
+				return false;
+
+			int pipeFds[2];
+			if (pipe(pipeFds) != 0)
+				return false;
+
+			terminalFd = dup(STDOUT_FILENO);
+			if (terminalFd < 0) {
+				close(pipeFds[0]);
+				close(pipeFds[1]);
+				return false;
+			}
+
+			// Anything still buffered belongs on the terminal, not in the pipe.
+			std::fflush(stdout);
+			if (dup2(pipeFds[1], STDOUT_FILENO) < 0) {
+				close(pipeFds[0]);
+				close(pipeFds[1]);
+				close(terminalFd);
+				terminalFd = -1;
+				return false;
+			}
+			close(pipeFds[1]);
+
+			relayFd = pipeFds[0];
+			terminalBytes.store(0, std::memory_order_relaxed);
+			relayThread = std::thread(RelayOutput);
+
+			return true;
+		}
+
+		/*
+		 * Puts the terminal back on stdout and waits for the relay to pass on what's left in the pipe.
+		 */
+		void StopOutputRelay() {
+			if (terminalFd < 0)
+				return;
+
+			// Putting the terminal back closes the pipe's last write end, the relay stops once it's drained.
+			std::fflush(stdout);
+			dup2(terminalFd, STDOUT_FILENO);
+			relayThread.join();
+
+			close(relayFd);
+			close(terminalFd);
+			relayFd = -1;
+			terminalFd = -1;
+		}
+
+		/*
+		 * Puts a character with the given style at the virtual screen's cursor and moves the cursor forward,
+		 * wrapping like curses does. Nothing gets drawn outside of the screen.
+		 */
+		void PutVirtualCell(VirtualScreen& screen, const wchar_t character, const short colorPair, const int attributes) {
+			if (screen.cursorX < 0 || screen.cursorY < 0 || screen.cursorX >= screen.columns || screen.cursorY >= screen.rows)
+				return;
+
+			VirtualCell& cell = screen.cells[screen.cursorY * screen.columns + screen.cursorX];
+			cell.character = character;
+			cell.colorPair = colorPair;
+			cell.attributes = attributes;
+			screen.pendingCellsWritten++;
+
+			// The cursor stays in the bottom right corner, since the screen doesn't scroll.
+			if (screen.cursorX + 1 < screen.columns) {
+				screen.cursorX++;
+			} else if (screen.cursorY + 1 < screen.rows) {
+				screen.cursorX = 0;
+				screen.cursorY++;
+			}
+		}
+
+		/*
+		 * Puts a character at the virtual screen's cursor with the screen's style.
+		 */
+		void PrintVirtualChar(VirtualScreen& screen, const char character) {
+			PutVirtualCell(screen, static_cast<unsigned char>(character), screen.colorPair, screen.attributes);
+		}
+
+		/*
+		 * Bytes the character takes in UTF-8.
+		 */
+		unsigned int GetUtf8Length(const wchar_t character) {
+			if (character < 0x80)		return 1;
+			if (character < 0x800)		return 2;
+			if (character < 0x10000)	return 3;
+			return 4;
+		}
+
+		/*
+		 * Appends the character to the string in UTF-8.
+		 */
+		void AppendUtf8(std::string& text, const wchar_t character) {
+			uint32_t code = static_cast<uint32_t>(character);
+
+			switch (GetUtf8Length(character)) {
+				case 1:
+					text += static_cast<char>(code);
+					break;
+				case 2:
+					text += static_cast<char>(0xC0 | (code >> 6));
+					text += static_cast<char>(0x80 | (code & 0x3F));
+					break;
+				case 3:
+					text += static_cast<char>(0xE0 | (code >> 12));
+					text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					text += static_cast<char>(0x80 | (code & 0x3F));
+					break;
+				default:
+					text += static_cast<char>(0xF0 | (code >> 18));
+					text += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+					text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					text += static_cast<char>(0x80 | (code & 0x3F));
+					break;
+			}
+		}
+
+		/*
+		 * Tells whether two cells look the same.
+		 */
+		bool AreCellsEqual(const VirtualCell& a, const VirtualCell& b) {
+			return a.character == b.character && a.colorPair == b.colorPair && a.attributes == b.attributes;
+		}
+
+		/*
+		 * Letter showing a cell's attributes in a dump.
+		 */
+		char GetAttributesLetter(const int attributes) {
+			switch (attributes) {
+				case A_NORMAL:		return '.';
+				case A_STANDOUT:	return 'S';
+				case A_UNDERLINE:	return 'U';
+				case A_REVERSE:		return 'R';
+				case A_BLINK:		return 'K';
+				case A_DIM:			return 'D';
+				case A_BOLD:		return 'B';
+				default:			return '*';
+			}
+		}
+
+	}
+
 	void InitCurses(bool hasColors, bool hasLineBuffering,
 	                bool hasEcho, bool hasKeypad,
-	                bool isDynamic, int cursor) {
-		// Initialize curses screen
-		initscr();
+	                bool isDynamic, int cursor,
+	                bool isCountingOutput) {
+		// Take the character set from the environment, curses only draws wide characters in one that has them.
+		// Just the character set, numbers keep printing the same everywhere.
+		std::setlocale(LC_CTYPE, "");
+
+		// Initialize curses screen, on the relay's pipe when its output gets counted.
+		// It goes straight to the terminal when it can't be relayed.
+		if (!isCountingOutput || !StartOutputRelay() || newterm(nullptr, stdout, stdin) == nullptr) {
+			StopOutputRelay();
+			initscr();
+		}
 
 		// Remove line buffering
 		if (!hasLineBuffering)	raw();
@@ -32,10 +289,93 @@ namespace CursesUtils {
 
 		// Set the usage of colors if possible.
 		if (hasColors && has_colors())	start_color();
+
+		// Curses starts out drawing plain.
+		ResetStyleCache();
+	}
+
+
+	void ShutdownCurses() {
+		// Deallocate curses screen/window
+		endwin();
+
+		StopOutputRelay();
+	}
+
+
+	uint64_t GetTerminalBytes() {
+		return terminalBytes.load(std::memory_order_relaxed);
+	}
+
+
+	bool HasWideCharacters() {
+		return std::strcmp(nl_langinfo(CODESET), "UTF-8") == 0;
+	}
+
+
+	void ResetStyleCache() {
+		styleCache = StyleCache();
+		styleCache.attributes = A_NORMAL;
+		styleCache.appliedAttributes = A_NORMAL;
+	}
+
+
+	void InstallResizeHandler() {
+		struct sigaction action;
+		std::memset(&action, 0, sizeof(action));
+
+		action.sa_handler = OnResizeSignal;
+		sigemptyset(&action.sa_mask);
+		action.sa_flags = SA_RESTART;
+
+		sigaction(SIGWINCH, &action, nullptr);
+	}
+
+
+	bool HandlePendingResize() {
+		// Nothing to do.
+		if (!isResizePending)
+			return false;
+
+		isResizePending = 0;
+
+		// Ask the terminal for its new size and tell curses about it.
+		struct winsize size;
+		if (ioctl(GetTerminalFd(), TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0)
+			resizeterm(size.ws_row, size.ws_col);
+
+		return true;
+	}
+
+
+	float GetCellAspectRatio() {
+		// Ask the terminal for its size in both characters and pixels.
+		struct winsize size;
+		if (ioctl(GetTerminalFd(), TIOCGWINSZ, &size) != 0)
+			return 0.0f;
+
+		// Not every terminal fills in the pixels.
+		if (size.ws_row == 0 || size.ws_col == 0 || size.ws_xpixel == 0 || size.ws_ypixel == 0)
+			return 0.0f;
+
+		float cellWidth = static_cast<float>(size.ws_xpixel) / size.ws_col;
+		float cellHeight = static_cast<float>(size.ws_ypixel) / size.ws_row;
+
+		return cellHeight / cellWidth;
 	}
 
 
 	void PrintCharAtPosition(const char character, const int x, const int y) {
+		ApplyStyle();
+
+		if (virtualScreen != nullptr) {
+			if (x != -1 && y != -1)
+				MoveCursorAtPosition(x, y);
+
+			PrintVirtualChar(*virtualScreen, character);
+			return;
+		}
+
 		// Don't move the cursor if any of the coordinates aren't set.
 		if (x == -1 || y == -1) {
 			addch(character);
@@ -47,7 +387,33 @@ namespace CursesUtils {
 	}
 
 
+	void PrintGlyphAtPosition(const Glyph& glyph, const int x, const int y) {
+		ApplyStyle();
+
+		if (virtualScreen != nullptr) {
+			MoveCursorAtPosition(x, y);
+
+			// Same as curses, the glyph's color pair wins and the attributes add up.
+			short colorPair = (glyph.colorPair != 0) ? glyph.colorPair : virtualScreen->colorPair;
+			PutVirtualCell(*virtualScreen, glyph.character, colorPair, virtualScreen->attributes | glyph.attributes);
+			return;
+		}
+
+		mvadd_wch(y, x, &glyph.cell);
+	}
+
+
 	void PrintStringAtPosition(const char* cString, const int x, const int y) {
+		ApplyStyle();
+
+		if (virtualScreen != nullptr) {
+			if (x != -1 && y != -1)
+				MoveCursorAtPosition(x, y);
+
+			PrintVirtualString(*virtualScreen, cString);
+			return;
+		}
+
 		// Don't move the cursor if any of the coordinates aren't set.
 		if (x == -1 || y == -1) {
 			addstr(cString);
@@ -59,17 +425,148 @@ namespace CursesUtils {
 	}
 
 
-	void ToggleAttribute(Attribute attr, bool isOn) {
-		// Attribute/s is/are set/unset based on the given flag.
-		if (isOn)	attron(static_cast<int>(attr));
-		else		attroff(static_cast<int>(attr));
+	void InitVirtualScreen(VirtualScreen& screen, const int columns, const int rows) {
+		VirtualCell blank = { ' ', 0, A_NORMAL };
+
+		screen.columns = columns;
+		screen.rows = rows;
+		screen.cells.assign(static_cast<std::size_t>(columns) * rows, blank);
+		screen.presented = screen.cells;
+		screen.cursorX = 0;
+		screen.cursorY = 0;
+		screen.colorPair = 0;
+		screen.attributes = A_NORMAL;
+		screen.isFullRepaintPending = false;
+		screen.pendingCellsWritten = 0;
+		screen.frameCellsWritten = 0;
+		screen.frameCellsChanged = 0;
+		screen.frameBytes = 0;
+		screen.totalFrames = 0;
+		screen.totalCellsWritten = 0;
+		screen.totalCellsChanged = 0;
+		screen.totalBytes = 0;
 	}
 
 
-	void ToggleColorPair(const short id, bool isOn) {
-		// Color pair is set/unset based on the given flag.
-		if (isOn)	attron(COLOR_PAIR(id));
-		else		attroff(COLOR_PAIR(id));
+	void PrintVirtualString(VirtualScreen& screen, const char* cString) {
+		for (const char* c = cString; *c != '\0'; c++)
+			PrintVirtualChar(screen, *c);
+	}
+
+
+	void ClearVirtualScreen(VirtualScreen& screen) {
+		VirtualCell blank = { ' ', 0, A_NORMAL };
+		std::fill(screen.cells.begin(), screen.cells.end(), blank);
+
+		screen.cursorX = 0;
+		screen.cursorY = 0;
+
+		// Just like clear(), the next refresh sends everything again.
+		screen.isFullRepaintPending = true;
+	}
+
+
+	void RefreshVirtualScreen(VirtualScreen& screen) {
+		VirtualCell blank = { ' ', 0, A_NORMAL };
+
+		screen.frameCellsWritten = screen.pendingCellsWritten;
+		screen.frameCellsChanged = 0;
+		screen.frameBytes = 0;
+
+		// A full repaint starts from a blank terminal.
+		if (screen.isFullRepaintPending)
+			screen.frameBytes += CLEAR_SCREEN_BYTES;
+
+		// Where the terminal's cursor is and which style it's drawing with, as far as the updates go.
+		int lastX = -2;
+		int lastY = -1;
+		short lastColorPair = 0;
+		int lastAttributes = A_NORMAL;
+
+		for (int y = 0; y < screen.rows; y++) {
+			for (int x = 0; x < screen.columns; x++) {
+				std::size_t i = static_cast<std::size_t>(y) * screen.columns + x;
+				const VirtualCell& cell = screen.cells[i];
+				const VirtualCell& shown = screen.isFullRepaintPending ? blank : screen.presented[i];
+
+				if (AreCellsEqual(cell, shown))
+					continue;
+
+				screen.frameCellsChanged++;
+
+				// Moving the cursor, unless the previous update left it right here.
+				if (y != lastY || x != lastX + 1)
+					screen.frameBytes += std::snprintf(nullptr, 0, "\x1b[%d;%dH", y + 1, x + 1);
+
+				// Switching style.
+				if (cell.colorPair != lastColorPair || cell.attributes != lastAttributes) {
+					screen.frameBytes += STYLE_CHANGE_BYTES;
+					lastColorPair = cell.colorPair;
+					lastAttributes = cell.attributes;
+				}
+
+				// The character itself.
+				screen.frameBytes += GetUtf8Length(cell.character);
+
+				lastX = x;
+				lastY = y;
+			}
+		}
+
+		screen.presented = screen.cells;
+		screen.isFullRepaintPending = false;
+
+		screen.totalFrames++;
+		screen.totalCellsWritten += screen.frameCellsWritten;
+		screen.totalCellsChanged += screen.frameCellsChanged;
+		screen.totalBytes += screen.frameBytes;
+
+		// Start counting the next frame's cells.
+		screen.pendingCellsWritten = 0;
+	}
+
+
+	std::string DumpVirtualScreen(const VirtualScreen& screen) {
+		std::string dump;
+		dump.reserve(static_cast<std::size_t>(screen.columns + 2) * screen.rows * 3 + 64);
+
+		// Characters, every row ends with a bar so trailing blanks show.
+		for (int y = 0; y < screen.rows; y++) {
+			for (int x = 0; x < screen.columns; x++)
+				AppendUtf8(dump, screen.presented[y * screen.columns + x].character);
+			dump += "|\n";
+		}
+
+		// Color pairs, one digit per cell.
+		dump += "pairs:\n";
+		for (int y = 0; y < screen.rows; y++) {
+			for (int x = 0; x < screen.columns; x++) {
+				short pair = screen.presented[y * screen.columns + x].colorPair;
+				dump += (pair == 0) ? '.' : static_cast<char>('0' + (pair % 10));
+			}
+			dump += '\n';
+		}
+
+		// Attributes, one letter per cell.
+		dump += "attributes:\n";
+		for (int y = 0; y < screen.rows; y++) {
+			for (int x = 0; x < screen.columns; x++)
+				dump += GetAttributesLetter(screen.presented[y * screen.columns + x].attributes);
+			dump += '\n';
+		}
+
+		return dump;
+	}
+
+
+	void MakeGlyph(Glyph& glyph, const wchar_t character, const Attribute attr, const short colorPair) {
+		glyph.character = character;
+		glyph.attributes = static_cast<int>(attr);
+		glyph.colorPair = colorPair;
+
+		// The only conversion the glyph ever goes through.
+		wchar_t text[2] = { character, L'\0' };
+		setcchar(&glyph.cell, text, static_cast<attr_t>(attr), colorPair, nullptr);
 	}
 
 }
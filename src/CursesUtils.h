@@ -8,8 +8,16 @@
 #ifndef CURSESUTILS_H_
 #define CURSESUTILS_H_
 
+// Wide characters come from ncursesw, link with -lncursesw.
+#ifndef NCURSES_WIDECHAR
+#define NCURSES_WIDECHAR 1
+#endif
 #include <ncurses.h>
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 namespace CursesUtils {
 
 	/*
@@ -53,6 +61,173 @@ namespace CursesUtils {
 		WHITE = COLOR_WHITE
 	};
 
+	/*
+	 * A character ready to be drawn with its own attributes and color pair, built once and drawn as it is.
+	 * Its style goes on top of the one everything else is drawn with, and its color pair wins unless it's 0.
+	 * cell: What curses draws.
+	 * character: What a virtual screen draws.
+	 * attributes, colorPair: Its own style.
+	 */
+	struct Glyph {
+		cchar_t cell;
+		wchar_t character;
+		int attributes;
+		short colorPair;
+	};
+
+	/*
+	 * A cell of the virtual screen.
+	 */
+	struct VirtualCell {
+		wchar_t character;
+		short colorPair;
+		int attributes;
+	};
+
+	/*
+	 * In memory screen standing in for the terminal, so frames can be looked at and measured without a tty.
+	 * While one is in use, everything below draws to it instead of curses.
+	 * cells: What's been drawn since the last refresh.
+	 * presented: What the last refresh showed.
+	 * isFullRepaintPending: Set by ClearScreen, curses sends the whole screen again on the next refresh after a clear.
+	 * pendingCellsWritten: Cells drawn since the last refresh.
+	 * frameCellsWritten, frameCellsChanged, frameBytes: Cells drawn, cells that ended up different, and an
+	 * estimate of the bytes a terminal would have been sent, during the last frame.
+	 * The totals add every frame up.
+	 */
+	struct VirtualScreen {
+		int columns;
+		int rows;
+		std::vector<VirtualCell> cells;
+		std::vector<VirtualCell> presented;
+		int cursorX;
+		int cursorY;
+		short colorPair;
+		int attributes;
+		bool isFullRepaintPending;
+		unsigned long long pendingCellsWritten;
+		unsigned long long frameCellsWritten;
+		unsigned long long frameCellsChanged;
+		unsigned long long frameBytes;
+		unsigned long long totalFrames;
+		unsigned long long totalCellsWritten;
+		unsigned long long totalCellsChanged;
+		unsigned long long totalBytes;
+	};
+
+	/*
+	 * Virtual screen in use, nullptr when drawing to the terminal.
+	 */
+	extern VirtualScreen* virtualScreen;
+
+	/*
+	 * Attributes and color pair things get drawn with.
+	 * Toggling them only changes what's wanted. It reaches curses (or the virtual screen) right before something
+	 * gets printed, in a single call and only when it's different from what's set already, so turning something
+	 * off and back on between two prints, or on when it already is, never gets to curses.
+	 * attributes, colorPair: What's wanted.
+	 * appliedAttributes, appliedColorPair: What curses has, the virtual screen keeps its own.
+	 * pendingToggles, pendingCalls: Toggles asked for and calls made to curses since the last refresh.
+	 * frameToggles, frameCalls: The same during the last frame, every toggle that didn't need a call got elided.
+	 * The totals add every frame up.
+	 */
+	struct StyleCache {
+		int attributes;
+		short colorPair;
+		int appliedAttributes;
+		short appliedColorPair;
+		unsigned long long pendingToggles;
+		unsigned long long pendingCalls;
+		unsigned long long frameToggles;
+		unsigned long long frameCalls;
+		unsigned long long totalToggles;
+		unsigned long long totalCalls;
+	};
+
+	/*
+	 * Style everything gets drawn with, whether to the terminal or to a virtual screen.
+	 */
+	extern StyleCache styleCache;
+
+	/*
+	 * Goes back to drawing without attributes or colors, as curses does when it starts, and sets every counter to 0.
+	 */
+	void ResetStyleCache();
+
+	/*
+	 * Makes curses, or the virtual screen in use, draw with the wanted style if it doesn't already.
+	 * Everything printing calls it first.
+	 */
+	inline void ApplyStyle() {
+		int& attributes = (virtualScreen != nullptr) ? virtualScreen->attributes : styleCache.appliedAttributes;
+		short& colorPair = (virtualScreen != nullptr) ? virtualScreen->colorPair : styleCache.appliedColorPair;
+
+		if (attributes == styleCache.attributes && colorPair == styleCache.colorPair)
+			return;
+
+		attributes = styleCache.attributes;
+		colorPair = styleCache.colorPair;
+		styleCache.pendingCalls++;
+
+		// Both at once.
+		if (virtualScreen == nullptr)
+			attr_set(static_cast<attr_t>(attributes), colorPair, nullptr);
+	}
+
+	/*
+	 * Ends a frame for the style's counters.
+	 */
+	inline void EndStyleFrame() {
+		styleCache.frameToggles = styleCache.pendingToggles;
+		styleCache.frameCalls = styleCache.pendingCalls;
+		styleCache.totalToggles += styleCache.pendingToggles;
+		styleCache.totalCalls += styleCache.pendingCalls;
+		styleCache.pendingToggles = 0;
+		styleCache.pendingCalls = 0;
+	}
+
+	/*
+	 * Sets a virtual screen up, blank and with every counter at 0.
+	 * screen: Screen to set up.
+	 * columns: Width of the screen.
+	 * rows: Height of the screen.
+	 */
+	void InitVirtualScreen(VirtualScreen& screen, const int columns, const int rows);
+
+	/*
+	 * Draws to the given virtual screen from now on, or to the terminal again when it's nullptr.
+	 * screen: Screen to draw to.
+	 */
+	inline void UseVirtualScreen(VirtualScreen* screen) {
+		virtualScreen = screen;
+	}
+
+	/*
+	 * Prints a string at the virtual screen's cursor, wrapping at the end of the rows like curses does.
+	 * screen: Screen to print to.
+	 * cString: The string to print.
+	 */
+	void PrintVirtualString(VirtualScreen& screen, const char* cString);
+
+	/*
+	 * Blanks the virtual screen out.
+	 * screen: Screen to clear.
+	 */
+	void ClearVirtualScreen(VirtualScreen& screen);
+
+	/*
+	 * Ends a frame on the virtual screen, counting what changed since the previous one.
+	 * screen: Screen to refresh.
+	 */
+	void RefreshVirtualScreen(VirtualScreen& screen);
+
+	/*
+	 * Returns what the virtual screen shows as text: the characters in UTF-8, then the color pairs
+	 * and then the attributes of every cell, each as a grid.
+	 * screen: Screen to dump.
+	 */
+	std::string DumpVirtualScreen(const VirtualScreen& screen);
+
 	/*
 	 * Initializes curses library.
 	 * hasColors: If true, then curses will be set to use colors if possible. False, otherwise.
@@ -65,23 +240,42 @@ namespace CursesUtils {
 	 * isDynamic: If true, curses won't wait for the user to type characters before executing other commands.
 	 * If false, it will be the opposite.
 	 * cursor: 0 for invisible, 1 for normal visibility, 2 for very visible.
+	 * isCountingOutput: If true, curses writes through a pipe so GetTerminalBytes can count its output.
+	 * That only works when stdout and stderr are the same terminal, nothing gets counted otherwise.
 	 */
 	void InitCurses(bool hasColors = false, bool hasLineBuffering = false,
 	                bool hasEcho = false, bool hasKeypad = true,
-	                bool isDynamic = true, int cursor = 0);
+	                bool isDynamic = true, int cursor = 0,
+	                bool isCountingOutput = false);
+
+	/*
+	 * Returns true when the terminal's locale can show characters past ASCII.
+	 * InitCurses has to be called first, it takes the locale from the environment.
+	 */
+	bool HasWideCharacters();
 
 	/*
 	 * Shuts down the curses library.
 	 */
-	inline void ShutdownCurses() {
-		// Deallocate curses screen/window
-		endwin();
-	}
+	void ShutdownCurses();
+
+	/*
+	 * Returns how many bytes curses wrote to the terminal so far.
+	 * Always 0 unless InitCurses was asked to count them.
+	 */
+	uint64_t GetTerminalBytes();
 
 	/*
 	 * Refreshes the screen, so everything can be displayed properly.
 	 */
 	inline void RefreshScreen() {
+		EndStyleFrame();
+
+		if (virtualScreen != nullptr) {
+			RefreshVirtualScreen(*virtualScreen);
+			return;
+		}
+
 		refresh();
 	}
 
@@ -89,20 +283,44 @@ namespace CursesUtils {
 	 * Returns the number of rows on the screen.
 	 */
 	inline int GetRows() {
-		return LINES;
+		return (virtualScreen != nullptr) ? virtualScreen->rows : LINES;
 	}
 
 	/*
 	 * Returns the number of columns on the screen.
 	 */
 	inline int GetColumns() {
-		return COLS;
+		return (virtualScreen != nullptr) ? virtualScreen->columns : COLS;
 	}
 
+	/*
+	 * Catches the terminal's resize signal (SIGWINCH).
+	 * The resize is only flagged by the signal, HandlePendingResize does the actual work.
+	 */
+	void InstallResizeHandler();
+
+	/*
+	 * Resizes curses to the terminal's new size if the terminal was resized since the last call.
+	 * Returns true when a resize happened, GetRows and GetColumns return the new size after that.
+	 */
+	bool HandlePendingResize();
+
+	/*
+	 * Returns the height of a character cell divided by its width,
+	 * or 0 when the terminal doesn't tell the size of its cells.
+	 */
+	float GetCellAspectRatio();
+
 	/*
 	 * Gets the current cursor's position on the screen.
 	 */
 	inline void GetCursorPosition(int& x, int& y) {
+		if (virtualScreen != nullptr) {
+			x = virtualScreen->cursorX;
+			y = virtualScreen->cursorY;
+			return;
+		}
+
 		// Store the x and y position of the cursor in the given variables.
 		getyx(stdscr, y, x);
 	}
@@ -113,6 +331,12 @@ namespace CursesUtils {
 	 * maxY: # of rows.
 	 */
 	inline void GetWindowSize(int& maxX, int& maxY) {
+		if (virtualScreen != nullptr) {
+			maxX = virtualScreen->columns;
+			maxY = virtualScreen->rows;
+			return;
+		}
+
 		// Store the max x and y position of the given window.
 		getmaxyx(stdscr, maxY, maxX);
 	}
@@ -121,6 +345,11 @@ namespace CursesUtils {
 	 * Clears the screen from any output.
 	 */
 	inline void ClearScreen() {
+		if (virtualScreen != nullptr) {
+			ClearVirtualScreen(*virtualScreen);
+			return;
+		}
+
 		clear();
 	}
 
@@ -130,6 +359,12 @@ namespace CursesUtils {
 	 * y: Vertical position on the screen.
 	 */
 	inline void MoveCursorAtPosition(const int x, const int y) {
+		if (virtualScreen != nullptr) {
+			virtualScreen->cursorX = x;
+			virtualScreen->cursorY = y;
+			return;
+		}
+
 		// Set the position of the cursor to the given position.
 		move(y, x);
 	}
@@ -143,6 +378,14 @@ namespace CursesUtils {
 	 */
 	void PrintCharAtPosition(const char character, const int x = -1, const int y = -1);
 
+	/*
+	 * Prints a glyph at the given position, no conversion needed.
+	 * glyph: The glyph to print.
+	 * x: Horizontal position on the screen.
+	 * y: Vertical position on the screen.
+	 */
+	void PrintGlyphAtPosition(const Glyph& glyph, const int x, const int y);
+
 	/*
 	 * Moves the cursor to the given position and prints the given string at that position.
 	 * cString: The string to print.
@@ -159,6 +402,14 @@ namespace CursesUtils {
 	 * y: Vertical position on the screen.
 	 */
 	inline void PrintFormattedAtPosition(const int x, const int y, const char* cString) {
+		ApplyStyle();
+
+		if (virtualScreen != nullptr) {
+			MoveCursorAtPosition(x, y);
+			PrintVirtualString(*virtualScreen, cString);
+			return;
+		}
+
 		// Move the cursor at the given position and print the formatted output.
 		mvprintw(y, x, "%s", cString);
 	}
@@ -168,6 +419,13 @@ namespace CursesUtils {
 	 * cString: The formatted output.
 	 */
 	inline void PrintFormatted(const char* cString) {
+		ApplyStyle();
+
+		if (virtualScreen != nullptr) {
+			PrintVirtualString(*virtualScreen, cString);
+			return;
+		}
+
 		// Print the formatted output.
 		printw("%s", cString);
 	}
@@ -176,7 +434,8 @@ namespace CursesUtils {
 	 * Returns the key pressed on the keyboard.
 	 */
 	inline int GetCharacter() {
-		return getch();
+		// Nobody types on a virtual screen.
+		return (virtualScreen != nullptr) ? ERR : getch();
 	}
 
 	/*
@@ -189,10 +448,26 @@ namespace CursesUtils {
 
 	/*
 	 * Toggles one or more attributes (for more attributes at the same time, bitwise OR is needed).
+	 * It only takes effect on the next print, see StyleCache.
 	 * attr: Attribute or bit mask of attributes to toggle.
 	 * isOn: Should the attribute/s be active or disabled.
 	 */
-	void ToggleAttribute(Attribute attr, bool isOn);
+	inline void ToggleAttribute(Attribute attr, bool isOn) {
+		styleCache.pendingToggles++;
+
+		// Attribute/s is/are set/unset based on the given flag.
+		if (isOn)	styleCache.attributes |= static_cast<int>(attr);
+		else		styleCache.attributes &= ~static_cast<int>(attr);
+	}
+
+	/*
+	 * Builds a glyph.
+	 * glyph: Glyph to build.
+	 * character: Character it shows, anything that takes a single cell.
+	 * attr: Attribute or bit mask of attributes it's drawn with.
+	 * colorPair: Identifier of the color pair it's drawn with, 0 for the current one.
+	 */
+	void MakeGlyph(Glyph& glyph, const wchar_t character, const Attribute attr, const short colorPair);
 
 	/*
 	 * Makes a color pair, which consists of an ID, a foreground and a background color.
@@ -201,6 +476,9 @@ namespace CursesUtils {
 	 * bg: Background color.
 	 */
 	inline void MakeColorPair(const short id, Color fg, Color bg) {
+		// Virtual screens only keep the pairs' ids.
+		if (virtualScreen != nullptr)	return;
+
 		init_pair(id, static_cast<short>(fg), static_cast<short>(bg));
 	}
 
@@ -217,10 +495,17 @@ namespace CursesUtils {
 
 	/*
 	 * Toggles a color pair.
+	 * It only takes effect on the next print, see StyleCache.
 	 * id: Identifier of the pair to toggle on/off.
-	 * isOn: Should the color pair be active or disabled.
+	 * isOn: Should the color pair be active or disabled. Turning off a pair that isn't on does nothing.
 	 */
-	void ToggleColorPair(const short id, bool isOn);
+	inline void ToggleColorPair(const short id, bool isOn) {
+		styleCache.pendingToggles++;
+
+		// Color pair is set/unset based on the given flag.
+		if (isOn)								styleCache.colorPair = id;
+		else if (styleCache.colorPair == id)	styleCache.colorPair = 0;
+	}
 
 }
 
@@ -0,0 +1,116 @@
+/*
+ * GlyphUtils.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#include "GlyphUtils.h"
+
+namespace TextSnake {
+
+	namespace {
+
+		// Color pair a snake glyph gets, it depends on the palette.
+		const short SNAKE_COLOR = -1;
+
+		/*
+		 * How a glyph looks.
+		 * plain: Character on any terminal.
+		 * wide: Character on terminals that show Unicode.
+		 * colorPair: Identifier of its color pair, 0 for the current one or SNAKE_COLOR for the snake's.
+		 */
+		struct GlyphLook {
+			char plain;
+			wchar_t wide;
+			short colorPair;
+		};
+
+		// In the same order as GlyphId.
+		const GlyphLook LOOKS[static_cast<int>(GlyphId::TOTAL)] = {
+			{ Constants::SPR_SNAKE_HEAD, L'\u25B2', SNAKE_COLOR },	// ▲
+			{ Constants::SPR_SNAKE_HEAD, L'\u25BA', SNAKE_COLOR },	// ►
+			{ Constants::SPR_SNAKE_HEAD, L'\u25BC', SNAKE_COLOR },	// ▼
+			{ Constants::SPR_SNAKE_HEAD, L'\u25C4', SNAKE_COLOR },	// ◄
+			{ Constants::SPR_SNAKE_TAIL, L'\u2501', SNAKE_COLOR },	// ━
+			{ Constants::SPR_SNAKE_TAIL, L'\u2503', SNAKE_COLOR },	// ┃
+			{ Constants::SPR_SNAKE_TAIL, L'\u2517', SNAKE_COLOR },	// ┗
+			{ Constants::SPR_SNAKE_TAIL, L'\u251B', SNAKE_COLOR },	// ┛
+			{ Constants::SPR_SNAKE_TAIL, L'\u250F', SNAKE_COLOR },	// ┏
+			{ Constants::SPR_SNAKE_TAIL, L'\u2513', SNAKE_COLOR },	// ┓
+			{ Constants::SPR_SNAKE_TAIL, L'\u2022', SNAKE_COLOR },	// •
+			{ Constants::SPR_APPLE, L'\u25CF', Constants::RED_ON_BLACK_ID },	// ●
+			{ Constants::SPR_BONUS_APPLE, L'\u25C6', Constants::YELLOW_ON_BLACK_ID },	// ◆
+			{ Constants::SPR_SPEED_BOOST, L'\u00BB', Constants::YELLOW_ON_BLACK_ID },	// »
+			{ Constants::SPR_INVINCIBILITY, L'\u271A', Constants::YELLOW_ON_BLACK_ID },	// ✚
+			{ Constants::SPR_HORIZONTAL_WALL, L'\u2500', 0 },	// ─
+			{ Constants::SPR_VERTICAL_WALL, L'\u2502', 0 },	// │
+			{ Constants::SPR_HORIZONTAL_WALL, L'\u250C', 0 },	// ┌
+			{ Constants::SPR_HORIZONTAL_WALL, L'\u2510', 0 },	// ┐
+			{ Constants::SPR_HORIZONTAL_WALL, L'\u2514', 0 },	// └
+			{ Constants::SPR_HORIZONTAL_WALL, L'\u2518', 0 },	// ┘
+			{ Constants::SPR_HORIZONTAL_WRAP, L'\u2504', 0 },	// ┄
+			{ Constants::SPR_VERTICAL_WRAP, L'\u2506', 0 },	// ┆
+			{ Constants::SPR_LEVEL_WALL, L'\u2588', 0 }	// █
+		};
+
+		// The snake's colors in each palette.
+		const short SNAKE_COLORS[static_cast<int>(Palette::TOTAL)] = {
+			Constants::GREEN_ON_BLACK_ID,
+			Constants::YELLOW_ON_BLACK_ID
+		};
+
+		/*
+		 * Returns a table with the plain sprites, the one the game starts out with.
+		 */
+		GlyphTable MakePlainGlyphTable() {
+			GlyphTable table;
+			InitGlyphTable(table, false);
+			return table;
+		}
+
+	} /* namespace */
+
+
+	GlyphTable glyphTable = MakePlainGlyphTable();
+
+
+	void InitGlyphTable(GlyphTable& table, const bool isWide) {
+		table.isWide = isWide;
+
+		// Every glyph gets converted here and never again.
+		for (int palette = 0; palette < static_cast<int>(Palette::TOTAL); palette++) {
+			for (int id = 0; id < static_cast<int>(GlyphId::TOTAL); id++) {
+				const GlyphLook& look = LOOKS[id];
+				wchar_t character = isWide ? look.wide : static_cast<wchar_t>(look.plain);
+				short colorPair = (look.colorPair == SNAKE_COLOR) ? SNAKE_COLORS[palette] : look.colorPair;
+
+				CursesUtils::MakeGlyph(table.glyphs[palette][id], character, CursesUtils::Attribute::NORMAL, colorPair);
+			}
+		}
+
+		const unsigned int UP = 1u << static_cast<int>(Direction::UP);
+		const unsigned int RIGHT = 1u << static_cast<int>(Direction::RIGHT);
+		const unsigned int DOWN = 1u << static_cast<int>(Direction::DOWN);
+		const unsigned int LEFT = 1u << static_cast<int>(Direction::LEFT);
+
+		// A piece joined to nothing, or to more than a body can be, is just a dot.
+		for (unsigned int links = 0; links < 16; links++)
+			table.bodyGlyphs[links] = GlyphId::BODY_LOOSE;
+
+		// Straight lines, the tail's end only has the one neighbour and goes on its way.
+		table.bodyGlyphs[UP] = GlyphId::BODY_VERTICAL;
+		table.bodyGlyphs[DOWN] = GlyphId::BODY_VERTICAL;
+		table.bodyGlyphs[UP | DOWN] = GlyphId::BODY_VERTICAL;
+		table.bodyGlyphs[LEFT] = GlyphId::BODY_HORIZONTAL;
+		table.bodyGlyphs[RIGHT] = GlyphId::BODY_HORIZONTAL;
+		table.bodyGlyphs[LEFT | RIGHT] = GlyphId::BODY_HORIZONTAL;
+
+		// Corners.
+		table.bodyGlyphs[UP | RIGHT] = GlyphId::BODY_UP_RIGHT;
+		table.bodyGlyphs[UP | LEFT] = GlyphId::BODY_UP_LEFT;
+		table.bodyGlyphs[DOWN | RIGHT] = GlyphId::BODY_DOWN_RIGHT;
+		table.bodyGlyphs[DOWN | LEFT] = GlyphId::BODY_DOWN_LEFT;
+	}
+
+} /* namespace TextSnake */
@@ -0,0 +1,118 @@
+/*
+ * GlyphUtils.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#ifndef GLYPHUTILS_H_
+#define GLYPHUTILS_H_
+
+#include "CursesUtils.h"
+#include "SnakeUtils.h"
+
+namespace TextSnake {
+
+	/*
+	 * Everything the board gets drawn with, built once at startup.
+	 *
+	 * Each glyph already carries its character, attributes and color pair, so drawing a cell is picking a glyph
+	 * out of the table and handing it to curses: nothing gets converted or switched while a frame is drawn.
+	 * Terminals that can show Unicode get a head pointing where the snake goes, a body joined up with box drawing
+	 * lines that turn the right way at every corner, and proper corners for the board's frame.
+	 * Any other terminal gets the plain sprites, which is also what the table starts out as.
+	 */
+
+	/*
+	 * What a cell can show. Heads and items go in the same order as Direction and ItemKind.
+	 */
+	enum class GlyphId {
+		HEAD_UP,
+		HEAD_RIGHT,
+		HEAD_DOWN,
+		HEAD_LEFT,
+		BODY_HORIZONTAL,
+		BODY_VERTICAL,
+		BODY_UP_RIGHT,
+		BODY_UP_LEFT,
+		BODY_DOWN_RIGHT,
+		BODY_DOWN_LEFT,
+		BODY_LOOSE,
+		APPLE,
+		BONUS_APPLE,
+		SPEED_BOOST,
+		INVINCIBILITY,
+		FRAME_HORIZONTAL,
+		FRAME_VERTICAL,
+		FRAME_TOP_LEFT,
+		FRAME_TOP_RIGHT,
+		FRAME_BOTTOM_LEFT,
+		FRAME_BOTTOM_RIGHT,
+		WRAP_HORIZONTAL,
+		WRAP_VERTICAL,
+		LEVEL_WALL,
+		TOTAL
+	};
+
+	/*
+	 * Every glyph, in every palette.
+	 * isWide: True when the glyphs go past ASCII.
+	 * glyphs: Glyphs by palette and id.
+	 * bodyGlyphs: Glyph of a body piece by the directions it's joined to its neighbours in, one bit per Direction.
+	 */
+	struct GlyphTable {
+		bool isWide;
+		CursesUtils::Glyph glyphs[static_cast<int>(Palette::TOTAL)][static_cast<int>(GlyphId::TOTAL)];
+		GlyphId bodyGlyphs[16];
+	};
+
+	/*
+	 * The glyphs the game draws with, plain sprites until InitGlyphTable says otherwise.
+	 */
+	extern GlyphTable glyphTable;
+
+	/*
+	 * Builds every glyph.
+	 * table: Table to build.
+	 * isWide: True for Unicode glyphs, false for the plain sprites.
+	 */
+	void InitGlyphTable(GlyphTable& table, const bool isWide);
+
+	/*
+	 * Returns a glyph out of the table.
+	 * table: Table of glyphs.
+	 * palette: Colors to draw with.
+	 * id: Glyph to get.
+	 */
+	inline const CursesUtils::Glyph& GetGlyph(const GlyphTable& table, const Palette palette, const GlyphId id) {
+		return table.glyphs[static_cast<int>(palette)][static_cast<int>(id)];
+	}
+
+	/*
+	 * Returns the bit of the direction leading from a cell to the next one, 0 when they aren't next to each other.
+	 * from: Cell to start from.
+	 * to: Cell to get to.
+	 * isWrapping: True when the board wraps, so cells on opposite borders are next to each other.
+	 */
+	inline unsigned int GetLinkBit(const Vector2D& from, const Vector2D& to, const bool isWrapping) {
+		int dx = to.x - from.x;
+		int dy = to.y - from.y;
+
+		// Going through a border is a single step the other way.
+		if (isWrapping) {
+			if (dx > 1)			dx = -1;
+			else if (dx < -1)	dx = 1;
+			if (dy > 1)			dy = -1;
+			else if (dy < -1)	dy = 1;
+		}
+
+		if (dx == 0 && dy == -1)	return 1u << static_cast<int>(Direction::UP);
+		if (dx == 1 && dy == 0)		return 1u << static_cast<int>(Direction::RIGHT);
+		if (dx == 0 && dy == 1)		return 1u << static_cast<int>(Direction::DOWN);
+		if (dx == -1 && dy == 0)	return 1u << static_cast<int>(Direction::LEFT);
+		return 0;
+	}
+
+} /* namespace TextSnake */
+
+#endif /* GLYPHUTILS_H_ */
@@ -0,0 +1,423 @@
+/*
+ * JournalUtils.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#include "JournalUtils.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+namespace TextSnake {
+
+	namespace {
+
+		// "TSJ1", "TSS1" and "TSSR" in little endian.
+		const uint32_t JOURNAL_MAGIC = 0x314A5354;
+		const uint32_t SNAPSHOT_MAGIC = 0x31535354;
+		const uint32_t RECORD_MAGIC = 0x52535354;
+
+		// Longest name that can be stored.
+		const std::size_t MAX_NAME_LENGTH = 0xFFFF;
+
+		/*
+		 * Beginning of both the journal and the snapshot.
+		 */
+		struct FileHeader {
+			uint32_t magic;
+			uint32_t reserved;
+			uint64_t generation;
+		};
+
+		/*
+		 * Returns the lookup table Crc32 goes through a byte at a time.
+		 */
+		std::array<uint32_t, 256> MakeCrc32Table() {
+			std::array<uint32_t, 256> table;
+
+			for (uint32_t i = 0; i < 256; i++) {
+				uint32_t value = i;
+				for (int bit = 0; bit < 8; bit++)
+					value = (value & 1) ? (0xEDB88320 ^ (value >> 1)) : (value >> 1);
+
+				table[i] = value;
+			}
+
+			return table;
+		}
+
+		/*
+		 * Calculates the CRC-32 of the given bytes.
+		 */
+		uint32_t Crc32(const unsigned char* bytes, const std::size_t size, uint32_t crc = 0) {
+			// Built the first time, the saver's thread and the game's can both get here first.
+			static const std::array<uint32_t, 256> table = MakeCrc32Table();
+
+			crc = ~crc;
+			for (std::size_t i = 0; i < size; i++)
+				crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+
+			return ~crc;
+		}
+
+		/*
+		 * Appends a value to a buffer as it's laid out in memory.
+		 */
+		template <typename T>
+		void AppendValue(std::string& buffer, const T& value) {
+			buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		/*
+		 * Appends a score to a buffer as a record: magic, score, name length, name, checksum.
+		 */
+		void AppendRecord(std::string& buffer, const Score& score) {
+			uint16_t nameLength = static_cast<uint16_t>(std::min(score.name.length(), MAX_NAME_LENGTH));
+
+			AppendValue(buffer, RECORD_MAGIC);
+
+			// The checksum covers everything after the magic.
+			std::size_t checkedStart = buffer.size();
+			AppendValue(buffer, static_cast<uint32_t>(score.score));
+			AppendValue(buffer, nameLength);
+			buffer.append(score.name, 0, nameLength);
+
+			uint32_t crc = Crc32(reinterpret_cast<const unsigned char*>(buffer.data()) + checkedStart,
+			                     buffer.size() - checkedStart);
+			AppendValue(buffer, crc);
+		}
+
+		/*
+		 * Reads every valid record in the buffer, starting at the given offset.
+		 * Whatever doesn't look like a valid record is skipped one byte at a time
+		 * until the next valid one, so a torn write never hides the records after it.
+		 */
+		void ParseRecords(const std::string& buffer, std::size_t offset, std::vector<Score>& scores) {
+			const unsigned char* data = reinterpret_cast<const unsigned char*>(buffer.data());
+			const std::size_t minRecordSize = sizeof(uint32_t) * 3 + sizeof(uint16_t);
+
+			while (offset + minRecordSize <= buffer.size()) {
+				uint32_t magic = 0;
+				uint32_t points = 0;
+				uint16_t nameLength = 0;
+				uint32_t crc = 0;
+
+				std::memcpy(&magic, data + offset, sizeof(magic));
+				std::memcpy(&points, data + offset + 4, sizeof(points));
+				std::memcpy(&nameLength, data + offset + 8, sizeof(nameLength));
+
+				std::size_t recordSize = minRecordSize + nameLength;
+
+				// Check it's a whole and valid record.
+				bool isValid = (magic == RECORD_MAGIC) && (offset + recordSize <= buffer.size());
+				if (isValid) {
+					std::memcpy(&crc, data + offset + recordSize - sizeof(crc), sizeof(crc));
+					isValid = (crc == Crc32(data + offset + 4, recordSize - 8));
+				}
+
+				if (!isValid) {
+					// Look for the next record.
+					offset++;
+					continue;
+				}
+
+				Score score;
+				score.score = points;
+				score.name.assign(buffer, offset + 10, nameLength);
+				scores.push_back(score);
+
+				offset += recordSize;
+			}
+		}
+
+		/*
+		 * Reads a whole file into a buffer.
+		 */
+		bool ReadWholeFile(const int fd, std::string& buffer) {
+			buffer.clear();
+
+			char chunk[4096];
+			off_t offset = 0;
+
+			while (true) {
+				ssize_t bytesRead = pread(fd, chunk, sizeof(chunk), offset);
+
+				if (bytesRead < 0)	return false;
+				if (bytesRead == 0)	return true;
+
+				buffer.append(chunk, bytesRead);
+				offset += bytesRead;
+			}
+		}
+
+		/*
+		 * Writes the whole buffer to a file.
+		 */
+		bool WriteWholeBuffer(const int fd, const std::string& buffer) {
+			std::size_t written = 0;
+
+			while (written < buffer.size()) {
+				ssize_t bytesWritten = write(fd, buffer.data() + written, buffer.size() - written);
+
+				if (bytesWritten < 0)	return false;
+
+				written += bytesWritten;
+			}
+
+			return true;
+		}
+
+		/*
+		 * Reads the header at the beginning of a buffer.
+		 */
+		bool ReadHeader(const std::string& buffer, const uint32_t magic, uint64_t& generation) {
+			if (buffer.size() < sizeof(FileHeader))
+				return false;
+
+			FileHeader header;
+			std::memcpy(&header, buffer.data(), sizeof(header));
+
+			if (header.magic != magic)
+				return false;
+
+			generation = header.generation;
+			return true;
+		}
+
+		/*
+		 * Reads only the header of a file, returns its generation (0 when there's no valid header).
+		 */
+		uint64_t ReadGeneration(const int fd, const uint32_t magic) {
+			FileHeader header;
+
+			if (pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) || header.magic != magic)
+				return 0;
+
+			return header.generation;
+		}
+
+		/*
+		 * Reads the snapshot, returns its generation (0 when there's no valid snapshot).
+		 * scores: Where to put the snapshot's scores, when null only the generation is read.
+		 */
+		uint64_t ReadSnapshot(const char* snapshotFilename, std::vector<Score>* scores) {
+			int fd = open(snapshotFilename, O_RDONLY);
+			if (fd < 0)
+				return 0;
+
+			std::string buffer;
+			uint64_t generation = 0;
+
+			if (!scores)
+				generation = ReadGeneration(fd, SNAPSHOT_MAGIC);
+			else if (ReadWholeFile(fd, buffer) && ReadHeader(buffer, SNAPSHOT_MAGIC, generation))
+				ParseRecords(buffer, sizeof(FileHeader), *scores);
+
+			close(fd);
+			return generation;
+		}
+
+		/*
+		 * Starts an empty journal, one generation after the snapshot's one.
+		 */
+		bool WriteJournalHeader(const int journalFd, const uint64_t generation) {
+			std::string buffer;
+
+			FileHeader header;
+			header.magic = JOURNAL_MAGIC;
+			header.reserved = 0;
+			header.generation = generation;
+			AppendValue(buffer, header);
+
+			return WriteWholeBuffer(journalFd, buffer);
+		}
+
+		/*
+		 * Makes sure the directory holding the given file saved its entries (e.g. after a rename).
+		 */
+		void SyncParentDirectory(const char* filename) {
+			std::string directory(filename);
+			std::size_t slash = directory.find_last_of('/');
+			directory = (slash == std::string::npos) ? "." : directory.substr(0, slash + 1);
+
+			int fd = open(directory.c_str(), O_RDONLY);
+			if (fd < 0)
+				return;
+
+			fsync(fd);
+			close(fd);
+		}
+
+		/*
+		 * Compacts the journal, the caller must be holding the exclusive lock on it.
+		 */
+		bool CompactLocked(const int journalFd, const char* snapshotFilename, const std::size_t maxScores) {
+			std::vector<Score> scores;
+
+			// Snapshot.
+			uint64_t snapshotGeneration = ReadSnapshot(snapshotFilename, &scores);
+
+			// Journal, unless its scores already made it into the snapshot.
+			std::string journal;
+			uint64_t journalGeneration = 0;
+			if (ReadWholeFile(journalFd, journal) && ReadHeader(journal, JOURNAL_MAGIC, journalGeneration) &&
+					journalGeneration > snapshotGeneration)
+				ParseRecords(journal, sizeof(FileHeader), scores);
+
+			// Sort them out in descending order and only keep the best ones.
+			std::stable_sort(scores.begin(), scores.end(),
+			                 [](const Score& a, const Score& b) { return a.score > b.score; });
+			if (scores.size() > maxScores)
+				scores.resize(maxScores);
+
+			// The new snapshot includes the journal's generation.
+			uint64_t newGeneration = std::max(snapshotGeneration, journalGeneration);
+
+			std::string buffer;
+			FileHeader header;
+			header.magic = SNAPSHOT_MAGIC;
+			header.reserved = 0;
+			header.generation = newGeneration;
+			AppendValue(buffer, header);
+
+			for (std::size_t i = 0; i < scores.size(); i++)
+				AppendRecord(buffer, scores[i]);
+
+			// Write it next to the old one and swap them, so there's always a whole snapshot on disk.
+			std::string temporaryFilename = std::string(snapshotFilename) + ".tmp";
+			int snapshotFd = open(temporaryFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (snapshotFd < 0)
+				return false;
+
+			bool isWritten = WriteWholeBuffer(snapshotFd, buffer) && (fsync(snapshotFd) == 0);
+			close(snapshotFd);
+
+			if (!isWritten || rename(temporaryFilename.c_str(), snapshotFilename) != 0) {
+				unlink(temporaryFilename.c_str());
+				return false;
+			}
+
+			SyncParentDirectory(snapshotFilename);
+
+			// Start over with an empty journal.
+			if (ftruncate(journalFd, 0) != 0)
+				return false;
+
+			bool isReset = WriteJournalHeader(journalFd, newGeneration + 1);
+			fdatasync(journalFd);
+
+			return isReset;
+		}
+
+	} /* namespace */
+
+
+	bool AppendScoreToJournal(const Score& score, const char* journalFilename, const char* snapshotFilename,
+	                          const std::size_t compactionSize, const std::size_t maxScores) {
+		return AppendScoresToJournal(std::vector<Score>(1, score), journalFilename, snapshotFilename, compactionSize, maxScores);
+	}
+
+
+	bool AppendScoresToJournal(const std::vector<Score>& scores, const char* journalFilename, const char* snapshotFilename,
+	                           const std::size_t compactionSize, const std::size_t maxScores) {
+		// Nothing to write.
+		if (scores.empty())
+			return true;
+
+		// Open the journal, every write goes to its end.
+		int fd = open(journalFilename, O_RDWR | O_APPEND | O_CREAT, 0644);
+		if (fd < 0)
+			return false;
+
+		// Only one game at a time can write to it.
+		if (flock(fd, LOCK_EX) != 0) {
+			close(fd);
+			return false;
+		}
+
+		struct stat journalStat;
+		bool isSaved = (fstat(fd, &journalStat) == 0);
+
+		// The journal has to come after whatever is in the snapshot. It doesn't when it's brand new,
+		// or when a compaction was interrupted right after replacing the snapshot, in which case
+		// its scores are already in the snapshot and it can start over.
+		uint64_t snapshotGeneration = ReadSnapshot(snapshotFilename, nullptr);
+		if (isSaved && ReadGeneration(fd, JOURNAL_MAGIC) <= snapshotGeneration) {
+			isSaved = (ftruncate(fd, 0) == 0) && WriteJournalHeader(fd, snapshotGeneration + 1);
+			journalStat.st_size = sizeof(FileHeader);
+		}
+
+		// Append the records with a single write and make sure they reach the disk.
+		std::string records;
+		for (std::size_t i = 0; i < scores.size(); i++)
+			AppendRecord(records, scores[i]);
+
+		if (isSaved)
+			isSaved = WriteWholeBuffer(fd, records) && (fdatasync(fd) == 0);
+
+		// Fold the journal into the snapshot every now and then.
+		if (isSaved && static_cast<std::size_t>(journalStat.st_size) + records.size() > compactionSize)
+			CompactLocked(fd, snapshotFilename, maxScores);
+
+		flock(fd, LOCK_UN);
+		close(fd);
+
+		return isSaved;
+	}
+
+
+	void LoadScoresFromJournal(std::vector<Score>& scores, const char* journalFilename, const char* snapshotFilename) {
+		// Hold a shared lock so nobody compacts while reading.
+		int fd = open(journalFilename, O_RDONLY);
+		if (fd >= 0)
+			flock(fd, LOCK_SH);
+
+		// Snapshot.
+		uint64_t snapshotGeneration = ReadSnapshot(snapshotFilename, &scores);
+
+		// Journal, unless its scores already made it into the snapshot.
+		if (fd >= 0) {
+			std::string journal;
+			uint64_t journalGeneration = 0;
+
+			if (ReadWholeFile(fd, journal) && ReadHeader(journal, JOURNAL_MAGIC, journalGeneration) &&
+					journalGeneration > snapshotGeneration)
+				ParseRecords(journal, sizeof(FileHeader), scores);
+
+			flock(fd, LOCK_UN);
+			close(fd);
+		}
+	}
+
+
+	bool CompactJournal(const char* journalFilename, const char* snapshotFilename, const std::size_t maxScores) {
+		// Open the journal.
+		int fd = open(journalFilename, O_RDWR | O_APPEND | O_CREAT, 0644);
+		if (fd < 0)
+			return false;
+
+		// Wait for everyone else to be done with it.
+		if (flock(fd, LOCK_EX) != 0) {
+			close(fd);
+			return false;
+		}
+
+		bool isCompacted = CompactLocked(fd, snapshotFilename, maxScores);
+
+		flock(fd, LOCK_UN);
+		close(fd);
+
+		return isCompacted;
+	}
+
+} /* namespace TextSnake */
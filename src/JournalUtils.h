@@ -0,0 +1,74 @@
+/*
+ * JournalUtils.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#ifndef JOURNALUTILS_H_
+#define JOURNALUTILS_H_
+
+#include <vector>
+#include <cstddef>
+
+#include "LeaderboardUtils.h"
+
+namespace TextSnake {
+
+	/*
+	 * High scores are stored in two files:
+	 *
+	 * Journal: new scores are appended to it while holding an exclusive flock on it,
+	 * so several games running at the same time never overwrite each other's scores.
+	 * Snapshot: all the scores sorted from the highest, rewritten only when the journal gets compacted.
+	 *
+	 * Both files start with a generation number. The journal's scores are part of the snapshot
+	 * when the snapshot's generation is at least the journal's one, which makes compaction safe
+	 * even when the game dies between replacing the snapshot and emptying the journal.
+	 * Every record carries its own checksum, a torn or corrupted record is skipped when reading.
+	 */
+
+	/*
+	 * Appends a score to the journal, compacting it into the snapshot when it gets too big.
+	 * score: Score to save.
+	 * journalFilename: Name of the journal file.
+	 * snapshotFilename: Name of the snapshot file.
+	 * compactionSize: Size in bytes the journal can reach before it's compacted.
+	 * maxScores: Maximum number of scores kept in the snapshot.
+	 * Returns false when the score couldn't be saved.
+	 */
+	bool AppendScoreToJournal(const Score& score, const char* journalFilename, const char* snapshotFilename,
+	                          const std::size_t compactionSize, const std::size_t maxScores);
+
+	/*
+	 * Same as above for several scores at once, appended with a single write and a single sync.
+	 * scores: Scores to save.
+	 * journalFilename: Name of the journal file.
+	 * snapshotFilename: Name of the snapshot file.
+	 * compactionSize: Size in bytes the journal can reach before it's compacted.
+	 * maxScores: Maximum number of scores kept in the snapshot.
+	 * Returns false when the scores couldn't be saved.
+	 */
+	bool AppendScoresToJournal(const std::vector<Score>& scores, const char* journalFilename, const char* snapshotFilename,
+	                           const std::size_t compactionSize, const std::size_t maxScores);
+
+	/*
+	 * Reads all the saved scores, from the snapshot and from the journal.
+	 * scores: Vector to fill in. Scores aren't sorted.
+	 * journalFilename: Name of the journal file.
+	 * snapshotFilename: Name of the snapshot file.
+	 */
+	void LoadScoresFromJournal(std::vector<Score>& scores, const char* journalFilename, const char* snapshotFilename);
+
+	/*
+	 * Merges the journal into a new sorted snapshot and empties the journal.
+	 * journalFilename: Name of the journal file.
+	 * snapshotFilename: Name of the snapshot file.
+	 * maxScores: Maximum number of scores kept in the snapshot.
+	 * Returns false when the snapshot couldn't be written.
+	 */
+	bool CompactJournal(const char* journalFilename, const char* snapshotFilename, const std::size_t maxScores);
+
+} /* namespace TextSnake */
+
+#endif /* JOURNALUTILS_H_ */
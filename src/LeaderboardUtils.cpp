@@ -0,0 +1,247 @@
+/*
+ * LeaderboardUtils.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#include "LeaderboardUtils.h"
+
+namespace TextSnake {
+
+	namespace {
+
+		// Index used for missing children.
+		const uint32_t NO_NODE = 0xFFFFFFFF;
+
+		/*
+		 * Size of the subtree starting at the given node.
+		 */
+		inline uint32_t SubtreeSize(const Leaderboard& lb, const uint32_t node) {
+			return (node == NO_NODE) ? 0 : lb.nodes[node].size;
+		}
+
+		/*
+		 * Recalculates the size of a node's subtree from its children.
+		 */
+		inline void UpdateSize(Leaderboard& lb, const uint32_t node) {
+			lb.nodes[node].size = 1 + SubtreeSize(lb, lb.nodes[node].left) + SubtreeSize(lb, lb.nodes[node].right);
+		}
+
+		/*
+		 * True when node a comes before node b in the leaderboard.
+		 */
+		inline bool ComesBefore(const LeaderboardNode& a, const LeaderboardNode& b) {
+			if (a.entry.score != b.entry.score)
+				return a.entry.score > b.entry.score;
+
+			// Older scores win ties.
+			return a.order < b.order;
+		}
+
+		/*
+		 * Random priority for a new node (xorshift).
+		 */
+		inline uint32_t NextPriority(Leaderboard& lb) {
+			lb.randomState ^= lb.randomState << 13;
+			lb.randomState ^= lb.randomState >> 17;
+			lb.randomState ^= lb.randomState << 5;
+			return lb.randomState;
+		}
+
+		/*
+		 * Splits a subtree into the nodes that come before the given node (left) and the rest (right).
+		 */
+		void SplitByNode(Leaderboard& lb, const uint32_t tree, const LeaderboardNode& key, uint32_t& left, uint32_t& right) {
+			if (tree == NO_NODE) {
+				left = NO_NODE;
+				right = NO_NODE;
+				return;
+			}
+
+			if (ComesBefore(lb.nodes[tree], key)) {
+				SplitByNode(lb, lb.nodes[tree].right, key, lb.nodes[tree].right, right);
+				left = tree;
+			} else {
+				SplitByNode(lb, lb.nodes[tree].left, key, left, lb.nodes[tree].left);
+				right = tree;
+			}
+
+			UpdateSize(lb, tree);
+		}
+
+		/*
+		 * Splits a subtree into its first count nodes (left) and the rest (right).
+		 */
+		void SplitBySize(Leaderboard& lb, const uint32_t tree, const uint32_t count, uint32_t& left, uint32_t& right) {
+			if (tree == NO_NODE) {
+				left = NO_NODE;
+				right = NO_NODE;
+				return;
+			}
+
+			uint32_t leftSize = SubtreeSize(lb, lb.nodes[tree].left);
+
+			if (leftSize < count) {
+				SplitBySize(lb, lb.nodes[tree].right, count - leftSize - 1, lb.nodes[tree].right, right);
+				left = tree;
+			} else {
+				SplitBySize(lb, lb.nodes[tree].left, count, left, lb.nodes[tree].left);
+				right = tree;
+			}
+
+			UpdateSize(lb, tree);
+		}
+
+		/*
+		 * Joins two subtrees where every node of the left one comes before the ones of the right one.
+		 */
+		uint32_t Merge(Leaderboard& lb, const uint32_t left, const uint32_t right) {
+			if (left == NO_NODE)	return right;
+			if (right == NO_NODE)	return left;
+
+			if (lb.nodes[left].priority > lb.nodes[right].priority) {
+				lb.nodes[left].right = Merge(lb, lb.nodes[left].right, right);
+				UpdateSize(lb, left);
+				return left;
+			}
+
+			lb.nodes[right].left = Merge(lb, left, lb.nodes[right].left);
+			UpdateSize(lb, right);
+			return right;
+		}
+
+	} /* namespace */
+
+
+	void InitLeaderboard(Leaderboard& leaderboard) {
+		leaderboard.nodes.clear();
+		leaderboard.freeNodes.clear();
+		leaderboard.root = NO_NODE;
+		leaderboard.nextOrder = 0;
+		leaderboard.randomState = 0x9E3779B9;
+	}
+
+
+	std::size_t GetLeaderboardSize(const Leaderboard& leaderboard) {
+		return SubtreeSize(leaderboard, leaderboard.root);
+	}
+
+
+	std::size_t InsertScore(Leaderboard& leaderboard, const Score& score) {
+		// Reuse a removed node if there's one.
+		uint32_t node = 0;
+		if (!leaderboard.freeNodes.empty()) {
+			node = leaderboard.freeNodes.back();
+			leaderboard.freeNodes.pop_back();
+		} else {
+			node = static_cast<uint32_t>(leaderboard.nodes.size());
+			leaderboard.nodes.push_back(LeaderboardNode());
+		}
+
+		// Initialize the node.
+		LeaderboardNode& newNode = leaderboard.nodes[node];
+		newNode.entry = score;
+		newNode.order = leaderboard.nextOrder++;
+		newNode.priority = NextPriority(leaderboard);
+		newNode.size = 1;
+		newNode.left = NO_NODE;
+		newNode.right = NO_NODE;
+
+		// Put it between the scores before and after it.
+		uint32_t before = NO_NODE;
+		uint32_t after = NO_NODE;
+		SplitByNode(leaderboard, leaderboard.root, leaderboard.nodes[node], before, after);
+
+		// Everything before it decides its rank.
+		std::size_t rank = SubtreeSize(leaderboard, before);
+
+		leaderboard.root = Merge(leaderboard, Merge(leaderboard, before, node), after);
+
+		return rank;
+	}
+
+
+	void RemoveLowestScore(Leaderboard& leaderboard) {
+		std::size_t size = GetLeaderboardSize(leaderboard);
+		if (size == 0)
+			return;
+
+		// Cut the last node off the tree.
+		uint32_t rest = NO_NODE;
+		uint32_t lowest = NO_NODE;
+		SplitBySize(leaderboard, leaderboard.root, static_cast<uint32_t>(size - 1), rest, lowest);
+
+		leaderboard.root = rest;
+
+		// Release its memory and keep the node for later.
+		leaderboard.nodes[lowest].entry.name.clear();
+		leaderboard.freeNodes.push_back(lowest);
+	}
+
+
+	std::size_t GetScoreRank(const Leaderboard& leaderboard, const unsigned int score) {
+		// Count every score that's higher or equal, since those were added before.
+		std::size_t rank = 0;
+		uint32_t node = leaderboard.root;
+
+		while (node != NO_NODE) {
+			const LeaderboardNode& current = leaderboard.nodes[node];
+
+			if (current.entry.score >= score) {
+				rank += SubtreeSize(leaderboard, current.left) + 1;
+				node = current.right;
+			} else {
+				node = current.left;
+			}
+		}
+
+		return rank;
+	}
+
+
+	const Score& GetScoreAtRank(const Leaderboard& leaderboard, std::size_t rank) {
+		uint32_t node = leaderboard.root;
+
+		// Go down the tree skipping whole subtrees.
+		while (true) {
+			const LeaderboardNode& current = leaderboard.nodes[node];
+			std::size_t leftSize = SubtreeSize(leaderboard, current.left);
+
+			if (rank < leftSize) {
+				node = current.left;
+			} else if (rank == leftSize) {
+				return current.entry;
+			} else {
+				rank -= leftSize + 1;
+				node = current.right;
+			}
+		}
+	}
+
+
+	void GetAllScores(const Leaderboard& leaderboard, std::vector<Score>& scores) {
+		scores.clear();
+		scores.reserve(GetLeaderboardSize(leaderboard));
+
+		// In order traversal without recursion.
+		std::vector<uint32_t> stack;
+		uint32_t node = leaderboard.root;
+
+		while (node != NO_NODE || !stack.empty()) {
+			// Go as left as possible.
+			while (node != NO_NODE) {
+				stack.push_back(node);
+				node = leaderboard.nodes[node].left;
+			}
+
+			node = stack.back();
+			stack.pop_back();
+
+			scores.push_back(leaderboard.nodes[node].entry);
+
+			node = leaderboard.nodes[node].right;
+		}
+	}
+
+} /* namespace TextSnake */
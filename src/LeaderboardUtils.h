@@ -0,0 +1,101 @@
+/*
+ * LeaderboardUtils.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#ifndef LEADERBOARDUTILS_H_
+#define LEADERBOARDUTILS_H_
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace TextSnake {
+
+	/*
+	 * Represents a score.
+	 */
+	struct Score {
+		unsigned int score;
+		std::string name;
+	};
+
+	/*
+	 * Node of the leaderboard's tree.
+	 * Nodes refer to each other by their index in the leaderboard's node vector.
+	 */
+	struct LeaderboardNode {
+		Score entry;
+		uint64_t order;
+		uint32_t priority;
+		uint32_t size;
+		uint32_t left;
+		uint32_t right;
+	};
+
+	/*
+	 * Scores sorted from the highest to the lowest.
+	 * It's an order statistic tree (a treap where every node knows the size of its subtree),
+	 * so adding a score, finding the rank of a score and finding the score at a rank are all O(log n).
+	 * Equal scores are ranked by the order they were added in.
+	 */
+	struct Leaderboard {
+		std::vector<LeaderboardNode> nodes;
+		std::vector<uint32_t> freeNodes;
+		uint32_t root;
+		uint64_t nextOrder;
+		uint32_t randomState;
+	};
+
+	/*
+	 * Empties the leaderboard.
+	 * leaderboard: Leaderboard to initialize.
+	 */
+	void InitLeaderboard(Leaderboard& leaderboard);
+
+	/*
+	 * Returns how many scores are in the leaderboard.
+	 * leaderboard: Leaderboard to look into.
+	 */
+	std::size_t GetLeaderboardSize(const Leaderboard& leaderboard);
+
+	/*
+	 * Adds a score to the leaderboard and returns its rank (0 is the highest score).
+	 * leaderboard: Leaderboard to add to.
+	 * score: Score to add.
+	 */
+	std::size_t InsertScore(Leaderboard& leaderboard, const Score& score);
+
+	/*
+	 * Removes the lowest score, so the leaderboard can be kept to a maximum size.
+	 * leaderboard: Leaderboard to remove from.
+	 */
+	void RemoveLowestScore(Leaderboard& leaderboard);
+
+	/*
+	 * Returns the rank a score would get if it was added now (0 is the highest score).
+	 * leaderboard: Leaderboard to look into.
+	 * score: Points to rank.
+	 */
+	std::size_t GetScoreRank(const Leaderboard& leaderboard, const unsigned int score);
+
+	/*
+	 * Returns the score at the given rank.
+	 * leaderboard: Leaderboard to look into.
+	 * rank: Rank of the score, it has to be less than the leaderboard's size.
+	 */
+	const Score& GetScoreAtRank(const Leaderboard& leaderboard, std::size_t rank);
+
+	/*
+	 * Copies all the scores, from the highest to the lowest, into the given vector.
+	 * leaderboard: Leaderboard to copy from.
+	 * scores: Vector to fill in.
+	 */
+	void GetAllScores(const Leaderboard& leaderboard, std::vector<Score>& scores);
+
+} /* namespace TextSnake */
+
+#endif /* LEADERBOARDUTILS_H_ */
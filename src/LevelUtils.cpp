@@ -0,0 +1,294 @@
+/*
+ * LevelUtils.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#include "LevelUtils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace TextSnake {
+
+	namespace {
+
+		// "TSLM" in little endian.
+		const uint32_t LEVEL_MAGIC = 0x4D4C5354;
+		const uint32_t LEVEL_VERSION = 1;
+
+		/*
+		 * Sets a cell of a bit mask, growing the mask by whole rows when needed.
+		 */
+		void SetMaskBit(std::vector<uint64_t>& mask, const std::size_t rowWords, const std::size_t x, const std::size_t y) {
+			if (mask.size() < (y + 1) * rowWords)
+				mask.resize((y + 1) * rowWords, 0);
+
+			mask[y * rowWords + (x >> 6)] |= uint64_t(1) << (x & 63);
+		}
+
+		/*
+		 * Re-lays a mask out with a different number of words per row.
+		 */
+		void ResizeMaskRows(std::vector<uint64_t>& mask, const std::size_t oldRowWords, const std::size_t newRowWords) {
+			if (oldRowWords == newRowWords || mask.empty())
+				return;
+
+			std::size_t totalRows = mask.size() / oldRowWords;
+			std::vector<uint64_t> resized(totalRows * newRowWords, 0);
+
+			for (std::size_t row = 0; row < totalRows; row++)
+				std::memcpy(&resized[row * newRowWords], &mask[row * oldRowWords], oldRowWords * sizeof(uint64_t));
+
+			mask.swap(resized);
+		}
+
+		/*
+		 * Writes all of a buffer to a file descriptor.
+		 */
+		bool WriteAll(int fd, const void* bytes, std::size_t size) {
+			const char* p = static_cast<const char*>(bytes);
+
+			while (size > 0) {
+				ssize_t written = write(fd, p, size);
+				if (written <= 0)
+					return false;
+
+				p += written;
+				size -= written;
+			}
+
+			return true;
+		}
+
+		/*
+		 * Maps a mask file in memory and checks it was compiled from the given map.
+		 */
+		bool MapMask(Level& level, const char* maskFilename, const struct stat& mapStat) {
+			int fd = open(maskFilename, O_RDONLY);
+			if (fd < 0)
+				return false;
+
+			struct stat maskStat;
+			if (fstat(fd, &maskStat) != 0 || static_cast<std::size_t>(maskStat.st_size) < sizeof(LevelMaskHeader)) {
+				close(fd);
+				return false;
+			}
+
+			// The mapping stays valid after closing the file.
+			void* mapped = mmap(nullptr, maskStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+
+			if (mapped == MAP_FAILED)
+				return false;
+
+			const unsigned char* data = static_cast<const unsigned char*>(mapped);
+			std::size_t size = maskStat.st_size;
+			const LevelMaskHeader* header = reinterpret_cast<const LevelMaskHeader*>(data);
+
+			// Everything has to be where the header says, and come from this very version of the map.
+			// Sizes get compared against what's left after each offset, so nothing can overflow.
+			bool isValid = (header->magic == LEVEL_MAGIC) &&
+					(header->version == LEVEL_VERSION) &&
+					(header->sourceSize == static_cast<uint64_t>(mapStat.st_size)) &&
+					(header->sourceModified == static_cast<int64_t>(mapStat.st_mtime)) &&
+					(header->width > 0) && (header->width <= static_cast<uint32_t>(INT32_MAX)) &&
+					(header->height > 0) && (header->height <= static_cast<uint32_t>(INT32_MAX)) &&
+					(header->rowWords == (static_cast<uint64_t>(header->width) + 63) / 64) &&
+					(header->spawnsOffset % alignof(LevelSpawn) == 0) &&
+					(header->spawnsOffset <= size) &&
+					(header->totalSpawns <= (size - header->spawnsOffset) / sizeof(LevelSpawn));
+
+			// The row words are known to fit the width by now, the masks can't take more than 2^61 bytes.
+			std::size_t maskBytes = static_cast<std::size_t>(header->height) * header->rowWords * sizeof(uint64_t);
+			isValid = isValid &&
+					(header->wallsOffset % sizeof(uint64_t) == 0) &&
+					(header->wallsOffset <= size) && (maskBytes <= size - header->wallsOffset) &&
+					(header->totalAppleZones == 0 ||
+						(header->appleZonesOffset % sizeof(uint64_t) == 0 &&
+						 header->appleZonesOffset <= size && maskBytes <= size - header->appleZonesOffset));
+
+			// Snakes start on the spawns, every one of them has to be on the level.
+			const LevelSpawn* spawns = isValid ? reinterpret_cast<const LevelSpawn*>(data + header->spawnsOffset) : nullptr;
+			for (uint32_t i = 0; isValid && i < header->totalSpawns; i++)
+				isValid = (spawns[i].x >= 0) && (static_cast<uint32_t>(spawns[i].x) < header->width) &&
+				          (spawns[i].y >= 0) && (static_cast<uint32_t>(spawns[i].y) < header->height);
+
+			if (!isValid) {
+				munmap(mapped, size);
+				return false;
+			}
+
+			level.data = data;
+			level.size = size;
+			level.width = static_cast<int>(header->width);
+			level.height = static_cast<int>(header->height);
+			level.rowWords = header->rowWords;
+			level.spawns = spawns;
+			level.totalSpawns = header->totalSpawns;
+			level.walls = reinterpret_cast<const uint64_t*>(data + header->wallsOffset);
+			level.totalAppleZones = header->totalAppleZones;
+			level.appleZones = (header->totalAppleZones > 0) ?
+					reinterpret_cast<const uint64_t*>(data + header->appleZonesOffset) : nullptr;
+
+			return true;
+		}
+
+	} /* namespace */
+
+
+	bool LoadLevel(Level& level, const char* filename) {
+		level.filename = filename;
+		level.data = nullptr;
+		level.size = 0;
+
+		// The mask has to match the map as it is now.
+		struct stat mapStat;
+		if (stat(filename, &mapStat) != 0)
+			return false;
+
+		std::string maskFilename = std::string(filename) + Constants::LEVEL_MASK_EXTENSION;
+
+		// Use the compiled mask when it's up to date.
+		if (MapMask(level, maskFilename.c_str(), mapStat))
+			return true;
+
+		// Otherwise compile it and try again.
+		if (!CompileLevel(filename, maskFilename.c_str()))
+			return false;
+
+		return MapMask(level, maskFilename.c_str(), mapStat);
+	}
+
+
+	bool CompileLevel(const char* mapFilename, const char* maskFilename) {
+		// Take the map's size and time before reading it, so a map changed while compiling
+		// ends up not matching its mask.
+		struct stat mapStat;
+		if (stat(mapFilename, &mapStat) != 0)
+			return false;
+
+		std::ifstream readFile(mapFilename, std::ios_base::binary);
+		if (!readFile.is_open())
+			return false;
+
+		std::vector<uint64_t> walls;
+		std::vector<uint64_t> appleZones;
+		std::vector<LevelSpawn> spawns;
+		uint64_t totalAppleZones = 0;
+
+		// The width isn't known until every line was read, so the masks grow their rows as they go.
+		std::size_t width = 0;
+		std::size_t rowWords = 1;
+		std::size_t height = 0;
+
+		std::string line;
+		while (std::getline(readFile, line)) {
+			// Windows line endings.
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+
+			// Make the rows wider when this line doesn't fit.
+			if (line.length() > width) {
+				width = line.length();
+
+				std::size_t newRowWords = (width + 63) / 64;
+				ResizeMaskRows(walls, rowWords, newRowWords);
+				ResizeMaskRows(appleZones, rowWords, newRowWords);
+				rowWords = newRowWords;
+			}
+
+			// Every row exists in the masks, even the empty ones.
+			if (walls.size() < (height + 1) * rowWords)
+				walls.resize((height + 1) * rowWords, 0);
+
+			for (std::size_t x = 0; x < line.length(); x++) {
+				switch (line[x]) {
+					case Constants::LEVEL_WALL:
+						SetMaskBit(walls, rowWords, x, height);
+						break;
+					case Constants::LEVEL_SPAWN: {
+						LevelSpawn spawn;
+						spawn.x = static_cast<int32_t>(x);
+						spawn.y = static_cast<int32_t>(height);
+						spawns.push_back(spawn);
+					}
+						break;
+					case Constants::LEVEL_APPLE_ZONE:
+						SetMaskBit(appleZones, rowWords, x, height);
+						totalAppleZones++;
+						break;
+				}
+			}
+
+			height++;
+		}
+
+		if (width == 0 || height == 0)
+			return false;
+
+		// Apple zones only get stored when there are any.
+		if (totalAppleZones > 0)
+			appleZones.resize(height * rowWords, 0);
+
+		// Header.
+		LevelMaskHeader header;
+		std::memset(&header, 0, sizeof(header));
+		header.magic = LEVEL_MAGIC;
+		header.version = LEVEL_VERSION;
+		header.width = static_cast<uint32_t>(width);
+		header.height = static_cast<uint32_t>(height);
+		header.sourceSize = static_cast<uint64_t>(mapStat.st_size);
+		header.sourceModified = static_cast<int64_t>(mapStat.st_mtime);
+		header.totalSpawns = static_cast<uint32_t>(spawns.size());
+		header.rowWords = static_cast<uint32_t>(rowWords);
+		header.totalAppleZones = totalAppleZones;
+
+		// The masks start 8 byte aligned, so they can be read straight from the mapped file.
+		std::size_t spawnsSize = spawns.size() * sizeof(LevelSpawn);
+		std::size_t spawnsPadding = (sizeof(uint64_t) - (sizeof(header) + spawnsSize) % sizeof(uint64_t)) % sizeof(uint64_t);
+		header.spawnsOffset = sizeof(header);
+		header.wallsOffset = header.spawnsOffset + spawnsSize + spawnsPadding;
+		header.appleZonesOffset = (totalAppleZones > 0) ? header.wallsOffset + walls.size() * sizeof(uint64_t) : 0;
+
+		// Write a temporary file and rename it, so a half written mask never gets loaded.
+		std::string tempFilename = std::string(maskFilename) + ".tmp";
+		int fd = open(tempFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+			return false;
+
+		const uint64_t padding = 0;
+		bool isWritten = WriteAll(fd, &header, sizeof(header)) &&
+				WriteAll(fd, spawns.data(), spawnsSize) &&
+				WriteAll(fd, &padding, spawnsPadding) &&
+				WriteAll(fd, walls.data(), walls.size() * sizeof(uint64_t)) &&
+				WriteAll(fd, appleZones.data(), (totalAppleZones > 0) ? appleZones.size() * sizeof(uint64_t) : 0);
+
+		isWritten = (close(fd) == 0) && isWritten;
+
+		if (!isWritten || std::rename(tempFilename.c_str(), maskFilename) != 0) {
+			unlink(tempFilename.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+
+	void UnloadLevel(Level& level) {
+		if (level.data)
+			munmap(const_cast<unsigned char*>(level.data), level.size);
+
+		level.data = nullptr;
+		level.size = 0;
+	}
+
+} /* namespace TextSnake */
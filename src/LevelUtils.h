@@ -0,0 +1,151 @@
+/*
+ * LevelUtils.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#ifndef LEVELUTILS_H_
+#define LEVELUTILS_H_
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace TextSnake {
+
+	namespace Constants {
+		static const char LEVEL_WALL = '#';
+		static const char LEVEL_SPAWN = 'S';
+		static const char LEVEL_APPLE_ZONE = 'A';
+		static const char* LEVEL_MASK_EXTENSION = ".mask";
+	} /* namespace Constants */
+
+	/*
+	 * Levels are written as ASCII art, one character per cell:
+	 *
+	 * '#': Wall.
+	 * 'S': Spawn point, the snake starts on one of them (the middle of the level when there's none).
+	 * 'A': Apple zone, apples only show up on these cells (anywhere when there's none).
+	 * Anything else: Empty cell.
+	 *
+	 * The level is as wide as its longest line, shorter lines are padded with empty cells.
+	 *
+	 * The first time a level is loaded it gets compiled into a mask file next to it ("<map>.mask"),
+	 * from then on the mask is mapped in memory as it is, with no parsing at all. The mask gets compiled
+	 * again whenever the map's size or modification time don't match the ones it was compiled from.
+	 *
+	 * Mask file layout:
+	 *
+	 * [Header]
+	 * [Spawn points]: one LevelSpawn each.
+	 * [Walls]: one bit per cell, each row padded to a whole number of 64 bit words.
+	 * [Apple zones]: same as the walls, only there when the level has any.
+	 */
+
+	/*
+	 * Beginning of a mask file.
+	 */
+	struct LevelMaskHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint64_t sourceSize;
+		int64_t sourceModified;
+		uint32_t totalSpawns;
+		uint32_t rowWords;
+		uint64_t totalAppleZones;
+		uint64_t spawnsOffset;
+		uint64_t wallsOffset;
+		uint64_t appleZonesOffset;
+	};
+
+	/*
+	 * Spawn point, in level cells.
+	 */
+	struct LevelSpawn {
+		int32_t x;
+		int32_t y;
+	};
+
+	/*
+	 * A level's mask mapped in memory.
+	 */
+	struct Level {
+		std::string filename;
+		const unsigned char* data;
+		std::size_t size;
+		int width;
+		int height;
+		std::size_t rowWords;
+		const LevelSpawn* spawns;
+		std::size_t totalSpawns;
+		const uint64_t* walls;
+		const uint64_t* appleZones;
+		uint64_t totalAppleZones;
+	};
+
+	/*
+	 * Loads a level, compiling its mask first when it's missing or out of date.
+	 * level: Level to fill in.
+	 * filename: Name of the ASCII map.
+	 * Returns false when neither the map nor an up to date mask can be read.
+	 */
+	bool LoadLevel(Level& level, const char* filename);
+
+	/*
+	 * Compiles an ASCII map into a mask file.
+	 * mapFilename: Name of the ASCII map.
+	 * maskFilename: Name of the mask file to write.
+	 * Returns false when the map can't be read or the mask can't be written.
+	 */
+	bool CompileLevel(const char* mapFilename, const char* maskFilename);
+
+	/*
+	 * Unmaps a level.
+	 * level: Level to unload.
+	 */
+	void UnloadLevel(Level& level);
+
+	/*
+	 * Tells whether a cell of a bit mask is set.
+	 */
+	inline bool IsMaskBitSet(const uint64_t* mask, const std::size_t rowWords, const int x, const int y) {
+		return (mask[y * rowWords + (x >> 6)] >> (x & 63)) & 1;
+	}
+
+	/*
+	 * Tells whether there's a wall on a cell.
+	 * level: Level to check.
+	 * x: Column in the level.
+	 * y: Row in the level.
+	 * Cells outside the level have no walls.
+	 */
+	inline bool IsLevelWall(const Level& level, const int x, const int y) {
+		if (x < 0 || y < 0 || x >= level.width || y >= level.height)
+			return false;
+
+		return IsMaskBitSet(level.walls, level.rowWords, x, y);
+	}
+
+	/*
+	 * Tells whether an apple can show up on a cell.
+	 * level: Level to check.
+	 * x: Column in the level.
+	 * y: Row in the level.
+	 */
+	inline bool IsLevelAppleZone(const Level& level, const int x, const int y) {
+		if (x < 0 || y < 0 || x >= level.width || y >= level.height)
+			return false;
+
+		// No apple zones means apples can go anywhere.
+		if (level.totalAppleZones == 0)
+			return true;
+
+		return IsMaskBitSet(level.appleZones, level.rowWords, x, y);
+	}
+
+} /* namespace TextSnake */
+
+#endif /* LEVELUTILS_H_ */
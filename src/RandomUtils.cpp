@@ -0,0 +1,23 @@
+/*
+ * RandomUtils.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#include "RandomUtils.h"
+
+namespace TextSnake {
+
+	void SeedRandom(RandomGenerator& rng, const uint64_t seed, const uint64_t stream) {
+		// The increment has to be odd.
+		rng.state = 0;
+		rng.increment = (stream << 1) | 1;
+
+		// Mix the seed in the same way the reference implementation does.
+		NextRandom(rng);
+		rng.state += seed;
+		NextRandom(rng);
+	}
+
+} /* namespace TextSnake */
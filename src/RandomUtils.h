@@ -0,0 +1,81 @@
+/*
+ * RandomUtils.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#ifndef RANDOMUTILS_H_
+#define RANDOMUTILS_H_
+
+#include <cstdint>
+
+namespace TextSnake {
+
+	namespace Constants {
+		// Stream used when none is given, any odd number works.
+		static const uint64_t DEFAULT_RANDOM_STREAM = 0xDA3E39CB94B95BDBULL;
+	} /* namespace Constants */
+
+	/*
+	 * PCG32 random number generator (permuted congruential generator, XSH RR output).
+	 * Every game owns one, so games don't share any state and the same seed gives the
+	 * same numbers on every platform.
+	 */
+	struct RandomGenerator {
+		uint64_t state;
+		uint64_t increment;
+	};
+
+	/*
+	 * Seeds a generator.
+	 * rng: Generator to seed.
+	 * seed: Starting point of the sequence.
+	 * stream: Picks one of 2^63 independent sequences.
+	 */
+	void SeedRandom(RandomGenerator& rng, const uint64_t seed, const uint64_t stream = Constants::DEFAULT_RANDOM_STREAM);
+
+	/*
+	 * Returns the next random number, uniformly distributed over all 32 bit values.
+	 * rng: Generator to use.
+	 */
+	inline uint32_t NextRandom(RandomGenerator& rng) {
+		uint64_t oldState = rng.state;
+
+		// Advance the linear congruential generator.
+		rng.state = oldState * 6364136223846793005ULL + rng.increment;
+
+		// Scramble the old state into the output: xorshift the high bits down, then rotate by the top 5 bits.
+		uint32_t xorShifted = static_cast<uint32_t>(((oldState >> 18) ^ oldState) >> 27);
+		uint32_t rotation = static_cast<uint32_t>(oldState >> 59);
+
+		return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+	}
+
+	/*
+	 * Returns a random number in [0, bound), every number being equally likely.
+	 * Uses Lemire's multiply and shift, which only needs a division when it's about to be biased.
+	 * rng: Generator to use.
+	 * bound: One past the highest number wanted, has to be greater than 0.
+	 */
+	inline uint32_t RandomBelow(RandomGenerator& rng, const uint32_t bound) {
+		uint64_t product = static_cast<uint64_t>(NextRandom(rng)) * bound;
+		uint32_t low = static_cast<uint32_t>(product);
+
+		// The low part tells whether this number falls in the few that would make the result biased.
+		if (low < bound) {
+			uint32_t threshold = (0u - bound) % bound;
+
+			// Draw again until it doesn't.
+			while (low < threshold) {
+				product = static_cast<uint64_t>(NextRandom(rng)) * bound;
+				low = static_cast<uint32_t>(product);
+			}
+		}
+
+		return static_cast<uint32_t>(product >> 32);
+	}
+
+} /* namespace TextSnake */
+
+#endif /* RANDOMUTILS_H_ */
@@ -0,0 +1,999 @@
+/*
+ * ReplayUtils.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#include "ReplayUtils.h"
+
+#include <ctime>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace TextSnake {
+
+	namespace {
+
+		// "TSRP" and "TSRI" in little endian.
+		const uint32_t REPLAY_MAGIC = 0x50525354;
+		const uint32_t REPLAY_INDEX_MAGIC = 0x49525354;
+		const uint32_t REPLAY_VERSION = 8;
+
+		// An input is stored as two varints of at most 5 bytes each.
+		const std::size_t REPLAY_MAX_VARINT_BYTES = 5;
+		const std::size_t REPLAY_MAX_INPUT_BYTES = 2 * REPLAY_MAX_VARINT_BYTES;
+
+		// Longest side of a board a replay can be played on, so a corrupt one can't ask for all the memory there is.
+		const int REPLAY_MAX_BOARD_SIDE = 1 << 14;
+
+		// Tallest cells a replay can be played with, so the snake's pace stays within reason.
+		const uint64_t REPLAY_MAX_CELL_ASPECT_RATIO = 64;
+
+		// Blocks a recording makes room for up front, over half an hour of play.
+		const std::size_t REPLAY_RESERVED_BLOCKS = 512;
+
+		// Pieces and direction runs the packed tail of a keyframe makes room for up front.
+		const std::size_t REPLAY_RESERVED_PIECES = 1 << 14;
+		const std::size_t REPLAY_RESERVED_RUNS = 1 << 10;
+
+		/*
+		 * Appends raw bytes to a buffer.
+		 */
+		void AppendBytes(std::vector<unsigned char>& buffer, const void* bytes, const std::size_t size) {
+			const unsigned char* first = static_cast<const unsigned char*>(bytes);
+			buffer.insert(buffer.end(), first, first + size);
+		}
+
+		/*
+		 * Appends a value to a buffer as it's laid out in memory.
+		 */
+		template <typename T>
+		void AppendValue(std::vector<unsigned char>& buffer, const T& value) {
+			AppendBytes(buffer, &value, sizeof(T));
+		}
+
+		/*
+		 * Overwrites a value previously appended to a buffer.
+		 */
+		template <typename T>
+		void PatchValue(std::vector<unsigned char>& buffer, const std::size_t offset, const T& value) {
+			std::memcpy(&buffer[offset], &value, sizeof(T));
+		}
+
+		/*
+		 * Reads a value from memory and returns the position right after it.
+		 * Returns nullptr when the value goes past the end, or when p already is nullptr,
+		 * so a whole run of reads only needs checking once.
+		 */
+		template <typename T>
+		const unsigned char* ReadValue(const unsigned char* p, const unsigned char* end, T& value) {
+			if (p == nullptr || static_cast<std::size_t>(end - p) < sizeof(T))
+				return nullptr;
+
+			std::memcpy(&value, p, sizeof(T));
+			return p + sizeof(T);
+		}
+
+		/*
+		 * Writes all of a buffer to a file descriptor.
+		 */
+		bool WriteAll(const int fd, const void* bytes, std::size_t size) {
+			const char* p = static_cast<const char*>(bytes);
+
+			while (size > 0) {
+				ssize_t written = write(fd, p, size);
+				if (written <= 0)
+					return false;
+
+				p += written;
+				size -= written;
+			}
+
+			return true;
+		}
+
+		/*
+		 * Reads count values of the given size from memory and returns the position right after them.
+		 * Returns nullptr when they go past the end, or when p already is nullptr.
+		 */
+		const unsigned char* ReadArray(const unsigned char* p, const unsigned char* end, void* values,
+		                               const std::size_t count, const std::size_t size) {
+			if (p == nullptr || count > static_cast<std::size_t>(end - p) / size)
+				return nullptr;
+
+			if (count > 0)
+				std::memcpy(values, p, count * size);
+			return p + count * size;
+		}
+
+		/*
+		 * Appends an unsigned number using 7 bits per byte, so small numbers only take one byte.
+		 */
+		void AppendVarint(std::vector<unsigned char>& buffer, uint32_t value) {
+			while (value >= 0x80) {
+				buffer.push_back(static_cast<unsigned char>(value | 0x80));
+				value >>= 7;
+			}
+
+			buffer.push_back(static_cast<unsigned char>(value));
+		}
+
+		/*
+		 * Reads a number written by AppendVarint and returns the position right after it.
+		 * Returns nullptr when it goes past the end or is longer than AppendVarint ever writes.
+		 */
+		const unsigned char* ReadVarint(const unsigned char* p, const unsigned char* end, uint32_t& value) {
+			value = 0;
+
+			for (std::size_t i = 0; i < REPLAY_MAX_VARINT_BYTES && p < end; i++, p++) {
+				value |= static_cast<uint32_t>(*p & 0x7F) << (7 * i);
+
+				if ((*p & 0x80) == 0)
+					return p + 1;
+			}
+
+			return nullptr;
+		}
+
+		/*
+		 * Tells whether a direction read from a file is one of the four there are.
+		 */
+		bool IsValidDirection(const Direction direction) {
+			return static_cast<unsigned int>(direction) <= static_cast<unsigned int>(Direction::LEFT);
+		}
+
+		/*
+		 * Tells whether a link read from a file is either nothing or a timer of the pool.
+		 */
+		bool IsValidTimerLink(const int32_t link, const uint32_t totalTimers) {
+			return link >= -1 && (link < 0 || static_cast<uint32_t>(link) < totalTimers);
+		}
+
+		/*
+		 * Tells whether the timer wheel read from a file is one the game could have made: every link is a timer
+		 * of its own pool, and every slot's list goes forward and back through exactly the timers in that slot,
+		 * so neither a corrupt index nor a loop can ever be followed.
+		 */
+		bool IsValidTimerWheel(const TimerWheel& wheel, const Game& game) {
+			uint32_t totalTimers = static_cast<uint32_t>(wheel.timers.size());
+			uint32_t totalScheduled = 0;
+
+			for (const Timer& timer : wheel.timers) {
+				if (!IsValidTimerLink(timer.previous, totalTimers) || !IsValidTimerLink(timer.next, totalTimers) ||
+						timer.slot < -1 || timer.slot >= static_cast<int32_t>(Constants::TIMER_WHEEL_LEVELS * Constants::TIMER_WHEEL_SLOTS))
+					return false;
+
+				if (timer.slot >= 0)
+					totalScheduled++;
+			}
+
+			// Walk every list, none of them can be longer than the timers in the wheel.
+			uint32_t totalLinked = 0;
+			for (unsigned int level = 0; level < Constants::TIMER_WHEEL_LEVELS; level++) {
+				for (unsigned int slot = 0; slot < Constants::TIMER_WHEEL_SLOTS; slot++) {
+					int32_t previous = -1;
+					int32_t index = wheel.slots[level][slot];
+					if (!IsValidTimerLink(index, totalTimers))
+						return false;
+
+					while (index >= 0) {
+						const Timer& timer = wheel.timers[index];
+						if (++totalLinked > totalScheduled || timer.previous != previous ||
+								timer.slot != static_cast<int32_t>(level * Constants::TIMER_WHEEL_SLOTS + slot))
+							return false;
+
+						previous = index;
+						index = timer.next;
+					}
+				}
+			}
+
+			// The free list only holds unscheduled timers, and no more of them than there are.
+			uint32_t totalFree = 0;
+			int32_t index = wheel.freeList;
+			if (!IsValidTimerLink(index, totalTimers))
+				return false;
+
+			while (index >= 0) {
+				if (++totalFree > totalTimers - totalScheduled || wheel.timers[index].slot >= 0)
+					return false;
+				index = wheel.timers[index].next;
+			}
+
+			// Each scheduled timer is in its slot's list.
+			if (totalLinked != totalScheduled)
+				return false;
+
+			// The handles the game keeps point into the pool too, the item's only while there's one.
+			return (!game.isItemOnScreen || IsValidTimerLink(game.item.expiryTimer.index, totalTimers)) &&
+			       IsValidTimerLink(game.effects.speedBoost.index, totalTimers) &&
+			       IsValidTimerLink(game.effects.invincibility.index, totalTimers) &&
+			       IsValidTimerLink(game.effects.respawn.index, totalTimers);
+		}
+
+		/*
+		 * Tells whether the snake's pace read from a file is one UpdateMoveTiming could have set
+		 * and its progress one a tick could have left, so a tick never crosses more than a handful of cells.
+		 */
+		bool IsValidMoveTiming(const MoveTiming& timing, const uint64_t moveProgress) {
+			const uint64_t HORIZONTAL_CELL_COST = static_cast<uint64_t>(Constants::LOOP_FPS) * Constants::MOVE_PRECISION;
+
+			return timing.distancePerFrame == static_cast<uint64_t>(Constants::SNAKE_CELLS_PER_SECOND) * Constants::MOVE_PRECISION &&
+			       timing.horizontalCellCost == HORIZONTAL_CELL_COST &&
+			       timing.verticalCellCost >= Constants::MOVE_PRECISION &&
+			       timing.verticalCellCost <= REPLAY_MAX_CELL_ASPECT_RATIO * HORIZONTAL_CELL_COST &&
+			       moveProgress <= std::max(timing.horizontalCellCost, timing.verticalCellCost) +
+			                       timing.distancePerFrame * Constants::SPEED_BOOST_FACTOR;
+		}
+
+		/*
+		 * Tells whether a packed tail read from a file can be unpacked: its runs start with the first piece,
+		 * go forward and only hold real directions.
+		 */
+		bool IsValidPackedBody(const PackedBody& body) {
+			if (body.length == 0)
+				return true;
+
+			if (body.directions.empty() || body.directions[0].first != 0)
+				return false;
+
+			for (std::size_t i = 0; i < body.directions.size(); i++) {
+				const DirectionRun& run = body.directions[i];
+				if (run.first >= body.length || !IsValidDirection(run.direction))
+					return false;
+				if (i > 0 && run.first <= body.directions[i - 1].first)
+					return false;
+			}
+
+			return true;
+		}
+
+		/*
+		 * Appends everything a tick can change about the game and the snake.
+		 * body: Where the tail gets packed, it keeps its memory from one keyframe to the next.
+		 */
+		void AppendKeyframe(std::vector<unsigned char>& buffer, const Game& game, const Snake& snake, PackedBody& body) {
+			// Game.
+			AppendValue(buffer, game.lives);
+			AppendValue(buffer, game.currentScore);
+			AppendValue(buffer, game.finalScore.score);
+			AppendValue(buffer, game.apple);
+			AppendValue(buffer, game.isAppleOnScreen);
+			AppendValue(buffer, game.currentState);
+			AppendValue(buffer, game.currentScreen);
+			AppendValue(buffer, game.boardSize);
+			AppendValue(buffer, game.rules);
+			AppendValue(buffer, game.moveTiming);
+			AppendValue(buffer, game.random);
+			AppendValue(buffer, game.item);
+			AppendValue(buffer, game.isItemOnScreen);
+			AppendValue(buffer, game.effects);
+			AppendValue(buffer, game.isWon);
+
+			// Timers, the wheel as it is, so they expire in the same order.
+			AppendValue(buffer, game.timers.currentTick);
+			AppendValue(buffer, game.timers.slots);
+			AppendValue(buffer, game.timers.freeList);
+			AppendValue(buffer, game.timers.totalPending);
+
+			uint32_t totalTimers = static_cast<uint32_t>(game.timers.timers.size());
+			AppendValue(buffer, totalTimers);
+			if (totalTimers > 0)
+				AppendBytes(buffer, game.timers.timers.data(), totalTimers * sizeof(Timer));
+
+			// Snake.
+			AppendValue(buffer, snake.currentPosition);
+			AppendValue(buffer, snake.previousPosition);
+			AppendValue(buffer, snake.currentDirection);
+			AppendValue(buffer, snake.previousDirection);
+			AppendValue(buffer, snake.speed);
+			AppendValue(buffer, snake.moveProgress);
+			AppendValue(buffer, snake.sprite);
+			AppendValue(buffer, snake.color);
+
+			// Tail, packed to 2 bits a piece whenever it can be.
+			bool isPacked = PackBody(snake, game, body);
+			AppendValue(buffer, isPacked);
+
+			if (isPacked) {
+				AppendValue(buffer, body.front);
+				AppendValue(buffer, body.length);
+				AppendBytes(buffer, body.steps.data(), body.steps.size());
+
+				uint32_t totalRuns = static_cast<uint32_t>(body.directions.size());
+				AppendValue(buffer, totalRuns);
+				AppendBytes(buffer, body.directions.data(), totalRuns * sizeof(DirectionRun));
+				return;
+			}
+
+			// Otherwise every piece as it is, from the head to the end whatever way it wraps around the ring.
+			uint32_t tailSize = static_cast<uint32_t>(GetTailLength(snake));
+			AppendValue(buffer, tailSize);
+			for (uint32_t i = 0; i < tailSize; i++)
+				AppendValue(buffer, GetTailPiece(snake, i));
+		}
+
+		/*
+		 * Reads what AppendKeyframe wrote back into the game and the snake.
+		 * body: Where the packed tail gets read to, it keeps its memory from one keyframe to the next.
+		 * Returns nullptr when the keyframe goes past the end or doesn't hold a state the game can be in.
+		 */
+		const unsigned char* ReadKeyframe(const unsigned char* p, const unsigned char* end, Game& game, Snake& snake,
+		                                  PackedBody& body) {
+			// Game.
+			p = ReadValue(p, end, game.lives);
+			p = ReadValue(p, end, game.currentScore);
+			p = ReadValue(p, end, game.finalScore.score);
+			p = ReadValue(p, end, game.apple);
+			p = ReadValue(p, end, game.isAppleOnScreen);
+			p = ReadValue(p, end, game.currentState);
+			p = ReadValue(p, end, game.currentScreen);
+			p = ReadValue(p, end, game.boardSize);
+			p = ReadValue(p, end, game.rules);
+			p = ReadValue(p, end, game.moveTiming);
+			p = ReadValue(p, end, game.random);
+			p = ReadValue(p, end, game.item);
+			p = ReadValue(p, end, game.isItemOnScreen);
+			p = ReadValue(p, end, game.effects);
+			p = ReadValue(p, end, game.isWon);
+
+			// The board's size decides how much memory the snake's cells take, an item's kind what it looks like.
+			if (p == nullptr ||
+					game.boardSize.x <= Constants::X_MIN || game.boardSize.x > REPLAY_MAX_BOARD_SIDE ||
+					game.boardSize.y <= Constants::Y_MIN || game.boardSize.y > REPLAY_MAX_BOARD_SIDE ||
+					(game.isItemOnScreen && static_cast<unsigned int>(game.item.kind) > static_cast<unsigned int>(ItemKind::INVINCIBILITY)))
+				return nullptr;
+
+			// Games started over during the replay get played on the same kind of board.
+			game.isWrapModeOn = game.rules.isWrapping;
+
+			// Timers.
+			p = ReadValue(p, end, game.timers.currentTick);
+			p = ReadValue(p, end, game.timers.slots);
+			p = ReadValue(p, end, game.timers.freeList);
+			p = ReadValue(p, end, game.timers.totalPending);
+
+			uint32_t totalTimers = 0;
+			p = ReadValue(p, end, totalTimers);
+			if (p == nullptr || totalTimers > static_cast<std::size_t>(end - p) / sizeof(Timer))
+				return nullptr;
+
+			game.timers.timers.resize(totalTimers);
+			p = ReadArray(p, end, game.timers.timers.data(), totalTimers, sizeof(Timer));
+			if (p == nullptr || !IsValidTimerWheel(game.timers, game))
+				return nullptr;
+
+			// Snake.
+			p = ReadValue(p, end, snake.currentPosition);
+			p = ReadValue(p, end, snake.previousPosition);
+			p = ReadValue(p, end, snake.currentDirection);
+			p = ReadValue(p, end, snake.previousDirection);
+			p = ReadValue(p, end, snake.speed);
+			p = ReadValue(p, end, snake.moveProgress);
+			p = ReadValue(p, end, snake.sprite);
+			p = ReadValue(p, end, snake.color);
+
+			if (p == nullptr || !IsValidDirection(snake.currentDirection) || !IsValidDirection(snake.previousDirection) ||
+					snake.speed != Constants::SNAKE_DEFAULT_SPEED || !IsValidMoveTiming(game.moveTiming, snake.moveProgress))
+				return nullptr;
+
+			// Tail, laid out from the start of the ring.
+			bool isPacked = false;
+			p = ReadValue(p, end, isPacked);
+
+			if (isPacked) {
+				p = ReadValue(p, end, body.front);
+				p = ReadValue(p, end, body.length);
+
+				// A tail never has more pieces than there are cells.
+				std::size_t totalCells = static_cast<std::size_t>(game.boardSize.x - Constants::X_MIN) * (game.boardSize.y - Constants::Y_MIN);
+				std::size_t totalSteps = (static_cast<std::size_t>(body.length) + 2) / 4;
+				if (p == nullptr || body.length > totalCells || totalSteps > static_cast<std::size_t>(end - p))
+					return nullptr;
+
+				body.steps.assign(p, p + totalSteps);
+				p += totalSteps;
+
+				uint32_t totalRuns = 0;
+				p = ReadValue(p, end, totalRuns);
+				if (p == nullptr || totalRuns > static_cast<std::size_t>(end - p) / sizeof(DirectionRun))
+					return nullptr;
+
+				body.directions.resize(totalRuns);
+				p = ReadArray(p, end, body.directions.data(), totalRuns, sizeof(DirectionRun));
+				if (p == nullptr || !IsValidPackedBody(body))
+					return nullptr;
+
+				UnpackBody(body, game, snake);
+			} else {
+				uint32_t tailSize = 0;
+				p = ReadValue(p, end, tailSize);
+				if (p == nullptr || tailSize > static_cast<std::size_t>(end - p) / sizeof(TailPiece))
+					return nullptr;
+
+				if (snake.tail.size() < tailSize)
+					snake.tail.resize(tailSize);
+				p = ReadArray(p, end, snake.tail.data(), tailSize, sizeof(TailPiece));
+
+				for (uint32_t i = 0; i < tailSize; i++)
+					if (!IsValidDirection(snake.tail[i].currentDirection) || !IsValidDirection(snake.tail[i].previousDirection))
+						return nullptr;
+
+				snake.tailFront = 0;
+				snake.tailLength = tailSize;
+			}
+
+			// The snake's cells come from where it is.
+			InitOccupancy(snake, game);
+
+			return p;
+		}
+
+		/*
+		 * Starts a new block at the current tick with a keyframe of the current state.
+		 */
+		void BeginBlock(ReplayRecorder& recorder, const Game& game, const Snake& snake) {
+			// Index the block.
+			ReplayIndexEntry entry;
+			entry.tick = recorder.tick;
+			entry.reserved = 0;
+			entry.offset = recorder.data.size();
+			recorder.index.push_back(entry);
+
+			// Block's tick.
+			AppendValue(recorder.data, recorder.tick);
+
+			// Keyframe, preceded by its size so it can be skipped.
+			std::size_t sizeOffset = recorder.data.size();
+			AppendValue(recorder.data, static_cast<uint32_t>(0));
+			AppendKeyframe(recorder.data, game, snake, recorder.packedBody);
+			PatchValue(recorder.data, sizeOffset, static_cast<uint32_t>(recorder.data.size() - sizeOffset - sizeof(uint32_t)));
+
+			// A keyframe was just made.
+			recorder.isKeyframeNeeded = false;
+
+			// Inputs are relative to the beginning of the block.
+			recorder.blockInputs.clear();
+			recorder.blockInputCount = 0;
+			recorder.lastInputTick = recorder.tick;
+		}
+
+		/*
+		 * Writes the inputs of the current block after its keyframe.
+		 */
+		void EndBlock(ReplayRecorder& recorder) {
+			AppendValue(recorder.data, recorder.blockInputCount);
+			AppendValue(recorder.data, static_cast<uint32_t>(recorder.blockInputs.size()));
+			AppendBytes(recorder.data, recorder.blockInputs.data(), recorder.blockInputs.size());
+		}
+
+		/*
+		 * Reads the index entry at the given position.
+		 */
+		ReplayIndexEntry GetIndexEntry(const ReplayReader& reader, const uint32_t i) {
+			// OpenReplay made sure the whole index is in the file.
+			ReplayIndexEntry entry = {};
+			ReadValue(reader.data + reader.indexOffset + i * sizeof(ReplayIndexEntry), reader.data + reader.size, entry);
+			return entry;
+		}
+
+		/*
+		 * Points the cursor to the inputs of the given block, optionally loading its keyframe.
+		 * Returns false when the block doesn't fit in the space the index gives it.
+		 */
+		bool EnterBlock(ReplayCursor& cursor, const uint32_t block, Game* game, Snake* snake) {
+			const ReplayReader& reader = *cursor.reader;
+
+			// A block goes up to the next one, the last one up to the index.
+			ReplayIndexEntry entry = GetIndexEntry(reader, block);
+			const unsigned char* p = reader.data + entry.offset;
+			const unsigned char* end = reader.data +
+					((block + 1 < reader.totalEntries) ? GetIndexEntry(reader, block + 1).offset : reader.indexOffset);
+
+			// Block's tick.
+			uint32_t blockTick = 0;
+			p = ReadValue(p, end, blockTick);
+
+			// Keyframe.
+			uint32_t keyframeSize = 0;
+			p = ReadValue(p, end, keyframeSize);
+			if (p == nullptr || blockTick != entry.tick || keyframeSize > static_cast<std::size_t>(end - p))
+				return false;
+
+			if (game && snake && ReadKeyframe(p, p + keyframeSize, *game, *snake, cursor.packedBody) == nullptr)
+				return false;
+			p += keyframeSize;
+
+			// Inputs.
+			uint32_t inputsLeft = 0;
+			uint32_t inputsSize = 0;
+			p = ReadValue(p, end, inputsLeft);
+			p = ReadValue(p, end, inputsSize);
+			if (p == nullptr || inputsSize > static_cast<std::size_t>(end - p))
+				return false;
+
+			cursor.block = block;
+			cursor.tick = blockTick;
+			cursor.inputsLeft = inputsLeft;
+			cursor.inputsEnd = p + inputsSize;
+
+			// Find out when the first input happens.
+			if (cursor.inputsLeft > 0) {
+				uint32_t delta = 0;
+				p = ReadVarint(p, cursor.inputsEnd, delta);
+				if (p == nullptr)
+					return false;
+
+				cursor.nextInputTick = blockTick + delta;
+			}
+
+			cursor.nextInput = p;
+			return true;
+		}
+
+		/*
+		 * Sets up whatever the keyframes don't store about a game before playing a replay,
+		 * loading the level it was recorded on. Returns false when the level can't be loaded.
+		 */
+		bool InitReplayGame(Game& game, Level& level, const ReplayReader& reader) {
+			InitLeaderboard(game.highScores);
+			game.layout.generation = 0;
+			game.screenCache.isValid = false;
+			game.level = nullptr;
+			game.scoreSaver = nullptr;
+			game.scoreLoader = nullptr;
+			game.isWrapModeOn = false;
+			InitScripts(game);
+
+			if (reader.levelFilename.empty())
+				return true;
+
+			if (!LoadLevel(level, reader.levelFilename.c_str()))
+				return false;
+
+			game.level = &level;
+
+			return true;
+		}
+
+	} /* namespace */
+
+
+	void BeginRecording(ReplayRecorder& recorder, const Game& game, const Snake& snake) {
+		// Start from scratch.
+		recorder.data.clear();
+		recorder.index.clear();
+		recorder.tick = 0;
+		recorder.isRecording = true;
+
+		// A block can't have more inputs than ticks, make room for the longest one up front
+		// so recording a tick doesn't allocate.
+		recorder.blockInputs.reserve(Constants::REPLAY_KEYFRAME_INTERVAL * REPLAY_MAX_INPUT_BYTES);
+
+		// The same goes for packing a long snake's tail.
+		recorder.packedBody.steps.reserve(REPLAY_RESERVED_PIECES / 4);
+		recorder.packedBody.directions.reserve(REPLAY_RESERVED_RUNS);
+
+		// Header.
+		ReplayHeader header;
+		header.magic = REPLAY_MAGIC;
+		header.version = REPLAY_VERSION;
+		header.keyframeInterval = Constants::REPLAY_KEYFRAME_INTERVAL;
+		header.levelFilenameLength = (game.level != nullptr) ? static_cast<uint32_t>(game.level->filename.length()) : 0;
+		AppendValue(recorder.data, header);
+
+		// The level the game is played on, right after the header.
+		if (game.level != nullptr)
+			AppendBytes(recorder.data, game.level->filename.data(), game.level->filename.length());
+
+		// The first block starts with the state before the first tick.
+		BeginBlock(recorder, game, snake);
+
+		// Make room for a long game up front, twice the first keyframe a block for the inputs and the tail growing,
+		// so recording doesn't allocate while it's played. Both keep their memory from one game to the next,
+		// and get twice the room when they grow so a game starting with a slightly bigger keyframe fits too.
+		std::size_t blockSize = 2 * (recorder.data.size() - recorder.index[0].offset);
+		std::size_t reservedSize = recorder.data.size() + REPLAY_RESERVED_BLOCKS * (blockSize + sizeof(ReplayIndexEntry)) +
+		                           sizeof(uint64_t) + sizeof(ReplayFooter);
+		if (recorder.data.capacity() < reservedSize)
+			recorder.data.reserve(2 * reservedSize);
+		recorder.index.reserve(REPLAY_RESERVED_BLOCKS);
+	}
+
+
+	void RecordTick(ReplayRecorder& recorder, const Game& game, const Snake& snake, const int input) {
+		// Every now and then close the current block and start a new one with a keyframe.
+		// The same happens when something the inputs can't explain changed (e.g. the terminal was resized).
+		if (recorder.tick > 0 &&
+				(recorder.isKeyframeNeeded || (recorder.tick % Constants::REPLAY_KEYFRAME_INTERVAL) == 0)) {
+			EndBlock(recorder);
+			BeginBlock(recorder, game, snake);
+		}
+
+		// Only store ticks where something was actually pressed.
+		if (input != ERR) {
+			AppendVarint(recorder.blockInputs, recorder.tick - recorder.lastInputTick);
+			AppendVarint(recorder.blockInputs, static_cast<uint32_t>(input));
+
+			recorder.blockInputCount++;
+			recorder.lastInputTick = recorder.tick;
+		}
+
+		recorder.tick++;
+	}
+
+
+	bool EndRecording(ReplayRecorder& recorder, const char* filename) {
+		// Done recording.
+		recorder.isRecording = false;
+
+		// Close the last block.
+		EndBlock(recorder);
+
+		// Align the index so it can be read straight from the mapped file.
+		while (recorder.data.size() % sizeof(uint64_t) != 0)
+			recorder.data.push_back(0);
+
+		// Index.
+		ReplayFooter footer;
+		footer.indexOffset = recorder.data.size();
+		footer.totalEntries = static_cast<uint32_t>(recorder.index.size());
+		footer.totalTicks = recorder.tick;
+		footer.reserved = 0;
+		footer.magic = REPLAY_INDEX_MAGIC;
+		AppendBytes(recorder.data, recorder.index.data(), recorder.index.size() * sizeof(ReplayIndexEntry));
+
+		// Footer.
+		AppendValue(recorder.data, footer);
+
+		// Write it all straight from the buffer.
+		int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+			return false;
+
+		bool isWritten = WriteAll(fd, recorder.data.data(), recorder.data.size());
+		return (close(fd) == 0) && isWritten;
+	}
+
+
+	bool OpenReplay(ReplayReader& reader, const char* filename) {
+		reader.data = nullptr;
+		reader.size = 0;
+
+		// Open the file.
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		// Figure out its size.
+		struct stat fileStat;
+		if (fstat(fd, &fileStat) != 0 ||
+				static_cast<std::size_t>(fileStat.st_size) < sizeof(ReplayHeader) + sizeof(ReplayFooter)) {
+			close(fd);
+			return false;
+		}
+
+		// Map the whole file, the mapping stays valid after closing the file.
+		void* mapped = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+
+		if (mapped == MAP_FAILED)
+			return false;
+
+		reader.data = static_cast<const unsigned char*>(mapped);
+		reader.size = fileStat.st_size;
+
+		// Check header and footer. Everything is compared against what's left, so nothing can overflow.
+		const unsigned char* end = reader.data + reader.size;
+		ReplayHeader header = {};
+		ReplayFooter footer = {};
+		ReadValue(reader.data, end, header);
+		ReadValue(end - sizeof(ReplayFooter), end, footer);
+
+		std::size_t blocksEnd = reader.size - sizeof(ReplayFooter);
+		bool isValid = (header.magic == REPLAY_MAGIC) &&
+				(header.version == REPLAY_VERSION) &&
+				(header.keyframeInterval > 0) &&
+				(footer.magic == REPLAY_INDEX_MAGIC) &&
+				(footer.totalEntries > 0) &&
+				(header.levelFilenameLength <= reader.size - sizeof(ReplayHeader)) &&
+				(footer.indexOffset <= blocksEnd) &&
+				(footer.totalEntries <= (blocksEnd - footer.indexOffset) / sizeof(ReplayIndexEntry));
+
+		if (!isValid) {
+			CloseReplay(reader);
+			return false;
+		}
+
+		reader.levelFilename.assign(reinterpret_cast<const char*>(reader.data + sizeof(ReplayHeader)), header.levelFilenameLength);
+		reader.keyframeInterval = header.keyframeInterval;
+		reader.totalEntries = footer.totalEntries;
+		reader.totalTicks = footer.totalTicks;
+		reader.indexOffset = footer.indexOffset;
+
+		// Blocks come one after the other between the level's filename and the index,
+		// each one starting later in the file and no sooner in the game than the one before.
+		// A keyframe gets recorded at least every keyframeInterval ticks, the game starts with one.
+		uint64_t previousOffset = 0;
+		uint32_t previousTick = 0;
+		for (uint32_t i = 0; i < reader.totalEntries; i++) {
+			ReplayIndexEntry entry = GetIndexEntry(reader, i);
+
+			bool isInOrder = (i == 0) ? (entry.offset >= sizeof(ReplayHeader) + header.levelFilenameLength && entry.tick == 0)
+			                          : (entry.offset > previousOffset && entry.tick >= previousTick &&
+			                             entry.tick - previousTick <= reader.keyframeInterval);
+
+			if (!isInOrder || entry.offset >= reader.indexOffset) {
+				CloseReplay(reader);
+				return false;
+			}
+
+			previousOffset = entry.offset;
+			previousTick = entry.tick;
+		}
+
+		// The last block doesn't go on for longer than the others.
+		if (reader.totalTicks < previousTick || reader.totalTicks - previousTick > reader.keyframeInterval) {
+			CloseReplay(reader);
+			return false;
+		}
+
+		return true;
+	}
+
+
+	void CloseReplay(ReplayReader& reader) {
+		if (reader.data)
+			munmap(const_cast<unsigned char*>(reader.data), reader.size);
+
+		reader.data = nullptr;
+		reader.size = 0;
+	}
+
+
+	bool SeekReplay(ReplayCursor& cursor, const ReplayReader& reader, uint32_t tick, Game& game, Snake& snake) {
+		// Can't go past the end.
+		if (tick > reader.totalTicks)
+			tick = reader.totalTicks;
+
+		// Binary search the last block that starts at or before the wanted tick.
+		uint32_t first = 0;
+		uint32_t last = reader.totalEntries;
+		while (last - first > 1) {
+			uint32_t middle = first + (last - first) / 2;
+
+			if (GetIndexEntry(reader, middle).tick <= tick)	first = middle;
+			else											last = middle;
+		}
+
+		// Load the block's keyframe.
+		cursor.reader = &reader;
+		cursor.isCorrupt = !EnterBlock(cursor, first, &game, &snake);
+
+		// Simulate the rest, which is never longer than a block.
+		while (cursor.tick < tick && StepReplay(cursor, game, snake)) {}
+
+		return !cursor.isCorrupt;
+	}
+
+
+	bool StepReplay(ReplayCursor& cursor, Game& game, Snake& snake) {
+		// Nothing left to play, or nothing that can be read.
+		if (cursor.isCorrupt || cursor.tick >= cursor.reader->totalTicks)
+			return false;
+
+		// Move on to the next block's inputs, the state is already the one stored in its keyframe.
+		if (cursor.block + 1 < cursor.reader->totalEntries &&
+				GetIndexEntry(*cursor.reader, cursor.block + 1).tick == cursor.tick &&
+				!EnterBlock(cursor, cursor.block + 1, nullptr, nullptr)) {
+			cursor.isCorrupt = true;
+			return false;
+		}
+
+		// Find out whether something was pressed during this tick.
+		int input = ERR;
+		if (cursor.inputsLeft > 0 && cursor.nextInputTick == cursor.tick) {
+			uint32_t key = 0;
+			cursor.nextInput = ReadVarint(cursor.nextInput, cursor.inputsEnd, key);
+			input = static_cast<int>(key);
+
+			// Find out when the next input happens.
+			cursor.inputsLeft--;
+			if (cursor.nextInput != nullptr && cursor.inputsLeft > 0) {
+				uint32_t delta = 0;
+				cursor.nextInput = ReadVarint(cursor.nextInput, cursor.inputsEnd, delta);
+				cursor.nextInputTick = cursor.tick + delta;
+			}
+
+			if (cursor.nextInput == nullptr) {
+				cursor.isCorrupt = true;
+				return false;
+			}
+		}
+
+		// Run the tick.
+		SimulateTick(game, snake, input);
+		cursor.tick++;
+
+		return true;
+	}
+
+
+	void PlayReplay(const char* filename) {
+		// Load the replay.
+		ReplayReader reader;
+		if (!OpenReplay(reader, filename)) {
+			std::fprintf(stderr, "Couldn't open replay %s\n", filename);
+			return;
+		}
+
+		// Game and snake get their state from the replay.
+		Game replayGame;
+		Snake replaySnake;
+		Level level;
+		if (!InitReplayGame(replayGame, level, reader)) {
+			std::fprintf(stderr, "Couldn't load level %s\n", reader.levelFilename.c_str());
+			CloseReplay(reader);
+			return;
+		}
+
+		ReplayCursor cursor;
+		if (!SeekReplay(cursor, reader, 0, replayGame, replaySnake)) {
+			std::fprintf(stderr, "Replay %s is corrupt\n", filename);
+			CloseReplay(reader);
+			if (replayGame.level != nullptr)
+				UnloadLevel(level);
+			return;
+		}
+
+		// Initialize Curses.
+		CursesUtils::InitCurses(true, false, false, true, true, 0);
+		CursesUtils::InstallResizeHandler();
+		InitColors();
+
+		// Fit the replay's board in the screen.
+		ResizeScreen(replayGame, CursesUtils::GetColumns(), CursesUtils::GetRows());
+
+		bool quit = false;
+		bool isPaused = false;
+		uint32_t ticksPerFrame = 1;
+		char statusText[128];
+
+		// Take the time at the start of the playback.
+		clock_t lastTime = clock();
+
+		// Playback loop.
+		while (!quit) {
+			clock_t currentTime = clock();
+
+			// Same pace as the game.
+			if ((currentTime - lastTime) <= static_cast<clock_t>(CLOCKS_PER_SEC / Constants::LOOP_FPS))
+				continue;
+
+			lastTime = currentTime;
+
+			// Fit the board in the resized screen.
+			if (CursesUtils::HandlePendingResize())
+				ResizeScreen(replayGame, CursesUtils::GetColumns(), CursesUtils::GetRows());
+
+			// Controls.
+			switch (CursesUtils::GetCharacter()) {
+				// A keyframe that can't be read leaves nothing to show.
+				case static_cast<int>(CursesUtils::ArrowKey::RIGHT):
+					quit = !SeekReplay(cursor, reader, cursor.tick + Constants::REPLAY_SEEK_STEP, replayGame, replaySnake);
+					break;
+				case static_cast<int>(CursesUtils::ArrowKey::LEFT):
+					quit = !SeekReplay(cursor, reader,
+					                   (cursor.tick > Constants::REPLAY_SEEK_STEP) ? cursor.tick - Constants::REPLAY_SEEK_STEP : 0,
+					                   replayGame, replaySnake);
+					break;
+				case static_cast<int>(CursesUtils::ArrowKey::UP):
+					if (ticksPerFrame < Constants::REPLAY_KEYFRAME_INTERVAL)	ticksPerFrame *= 2;
+					break;
+				case static_cast<int>(CursesUtils::ArrowKey::DOWN):
+					if (ticksPerFrame > 1)	ticksPerFrame /= 2;
+					break;
+				case ' ':
+					isPaused = !isPaused;
+					break;
+				case Constants::QUIT_BUTTON:
+					quit = true;
+					break;
+			}
+
+			if (quit)
+				break;
+
+			// Play.
+			if (!isPaused) {
+				for (uint32_t i = 0; i < ticksPerFrame; i++)
+					if (!StepReplay(cursor, replayGame, replaySnake))
+						break;
+			}
+
+			// Draw the replayed game and where the playback is.
+			CursesUtils::ClearScreen();
+			DrawMainGame(replayGame, replaySnake);
+
+			std::snprintf(statusText, sizeof(statusText), "Replay %u/%u x%u %s  (arrows) seek/speed (space) pause (q) quit",
+			              cursor.tick, reader.totalTicks, ticksPerFrame, isPaused ? "PAUSED" : "");
+			CursesUtils::PrintFormattedAtPosition(0, 1, statusText);
+
+			CursesUtils::RefreshScreen();
+		}
+
+		// Make sure Curses gets shut down.
+		CursesUtils::ShutdownCurses();
+		CloseReplay(reader);
+
+		if (cursor.isCorrupt)
+			std::fprintf(stderr, "Replay %s is corrupt at tick %u\n", filename, cursor.tick);
+
+		if (replayGame.level != nullptr)
+			UnloadLevel(level);
+	}
+
+
+	void BenchmarkReplay(const char* filename) {
+		// Load the replay.
+		ReplayReader reader;
+		if (!OpenReplay(reader, filename)) {
+			std::fprintf(stderr, "Couldn't open replay %s\n", filename);
+			return;
+		}
+
+		if (reader.totalTicks == 0) {
+			std::fprintf(stderr, "Replay %s is empty\n", filename);
+			CloseReplay(reader);
+			return;
+		}
+
+		Game benchGame;
+		Snake benchSnake;
+		Level level;
+		if (!InitReplayGame(benchGame, level, reader)) {
+			std::fprintf(stderr, "Couldn't load level %s\n", reader.levelFilename.c_str());
+			CloseReplay(reader);
+			return;
+		}
+
+		ReplayCursor cursor;
+
+		// Play the replay from the start over and over for about a second.
+		uint64_t totalTicks = 0;
+		auto start = std::chrono::steady_clock::now();
+		std::chrono::duration<double> elapsed(0);
+
+		while (elapsed.count() < 1.0) {
+			SeekReplay(cursor, reader, 0, benchGame, benchSnake);
+			while (StepReplay(cursor, benchGame, benchSnake))
+				totalTicks++;
+
+			// Stop at the first part that can't be read, playing it again won't help.
+			if (cursor.isCorrupt) {
+				std::fprintf(stderr, "Replay %s is corrupt at tick %u\n", filename, cursor.tick);
+				break;
+			}
+
+			elapsed = std::chrono::steady_clock::now() - start;
+		}
+
+		std::printf("%s: %u ticks, %u keyframes, %llu ticks simulated in %.3fs (%.0f ticks/s)\n",
+		            filename, reader.totalTicks, reader.totalEntries,
+		            static_cast<unsigned long long>(totalTicks), elapsed.count(), totalTicks / elapsed.count());
+
+		CloseReplay(reader);
+
+		if (benchGame.level != nullptr)
+			UnloadLevel(level);
+	}
+
+} /* namespace TextSnake */
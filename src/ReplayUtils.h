@@ -0,0 +1,192 @@
+/*
+ * ReplayUtils.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#ifndef REPLAYUTILS_H_
+#define REPLAYUTILS_H_
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "SnakeUtils.h"
+#include "BodyUtils.h"
+
+namespace TextSnake {
+
+	/*
+	 * Replay file layout:
+	 *
+	 * [Header]
+	 * [Level filename]: not null terminated, empty when the game wasn't played on a level.
+	 * [Block 0]: [Keyframe][Inputs]
+	 * [Block 1]: [Keyframe][Inputs]
+	 * ...
+	 * [Index]: one entry per block.
+	 * [Footer]
+	 *
+	 * A block starts every REPLAY_KEYFRAME_INTERVAL ticks with a full copy of the game and the snake,
+	 * the snake's tail packed to 2 bits a piece unless it can't be (see BodyUtils.h),
+	 * followed by the inputs given during the block's ticks. Ticks without any input aren't stored,
+	 * each stored input only keeps the number of ticks since the previous one.
+	 * The footer at the end of the file tells where the index is, so seeking to a tick only needs
+	 * a binary search on the index and at most one block worth of simulated ticks.
+	 */
+
+	/*
+	 * Beginning of a replay file.
+	 */
+	struct ReplayHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t keyframeInterval;
+		uint32_t levelFilenameLength;
+	};
+
+	/*
+	 * Tells where a block starts in the file.
+	 */
+	struct ReplayIndexEntry {
+		uint32_t tick;
+		uint32_t reserved;
+		uint64_t offset;
+	};
+
+	/*
+	 * End of a replay file.
+	 */
+	struct ReplayFooter {
+		uint64_t indexOffset;
+		uint32_t totalEntries;
+		uint32_t totalTicks;
+		uint32_t reserved;
+		uint32_t magic;
+	};
+
+	/*
+	 * Records a game while it's being played.
+	 * packedBody: The tail of the last keyframe, kept so packing the next one doesn't allocate.
+	 */
+	struct ReplayRecorder {
+		bool isRecording;
+		bool isKeyframeNeeded;
+		uint32_t tick;
+		uint32_t lastInputTick;
+		std::vector<unsigned char> data;
+		std::vector<unsigned char> blockInputs;
+		uint32_t blockInputCount;
+		std::vector<ReplayIndexEntry> index;
+		PackedBody packedBody;
+	};
+
+	/*
+	 * A replay file mapped in memory.
+	 */
+	struct ReplayReader {
+		const unsigned char* data;
+		std::size_t size;
+		std::string levelFilename;
+		uint32_t keyframeInterval;
+		uint32_t totalEntries;
+		uint32_t totalTicks;
+		uint64_t indexOffset;
+	};
+
+	/*
+	 * Keeps track of where the playback is in a replay.
+	 * nextInput, inputsEnd: The current block's inputs still to be read.
+	 * isCorrupt: Set once part of the replay couldn't be read, nothing gets played after it.
+	 * packedBody: The tail of the last keyframe read, kept so seeking doesn't allocate.
+	 */
+	struct ReplayCursor {
+		const ReplayReader* reader;
+		uint32_t block;
+		uint32_t tick;
+		const unsigned char* nextInput;
+		const unsigned char* inputsEnd;
+		uint32_t inputsLeft;
+		uint32_t nextInputTick;
+		bool isCorrupt;
+		PackedBody packedBody;
+	};
+
+	/*
+	 * Starts recording a new game.
+	 * It has to be called before the first tick of the game is simulated.
+	 * recorder: Recorder to use.
+	 * game: Instance of the game.
+	 * snake: Instance of the snake.
+	 */
+	void BeginRecording(ReplayRecorder& recorder, const Game& game, const Snake& snake);
+
+	/*
+	 * Stores the input of the tick that's about to be simulated.
+	 * recorder: Recorder to use.
+	 * game: Instance of the game (before the tick).
+	 * snake: Instance of the snake (before the tick).
+	 * input: The input given for this tick.
+	 */
+	void RecordTick(ReplayRecorder& recorder, const Game& game, const Snake& snake, const int input);
+
+	/*
+	 * Stops recording and writes the replay to a file.
+	 * recorder: Recorder to use.
+	 * filename: Name of the file to write to.
+	 * Returns false when the file couldn't be written.
+	 */
+	bool EndRecording(ReplayRecorder& recorder, const char* filename);
+
+	/*
+	 * Maps a replay file in memory and checks it's a valid one: its header, footer and that every block
+	 * the index points to is in the file. The blocks themselves get checked as they're read.
+	 * reader: Reader to fill in.
+	 * filename: Name of the replay file.
+	 * Returns false when the file can't be opened or isn't a replay.
+	 */
+	bool OpenReplay(ReplayReader& reader, const char* filename);
+
+	/*
+	 * Unmaps a replay file.
+	 * reader: Reader to close.
+	 */
+	void CloseReplay(ReplayReader& reader);
+
+	/*
+	 * Puts the game and the snake in the state they were at the given tick.
+	 * cursor: Cursor to move.
+	 * reader: Replay to seek in.
+	 * tick: Tick to go to (it gets clamped to the replay's length).
+	 * game: Instance of the game.
+	 * snake: Instance of the snake.
+	 * Returns false when the replay is corrupt before the given tick, the game is then left in no usable state.
+	 */
+	bool SeekReplay(ReplayCursor& cursor, const ReplayReader& reader, uint32_t tick, Game& game, Snake& snake);
+
+	/*
+	 * Simulates the next tick of the replay.
+	 * cursor: Cursor to move forward.
+	 * game: Instance of the game.
+	 * snake: Instance of the snake.
+	 * Returns false when the replay is already over, or the rest of it can't be read (see isCorrupt).
+	 */
+	bool StepReplay(ReplayCursor& cursor, Game& game, Snake& snake);
+
+	/*
+	 * Watches a replay with seeking, pausing and fast forward.
+	 * filename: Name of the replay file.
+	 */
+	void PlayReplay(const char* filename);
+
+	/*
+	 * Fast forwards a whole replay headlessly several times and prints how many ticks per second it ran at.
+	 * filename: Name of the replay file.
+	 */
+	void BenchmarkReplay(const char* filename);
+
+} /* namespace TextSnake */
+
+#endif /* REPLAYUTILS_H_ */
@@ -0,0 +1,165 @@
+/*
+ * SaverUtils.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#include "SaverUtils.h"
+
+#include <chrono>
+#include <functional>
+#include <utility>
+
+#include "JournalUtils.h"
+
+namespace TextSnake {
+
+	namespace {
+
+		/*
+		 * Body of the saving thread.
+		 */
+		void RunScoreSaver(ScoreSaver& saver) {
+			std::vector<Score> batch;
+			std::unique_lock<std::mutex> lock(saver.mutex);
+
+			while (true) {
+				// Sleep until there's something to save, or it's time to stop.
+				saver.wakeUp.wait(lock, [&saver]() { return !saver.queue.empty() || saver.isStopping; });
+
+				// Only stop once everything queued got saved.
+				if (saver.queue.empty())
+					break;
+
+				// Take the whole queue, whatever comes in meanwhile goes in the next batch.
+				batch.swap(saver.queue);
+
+				// The game can queue more while this one gets written.
+				lock.unlock();
+				bool isSaved = saver.save(batch, saver.journalFilename.c_str(), saver.snapshotFilename.c_str(),
+				                          saver.compactionSize, saver.maxScores);
+				lock.lock();
+
+				saver.totalBatches++;
+				if (isSaved)
+					saver.totalSaved += batch.size();
+				else
+					saver.totalFailed += batch.size();
+
+				batch.clear();
+			}
+		}
+
+		/*
+		 * Loads the scores and builds the leaderboard, on whichever thread calls it.
+		 */
+		void LoadScores(ScoreLoader& loader) {
+			auto loadStart = std::chrono::steady_clock::now();
+
+			// Read both the sorted snapshot and the scores appended since.
+			std::vector<Score> scores;
+			LoadScoresFromJournal(scores, loader.journalFilename.c_str(), loader.snapshotFilename.c_str());
+
+			// Put them into the leaderboard.
+			for (std::size_t i = 0; i < scores.size(); i++)
+				InsertScore(loader.highScores, scores[i]);
+
+			// Only keep the best ones.
+			while (GetLeaderboardSize(loader.highScores) > loader.maxScores)
+				RemoveLowestScore(loader.highScores);
+
+			std::chrono::duration<uint64_t, std::nano> loadTime = std::chrono::steady_clock::now() - loadStart;
+			loader.loadNanos = loadTime.count();
+		}
+
+	} /* namespace */
+
+
+	void StartScoreSaver(ScoreSaver& saver, const char* journalFilename, const char* snapshotFilename,
+	                     const std::size_t compactionSize, const std::size_t maxScores, SaveScores save) {
+		saver.queue.clear();
+		saver.isStopping = false;
+		saver.totalSaved = 0;
+		saver.totalBatches = 0;
+		saver.totalFailed = 0;
+		saver.save = (save != nullptr) ? save : AppendScoresToJournal;
+		saver.journalFilename = journalFilename;
+		saver.snapshotFilename = snapshotFilename;
+		saver.compactionSize = compactionSize;
+		saver.maxScores = maxScores;
+
+		saver.thread = std::thread(RunScoreSaver, std::ref(saver));
+	}
+
+
+	void QueueScore(ScoreSaver& saver, const Score& score) {
+		{
+			std::lock_guard<std::mutex> lock(saver.mutex);
+			saver.queue.push_back(score);
+		}
+
+		saver.wakeUp.notify_one();
+	}
+
+
+	void StopScoreSaver(ScoreSaver& saver) {
+		{
+			std::lock_guard<std::mutex> lock(saver.mutex);
+			saver.isStopping = true;
+		}
+
+		saver.wakeUp.notify_one();
+
+		// Wait for the last scores to reach the disk.
+		if (saver.thread.joinable())
+			saver.thread.join();
+	}
+
+
+	void InitScoreLoader(ScoreLoader& loader, const char* journalFilename, const char* snapshotFilename,
+	                     const std::size_t maxScores) {
+		InitLeaderboard(loader.highScores);
+		loader.journalFilename = journalFilename;
+		loader.snapshotFilename = snapshotFilename;
+		loader.maxScores = maxScores;
+		loader.isStarted = false;
+		loader.loadNanos = 0;
+		loader.waitNanos = 0;
+	}
+
+
+	void StartScoreLoader(ScoreLoader& loader) {
+		if (loader.isStarted)
+			return;
+
+		loader.isStarted = true;
+		loader.thread = std::thread(LoadScores, std::ref(loader));
+	}
+
+
+	void FinishScoreLoader(ScoreLoader& loader, Leaderboard& highScores) {
+		auto waitStart = std::chrono::steady_clock::now();
+
+		// Nobody got it going, the scores are needed now.
+		if (!loader.isStarted) {
+			loader.isStarted = true;
+			LoadScores(loader);
+		}
+
+		if (loader.thread.joinable())
+			loader.thread.join();
+
+		std::chrono::duration<uint64_t, std::nano> waitTime = std::chrono::steady_clock::now() - waitStart;
+		loader.waitNanos = waitTime.count();
+
+		highScores = std::move(loader.highScores);
+	}
+
+
+	void StopScoreLoader(ScoreLoader& loader) {
+		if (loader.thread.joinable())
+			loader.thread.join();
+	}
+
+} /* namespace TextSnake */
@@ -0,0 +1,149 @@
+/*
+ * SaverUtils.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#ifndef SAVERUTILS_H_
+#define SAVERUTILS_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LeaderboardUtils.h"
+
+namespace TextSnake {
+
+	/*
+	 * Saves high scores on a thread of its own, so a slow disk never holds the game loop up.
+	 *
+	 * The game queues a copy of each score and goes on right away. The thread takes everything queued
+	 * so far in one go and saves it with a single write and sync, so a burst of scores costs a single sync.
+	 * Stopping the saver saves whatever is still queued before the thread exits.
+	 *
+	 * High scores get loaded on a thread of their own too, so a long history doesn't hold the first frame up.
+	 * The thread reads them and builds the leaderboard, the game only takes it once it needs it.
+	 */
+
+	/*
+	 * Saves a batch of scores, AppendScoresToJournal unless something else is given.
+	 * Returns false when they couldn't be saved.
+	 */
+	typedef bool (*SaveScores)(const std::vector<Score>& scores, const char* journalFilename, const char* snapshotFilename,
+	                           const std::size_t compactionSize, const std::size_t maxScores);
+
+	/*
+	 * The saving thread and what it shares with the game.
+	 * Everything from queue to totalFailed is guarded by mutex.
+	 * thread: Does the saving.
+	 * mutex: Guards what the game and the thread share.
+	 * wakeUp: Signaled when there's something to save, or when it's time to stop.
+	 * queue: Scores waiting to be saved, in the order they came in.
+	 * isStopping: Save what's left and exit.
+	 * totalSaved: Scores saved so far.
+	 * totalBatches: Times the thread saved, every one of them with a single sync.
+	 * totalFailed: Scores that couldn't be saved.
+	 * save: Saves a batch.
+	 * journalFilename, snapshotFilename, compactionSize, maxScores: Handed to save.
+	 */
+	struct ScoreSaver {
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable wakeUp;
+		std::vector<Score> queue;
+		bool isStopping;
+		uint64_t totalSaved;
+		uint64_t totalBatches;
+		uint64_t totalFailed;
+		SaveScores save;
+		std::string journalFilename;
+		std::string snapshotFilename;
+		std::size_t compactionSize;
+		std::size_t maxScores;
+	};
+
+	/*
+	 * Starts the saving thread.
+	 * saver: Saver to start, it mustn't be running already.
+	 * journalFilename: Name of the journal file.
+	 * snapshotFilename: Name of the snapshot file.
+	 * compactionSize: Size in bytes the journal can reach before it's compacted.
+	 * maxScores: Maximum number of scores kept in the snapshot.
+	 * save: Saves a batch, AppendScoresToJournal when nullptr.
+	 */
+	void StartScoreSaver(ScoreSaver& saver, const char* journalFilename, const char* snapshotFilename,
+	                     const std::size_t compactionSize, const std::size_t maxScores, SaveScores save = nullptr);
+
+	/*
+	 * Hands a score over to the saving thread, without waiting for it to be saved.
+	 * saver: Running saver.
+	 * score: Score to save.
+	 */
+	void QueueScore(ScoreSaver& saver, const Score& score);
+
+	/*
+	 * Saves whatever is still queued and stops the saving thread.
+	 * saver: Running saver.
+	 */
+	void StopScoreSaver(ScoreSaver& saver);
+
+	/*
+	 * The loading thread and what it hands over to the game.
+	 * Only the thread touches highScores and loadNanos until it's joined.
+	 * thread: Does the loading.
+	 * highScores: Leaderboard with the loaded scores.
+	 * journalFilename, snapshotFilename, maxScores: Where to load from and how many scores to keep.
+	 * isStarted: Whether the scores are being loaded, or already are.
+	 * loadNanos: Time it took to load them and build the leaderboard.
+	 * waitNanos: Time the game had to wait for them.
+	 */
+	struct ScoreLoader {
+		std::thread thread;
+		Leaderboard highScores;
+		std::string journalFilename;
+		std::string snapshotFilename;
+		std::size_t maxScores;
+		bool isStarted;
+		uint64_t loadNanos;
+		uint64_t waitNanos;
+	};
+
+	/*
+	 * Gets a loader ready without touching the disk.
+	 * loader: Loader to initialize.
+	 * journalFilename: Name of the journal file.
+	 * snapshotFilename: Name of the snapshot file.
+	 * maxScores: Maximum number of scores kept in the leaderboard.
+	 */
+	void InitScoreLoader(ScoreLoader& loader, const char* journalFilename, const char* snapshotFilename,
+	                     const std::size_t maxScores);
+
+	/*
+	 * Starts loading the scores on the loading thread, unless they're loaded already.
+	 * loader: Initialized loader.
+	 */
+	void StartScoreLoader(ScoreLoader& loader);
+
+	/*
+	 * Hands the loaded scores over, waiting for the loading thread if it isn't done yet.
+	 * When the thread never got started they're loaded right away.
+	 * loader: Initialized loader, it can only be finished once.
+	 * highScores: Gets the loaded leaderboard.
+	 */
+	void FinishScoreLoader(ScoreLoader& loader, Leaderboard& highScores);
+
+	/*
+	 * Waits for the loading thread when it got started, without loading anything when it didn't.
+	 * loader: Initialized loader, finished or not.
+	 */
+	void StopScoreLoader(ScoreLoader& loader);
+
+} /* namespace TextSnake */
+
+#endif /* SAVERUTILS_H_ */
@@ -0,0 +1,45 @@
+/*
+ * ScriptUtils.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#include "ScriptUtils.h"
+
+namespace TextSnake {
+
+	void InitScript(Script& script) {
+		script.resumePoint = 0;
+		script.wait = ScriptWait::NOTHING;
+		script.timer = NO_TIMER;
+		script.counter = 0;
+	}
+
+
+	void StopScript(TimerWheel& wheel, Script& script) {
+		// Its timer would wake it up somewhere it isn't anymore.
+		CancelTimer(wheel, script.timer);
+		InitScript(script);
+	}
+
+
+	void WaitForTicks(TimerWheel& wheel, Script& script, const uint32_t id, const uint64_t ticks) {
+		script.wait = ScriptWait::TICKS;
+		script.timer = ScheduleTimer(wheel, ticks, id, 0);
+	}
+
+
+	void WaitForInput(Script& script) {
+		script.wait = ScriptWait::INPUT;
+		script.timer = NO_TIMER;
+	}
+
+
+	void FinishScript(Script& script) {
+		script.resumePoint = 0;
+		script.wait = ScriptWait::NOTHING;
+		script.timer = NO_TIMER;
+	}
+
+} /* namespace TextSnake */
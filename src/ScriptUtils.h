@@ -0,0 +1,122 @@
+/*
+ * ScriptUtils.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#ifndef SCRIPTUTILS_H_
+#define SCRIPTUTILS_H_
+
+#include <cstdint>
+
+#include "TimerUtils.h"
+
+namespace TextSnake {
+
+	/*
+	 * Scripts are animations and transitions written as straight line code that waits for ticks or input,
+	 * the way a coroutine would, without leaving C++17 nor allocating a frame.
+	 *
+	 * A script is a function that picks up where it left off every time it gets called. Its body goes
+	 * between SCRIPT_BEGIN and SCRIPT_END, and it hands control back with SCRIPT_WAIT_TICKS or
+	 * SCRIPT_WAIT_INPUT. Whoever runs the scripts only calls one again once what it waits for happened,
+	 * so a waiting script costs nothing per tick. Ticks are counted by a timer wheel, which calls back
+	 * with the script's id as the event.
+	 *
+	 * Locals don't survive a wait, whatever has to goes in the script (counter is there for loops).
+	 * The resume points are line numbers, so there can't be two waits on the same line.
+	 */
+
+	/*
+	 * What a script is waiting for.
+	 */
+	enum class ScriptWait : uint32_t {
+		NOTHING,
+		TICKS,
+		INPUT
+	};
+
+	/*
+	 * Where a script is at.
+	 * resumePoint: Where it goes on from, 0 to start from the top.
+	 * wait: What it's waiting for, NOTHING once it's over.
+	 * timer: Wakes it up when it's waiting for ticks.
+	 * counter: Kept across waits, for the script to use.
+	 */
+	struct Script {
+		uint32_t resumePoint;
+		ScriptWait wait;
+		TimerHandle timer;
+		uint32_t counter;
+	};
+
+	/*
+	 * Sets a script up so it starts from the top next time it runs.
+	 * script: Script to set up.
+	 */
+	void InitScript(Script& script);
+
+	/*
+	 * Stops a script wherever it is, so it starts from the top next time it runs.
+	 * wheel: Wheel its timer is on.
+	 * script: Script to stop.
+	 */
+	void StopScript(TimerWheel& wheel, Script& script);
+
+	/*
+	 * Makes a script wait for some ticks. It's called by SCRIPT_WAIT_TICKS.
+	 * wheel: Wheel counting the ticks.
+	 * script: Script that waits.
+	 * id: Handed back as the timer's event when the ticks are up.
+	 * ticks: Ticks to wait, at least 1.
+	 */
+	void WaitForTicks(TimerWheel& wheel, Script& script, const uint32_t id, const uint64_t ticks);
+
+	/*
+	 * Makes a script wait for the next key. It's called by SCRIPT_WAIT_INPUT.
+	 * script: Script that waits.
+	 */
+	void WaitForInput(Script& script);
+
+	/*
+	 * Marks a script as over. It's called by SCRIPT_END.
+	 * script: Script that's done.
+	 */
+	void FinishScript(Script& script);
+
+	/*
+	 * Tells whether a script is still going.
+	 * script: Script to check.
+	 */
+	inline bool IsScriptRunning(const Script& script) {
+		return script.wait != ScriptWait::NOTHING;
+	}
+
+} /* namespace TextSnake */
+
+// Opens a script's body, jumping to where it left off.
+#define SCRIPT_BEGIN(script) switch ((script).resumePoint) { case 0:
+
+// Returns from the script until the ticks are up, and goes on from right here then.
+#define SCRIPT_WAIT_TICKS(script, wheel, id, ticks) \
+	do { \
+		TextSnake::WaitForTicks((wheel), (script), (id), (ticks)); \
+		(script).resumePoint = __LINE__; \
+		return; \
+		case __LINE__:; \
+	} while (false)
+
+// Returns from the script until a key gets pressed, and goes on from right here then.
+#define SCRIPT_WAIT_INPUT(script) \
+	do { \
+		TextSnake::WaitForInput(script); \
+		(script).resumePoint = __LINE__; \
+		return; \
+		case __LINE__:; \
+	} while (false)
+
+// Closes a script's body, it's over once it gets here.
+#define SCRIPT_END(script) } TextSnake::FinishScript(script)
+
+#endif /* SCRIPTUTILS_H_ */
@@ -0,0 +1,554 @@
+/*
+ * SnakeRules.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#ifndef SNAKERULES_H_
+#define SNAKERULES_H_
+
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <cstddef>
+#include <limits>
+
+#include "SnakeUtils.h"
+#include "TraceUtils.h"
+
+namespace TextSnake {
+
+	/*
+	 * The in game logic is written once as templates over a rules policy.
+	 * A policy tells the board size, whether the board wraps around, where the level's walls,
+	 * spawn points and apple zones are, how much the snake grows per apple and how many points
+	 * an apple is worth:
+	 *
+	 * RuntimeRules reads everything from the game, it's what the game itself uses.
+	 * FixedRules has everything as compile time constants, so the compiler can fold the
+	 * board bounds and the rules straight into the tick. It's always played without a level.
+	 */
+
+	/*
+	 * Brings a coordinate that went at most one cell past either end back onto the other end, without branching.
+	 * value: Coordinate, counted from the board's first cell.
+	 * size: Cells along the axis.
+	 * Returns the coordinate on the board.
+	 */
+	constexpr int WrapCoordinate(const int value, const int size) {
+		return value + size * (static_cast<int>(value < 0) - static_cast<int>(value >= size));
+	}
+
+	/*
+	 * Same as above for an axis whose size is known at compile time, a power of two just gets masked.
+	 * SIZE: Cells along the axis.
+	 * value: Coordinate, counted from the board's first cell.
+	 * Returns the coordinate on the board.
+	 */
+	template <int SIZE>
+	constexpr int WrapCoordinate(const int value) {
+		if constexpr (SIZE > 0 && (SIZE & (SIZE - 1)) == 0)
+			return value & (SIZE - 1);
+		else
+			return WrapCoordinate(value, SIZE);
+	}
+
+	/*
+	 * Rules configured at run time, read from the game.
+	 */
+	struct RuntimeRules {
+		static int BoardWidth(const Game& game) { return game.boardSize.x; }
+		static int BoardHeight(const Game& game) { return game.boardSize.y; }
+		static bool IsWrapping(const Game& game) { return game.rules.isWrapping; }
+		static int WrapColumn(const Game& game, const int column) { return WrapCoordinate(column, game.boardSize.x - Constants::X_MIN); }
+		static int WrapRow(const Game& game, const int row) { return WrapCoordinate(row, game.boardSize.y - Constants::Y_MIN); }
+		static unsigned int GrowthPerApple(const Game& game) { return game.rules.growthPerApple; }
+
+		static bool IsWall(const Game& game, const int x, const int y) {
+			return game.level != nullptr && IsLevelWall(*game.level, x - Constants::X_MIN, y - Constants::Y_MIN);
+		}
+
+		static bool IsAppleZone(const Game& game, const int x, const int y) {
+			return game.level == nullptr || IsLevelAppleZone(*game.level, x - Constants::X_MIN, y - Constants::Y_MIN);
+		}
+
+		static const LevelSpawn* PickSpawn(const Game& game, RandomGenerator& random) {
+			if (game.level == nullptr || game.level->totalSpawns == 0)
+				return nullptr;
+
+			// Every spawn was checked to be on the level when its mask got mapped.
+			return &game.level->spawns[RandomBelow(random, static_cast<uint32_t>(game.level->totalSpawns))];
+		}
+
+		static unsigned int ScoreForTail(const Game& game, const std::size_t tailSize) {
+			// My score increase formula.
+			unsigned int scoreAddition = static_cast<unsigned int>(ceil(tailSize / 2) * game.rules.scoreMultiplier);
+
+			// Return the base points in case it's the first apple the snake eats.
+			return (tailSize > 1) ? scoreAddition : game.rules.baseApplePoints;
+		}
+	};
+
+	/*
+	 * Rules fixed at compile time.
+	 * WIDTH: Width of the board.
+	 * HEIGHT: Height of the board.
+	 * WRAPPING: True when the snake goes through the borders and comes out on the other side.
+	 * GROWTH: Tail pieces added per apple.
+	 * BASE_POINTS: Points for the first apple.
+	 * MULTIPLIER: Points per pair of tail pieces for the following apples.
+	 */
+	template <int WIDTH, int HEIGHT, bool WRAPPING = false, unsigned int GROWTH = Constants::GROWTH_PER_APPLE,
+	          unsigned int BASE_POINTS = Constants::BASE_APPLE_POINTS, unsigned int MULTIPLIER = Constants::SCORE_MULTIPLIER>
+	struct FixedRules {
+		static constexpr int BoardWidth(const Game&) { return WIDTH; }
+		static constexpr int BoardHeight(const Game&) { return HEIGHT; }
+		static constexpr bool IsWrapping(const Game&) { return WRAPPING; }
+		static constexpr int WrapColumn(const Game&, const int column) { return WrapCoordinate<WIDTH - Constants::X_MIN>(column); }
+		static constexpr int WrapRow(const Game&, const int row) { return WrapCoordinate<HEIGHT - Constants::Y_MIN>(row); }
+		static constexpr unsigned int GrowthPerApple(const Game&) { return GROWTH; }
+		static constexpr bool IsWall(const Game&, const int, const int) { return false; }
+		static constexpr bool IsAppleZone(const Game&, const int, const int) { return true; }
+		static constexpr const LevelSpawn* PickSpawn(const Game&, RandomGenerator&) { return nullptr; }
+
+		static constexpr unsigned int ScoreForTail(const Game&, const std::size_t tailSize) {
+			return (tailSize > 1) ? static_cast<unsigned int>(tailSize / 2) * MULTIPLIER : BASE_POINTS;
+		}
+	};
+
+
+	/*
+	 * Adds points to a score, which stays at the highest one there can be instead of wrapping around.
+	 * A snake filling a huge board gets there.
+	 */
+	inline unsigned int AddPoints(const unsigned int score, const unsigned int points) {
+		return (points > std::numeric_limits<unsigned int>::max() - score) ? std::numeric_limits<unsigned int>::max() : score + points;
+	}
+
+
+	template <typename Rules> void UpdateMainGame(Game& game, Snake& snake);
+	template <typename Rules> void TellSnakeToMove(Snake& snake, Game& game);
+	template <typename Rules> void MoveSnake(Snake& snake, const int x, const int y, Game& game);
+	template <typename Rules> bool DieOnCollision(Snake& snk, Game& gm);
+	template <typename Rules> void ResetSnake(Snake& snake, Game& game);
+	template <typename Rules> void EatAppleOnCollision(Snake& snk, Game& gm);
+	template <typename Rules> unsigned int CalcScore(const Snake& snake, const Game& game);
+	template <typename Rules> void SpawnApple(Game& game, Snake& snake);
+	template <typename Rules> bool PickRandomApplePos(Snake& s, Game& g, Vector2D& p);
+	template <typename Rules> bool IsAppleCellFree(const Snake& s, const Game& g, const int x, const int y);
+	template <typename Rules> void UpdateTimers(Game& game, Snake& snake);
+	template <typename Rules> void HandleTimerEvent(Game& game, Snake& snake, const TimerEvent event);
+	template <typename Rules> void SpawnItem(Game& game, Snake& snake);
+	template <typename Rules> void EatItemOnCollision(Snake& snk, Game& gm);
+
+
+	template <typename Rules>
+	void UpdateMainGame(Game& game, Snake& snake) {
+		// Update snake's position.
+		TellSnakeToMove<Rules>(snake, game);
+
+		// Update the tail's position.
+		UpdateTailPiecesPosition(snake);
+
+		// The item took the last cell left for the apple when it had to spawn, there may be room for it now.
+		if (!game.isAppleOnScreen && game.currentState == State::SHOW_MAIN_GAME)
+			SpawnApple<Rules>(game, snake);
+	}
+
+
+	template <typename Rules>
+	void TellSnakeToMove(Snake& snake, Game& game) {
+		// Check the snake current direction.
+		switch (snake.currentDirection) {
+			case Direction::UP:
+				MoveSnake<Rules>(snake, 0, -1, game);
+				break;
+			case Direction::RIGHT:
+				MoveSnake<Rules>(snake, 1, 0, game);
+				break;
+			case Direction::DOWN:
+				MoveSnake<Rules>(snake, 0, 1, game);
+				break;
+			case Direction::LEFT:
+				MoveSnake<Rules>(snake, -1, 0, game);
+				break;
+		}
+	}
+
+
+	template <typename Rules>
+	void MoveSnake(Snake& snake, const int x, const int y, Game& game) {
+		// Set the previous position before we set the new one.
+		snake.previousPosition.x = snake.currentPosition.x;
+		snake.previousPosition.y = snake.currentPosition.y;
+
+		// Take the speed into account when changing the position.
+		// The deltas are negative when going up or left.
+		int newX = x * static_cast<int>(snake.speed);
+		int newY = y * static_cast<int>(snake.speed);
+
+		// Set the new position.
+		snake.currentPosition.x += newX;
+		snake.currentPosition.y += newY;
+
+		// Come out on the other side of the board when going through a border.
+		// The head only ever moves one cell, so there's no need for a division.
+		if (Rules::IsWrapping(game)) {
+			snake.currentPosition.x = Rules::WrapColumn(game, snake.currentPosition.x - Constants::X_MIN) + Constants::X_MIN;
+			snake.currentPosition.y = Rules::WrapRow(game, snake.currentPosition.y - Constants::Y_MIN) + Constants::Y_MIN;
+		}
+
+		// The head leaves its cell for the new one.
+		VacateCell(snake.occupancy, snake.previousPosition);
+		OccupyCell(snake.occupancy, snake.currentPosition);
+
+		// Check whether the snake hits a wall or itself.
+		TraceBegin("DieOnCollision");
+		bool hasDied = DieOnCollision<Rules>(snake, game);
+		TraceEnd("DieOnCollision");
+
+		// A snake that just died got put back at its starting point, it didn't get to any apple.
+		if (hasDied)
+			return;
+
+		// Check whether the snake ate an apple.
+		EatAppleOnCollision<Rules>(snake, game);
+
+		// Or an item.
+		EatItemOnCollision<Rules>(snake, game);
+	}
+
+
+	template <typename Rules>
+	bool DieOnCollision(Snake& snk, Game& gm) {
+		// Wall collisions.
+		// Snake position is the same as either border of the screen.
+		// There are no walls when the board wraps around.
+		bool vWallCollision = !Rules::IsWrapping(gm) &&
+				((snk.currentPosition.y < Constants::Y_MIN) ||
+				(snk.currentPosition.y >= Rules::BoardHeight(gm)));
+		bool hWallCollision = !Rules::IsWrapping(gm) &&
+				((snk.currentPosition.x < Constants::X_MIN) ||
+				(snk.currentPosition.x >= Rules::BoardWidth(gm)));
+
+		// The level's own walls, a single bit test.
+		bool levelWallCollision = Rules::IsWall(gm, snk.currentPosition.x, snk.currentPosition.y);
+
+		// Tail Collision.
+		// The head is already counted on its cell, any other piece there is the tail.
+		// An invincible snake goes right through its tail.
+		bool tailCollision = (snk.tailLength > 0) &&
+				(CountOccupants(snk.occupancy, snk.currentPosition.x, snk.currentPosition.y) > 1) &&
+				!IsTimerPending(gm.timers, gm.effects.invincibility);
+
+		// If a collision happened, make sure to lose one life or die.
+		if (vWallCollision || hWallCollision || levelWallCollision || tailCollision) {
+			// Lose a life.
+			gm.lives--;
+
+			// When the snake has at least one life left, then reset it.
+			// On the other hand, when the snake has no more lives left, move onto the
+			// game over screen.
+			if (gm.lives > 0) {
+				ResetSnake<Rules>(snk, gm);
+
+				// Effects don't outlive a life.
+				CancelTimer(gm.timers, gm.effects.speedBoost);
+				CancelTimer(gm.timers, gm.effects.invincibility);
+
+				// Give the player a moment before the snake moves again.
+				CancelTimer(gm.timers, gm.effects.respawn);
+				gm.effects.respawn = ScheduleTimer(gm.timers, Constants::RESPAWN_DELAY_TICKS, static_cast<uint32_t>(TimerEvent::EFFECT_OVER), 0);
+
+				// Meanwhile it blinks where it respawned.
+				StartScript(gm, ScriptId::RESPAWN_BLINK);
+			} else	{
+				// Set the lives count to 0.
+				gm.lives = 0;
+
+				EndGame(gm, false);
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
+
+	template <typename Rules>
+	void ResetSnake(Snake& snake, Game& game) {
+		// Take the old snake off the board, going through its own cells only.
+		VacateSnake(snake);
+
+		// Middle of the board.
+		int xMid = static_cast<int>(Rules::BoardWidth(game) / 2);
+		int yMid = static_cast<int>(Rules::BoardHeight(game) / 2);
+
+		// Reset the snake position to the center of the screen.
+		int xPos = 0;
+		int yPos = 0;
+
+		// Room on the board.
+		int width = Rules::BoardWidth(game) - Constants::X_MIN;
+		int height = Rules::BoardHeight(game) - Constants::Y_MIN;
+
+		// Random offset from the center.
+		// It's never a whole board wide, or the snake would end up right back in the center.
+		int maxOffset = std::max(1, std::min(static_cast<int>(Constants::OFFSET_FROM_MIDSCREEN), width - 1));
+		int randomOffset = static_cast<int>(RandomBelow(game.random, maxOffset)) + 1;
+
+		if ((game.apple.position.x == xMid) && (game.apple.position.y == yMid)) {
+			// If an apple is located in the center, put the snake somewhere else.
+			// Small boards wrap the offset around so the snake stays on them.
+			xPos = (xMid + randomOffset - Constants::X_MIN) % width + Constants::X_MIN;
+			yPos = (yMid + randomOffset - Constants::Y_MIN) % height + Constants::Y_MIN;
+		} else {
+			// Snake is positioned in the center.
+			xPos = xMid;
+			yPos = yMid;
+		}
+
+		snake.currentPosition.x = xPos;
+		snake.currentPosition.y = yPos;
+
+		// Levels tell where the snake starts again.
+		const LevelSpawn* spawn = Rules::PickSpawn(game, game.random);
+		if (spawn != nullptr) {
+			snake.currentPosition.x = spawn->x + Constants::X_MIN;
+			snake.currentPosition.y = spawn->y + Constants::Y_MIN;
+		}
+
+		// Reset previous position.
+		snake.previousPosition.x = snake.currentPosition.x;
+		snake.previousPosition.y = snake.currentPosition.y;
+
+		// Start moving from the middle of the new cell.
+		snake.moveProgress = 0;
+
+		// Reset direction.
+		snake.currentDirection = static_cast<Direction>(RandomBelow(game.random, 4));
+		snake.previousDirection = snake.currentDirection;
+
+		// Clear the tail.
+		snake.tailFront = 0;
+		snake.tailLength = 0;
+
+		// Only the head is left on the board.
+		OccupyCell(snake.occupancy, snake.currentPosition);
+	}
+
+
+	template <typename Rules>
+	void EatAppleOnCollision(Snake& snk, Game& gm) {
+		// Snake didn't collide with an apple.
+		if ((snk.currentPosition.x != gm.apple.position.x) || (snk.currentPosition.y != gm.apple.position.y))
+			return;
+
+		// Apple is no longer on the screen when the snake eats it.
+		gm.isAppleOnScreen = false;
+
+		// Increase length of the snake's tail.
+		for (unsigned int i = 0; i < Rules::GrowthPerApple(gm); i++)
+			MakeTailPiece(snk);
+
+		// Increase the score whenever the snake eats an apple.
+		gm.currentScore = AddPoints(gm.currentScore, CalcScore<Rules>(snk, gm));
+
+		// Spawn a new apple.
+		SpawnApple<Rules>(gm, snk);
+
+		// Not a single cell left for it, the snake filled the board.
+		if (!gm.isAppleOnScreen && !gm.isItemOnScreen)
+			EndGame(gm, true);
+	}
+
+
+	template <typename Rules>
+	unsigned int CalcScore(const Snake& snake, const Game& game) {
+		return Rules::ScoreForTail(game, snake.tailLength);
+	}
+
+
+	template <typename Rules>
+	void SpawnApple(Game& game, Snake& snake) {
+		// Can't spawn an apple if there's already one on the screen.
+		if (game.isAppleOnScreen)	return;
+
+		TraceBegin("SpawnApple");
+
+		// Calculate its position.
+		// There's no apple at all when the snake left no room for one.
+		Vector2D randomPos;
+		bool isPositionFound = PickRandomApplePos<Rules>(snake, game, randomPos);
+
+		TraceEnd("SpawnApple");
+
+		if (!isPositionFound)
+			return;
+
+		// Initialize this apple.
+		InitApple(game.apple, randomPos);
+
+		// Since the apple has been created, the flag will be updated.
+		game.isAppleOnScreen = true;
+	}
+
+
+	template <typename Rules>
+	bool PickRandomApplePos(Snake& s, Game& g, Vector2D& p) {
+		int width = Rules::BoardWidth(g) - Constants::X_MIN;
+		int height = Rules::BoardHeight(g) - Constants::Y_MIN;
+
+		// Try random spots first, it's quick as long as the board isn't crowded.
+		for (unsigned int i = 0; i < Constants::MAX_APPLE_PICK_TRIES; i++) {
+			// Get the random position between min and max.
+			p.x = static_cast<int>(RandomBelow(g.random, width)) + Constants::X_MIN;
+			p.y = static_cast<int>(RandomBelow(g.random, height)) + Constants::Y_MIN;
+
+			if (IsAppleCellFree<Rules>(s, g, p.x, p.y))
+				return true;
+		}
+
+		// The board is crowded, go through the cells the snake isn't on from a random one on until one
+		// of them is free for an apple. Only the item and the cell the head just left get skipped,
+		// along with the listed cells the snake took since. Those are never more than half of them.
+		// They're only listed the first time it gets this crowded, and kept up to date from then on.
+		Occupancy& occupancy = s.occupancy;
+		ListFreeCells(occupancy);
+
+		std::size_t totalListedCells = occupancy.freeCells.size();
+		if (totalListedCells == occupancy.totalStaleCells)
+			return false;
+
+		std::size_t start = RandomBelow(g.random, static_cast<uint32_t>(totalListedCells));
+
+		for (std::size_t i = 0; i < totalListedCells; i++) {
+			std::size_t slot = start + i;
+			if (slot >= totalListedCells)
+				slot -= totalListedCells;
+
+			uint64_t cell = occupancy.freeCells[slot];
+			p.x = static_cast<int>(cell >> 32) + Constants::X_MIN;
+			p.y = static_cast<int>(cell & 0xFFFFFFFF) + Constants::Y_MIN;
+
+			if (IsAppleCellFree<Rules>(s, g, p.x, p.y))
+				return true;
+		}
+
+		// Not a single free cell.
+		return false;
+	}
+
+
+	template <typename Rules>
+	bool IsAppleCellFree(const Snake& s, const Game& g, const int x, const int y) {
+		// Apples don't go in walls, nor outside the level's apple zones.
+		if (Rules::IsWall(g, x, y) || !Rules::IsAppleZone(g, x, y))
+			return false;
+
+		// Check every single piece of the snake, including the head, to see
+		// if it happens to be in the same spot.
+
+		// Head.
+		if ((s.currentPosition.x == x) && (s.currentPosition.y == y))
+			return false;
+
+		// Items take a cell too.
+		if (g.isItemOnScreen && (g.item.position.x == x) && (g.item.position.y == y))
+			return false;
+
+		// The tail is about to move into the cell the head just left, so that one isn't free either.
+		if ((s.tailLength > 0) && (s.previousPosition.x == x) && (s.previousPosition.y == y))
+			return false;
+
+		// Tail.
+		return CountOccupants(s.occupancy, x, y) == 0;
+	}
+
+
+	template <typename Rules>
+	void UpdateTimers(Game& game, Snake& snake) {
+		// Handle every timer expiring on this tick.
+		AdvanceTimers(game.timers, [&game, &snake](const uint32_t event, const uint32_t) {
+			HandleTimerEvent<Rules>(game, snake, static_cast<TimerEvent>(event));
+		});
+	}
+
+
+	template <typename Rules>
+	void HandleTimerEvent(Game& game, Snake& snake, const TimerEvent event) {
+		switch (event) {
+			// Time for a new item, and for the next one after it.
+			case TimerEvent::SPAWN_ITEM:
+				SpawnItem<Rules>(game, snake);
+				ScheduleTimer(game.timers, Constants::ITEM_SPAWN_TICKS, static_cast<uint32_t>(TimerEvent::SPAWN_ITEM), 0);
+				break;
+			// Nobody ate the item in time.
+			case TimerEvent::ITEM_EXPIRED:
+				game.isItemOnScreen = false;
+				break;
+			// Effects last as long as their timer is pending, there's nothing left to do.
+			case TimerEvent::EFFECT_OVER:
+				break;
+		}
+	}
+
+
+	template <typename Rules>
+	void SpawnItem(Game& game, Snake& snake) {
+		// Only one item at a time.
+		if (game.isItemOnScreen)	return;
+
+		TraceBegin("SpawnItem");
+
+		// Same spots as apples, but not the apple's own.
+		Vector2D position;
+		bool isPositionFound = PickRandomApplePos<Rules>(snake, game, position) &&
+				!(game.isAppleOnScreen && (game.apple.position.x == position.x) && (game.apple.position.y == position.y));
+
+		if (isPositionFound) {
+			// Any kind of item is as likely.
+			ItemKind kind = static_cast<ItemKind>(RandomBelow(game.random, 3));
+			InitItem(game.item, kind, position);
+
+			// It doesn't stay there forever.
+			game.item.expiryTimer = ScheduleTimer(game.timers, Constants::ITEM_LIFETIME_TICKS, static_cast<uint32_t>(TimerEvent::ITEM_EXPIRED), 0);
+			game.isItemOnScreen = true;
+		}
+
+		TraceEnd("SpawnItem");
+	}
+
+
+	template <typename Rules>
+	void EatItemOnCollision(Snake& snk, Game& gm) {
+		// Snake didn't collide with an item.
+		if (!gm.isItemOnScreen || (snk.currentPosition.x != gm.item.position.x) || (snk.currentPosition.y != gm.item.position.y))
+			return;
+
+		// The item is gone, and so is its expiry.
+		gm.isItemOnScreen = false;
+		CancelTimer(gm.timers, gm.item.expiryTimer);
+
+		switch (gm.item.kind) {
+			// Worth a lot of points, but the snake doesn't grow.
+			case ItemKind::BONUS_APPLE:
+				gm.currentScore = AddPoints(gm.currentScore, Constants::BONUS_APPLE_POINTS);
+				break;
+			// Eating another one while it lasts starts it over.
+			case ItemKind::SPEED_BOOST:
+				CancelTimer(gm.timers, gm.effects.speedBoost);
+				gm.effects.speedBoost = ScheduleTimer(gm.timers, Constants::SPEED_BOOST_TICKS, static_cast<uint32_t>(TimerEvent::EFFECT_OVER), 0);
+				break;
+			case ItemKind::INVINCIBILITY:
+				CancelTimer(gm.timers, gm.effects.invincibility);
+				gm.effects.invincibility = ScheduleTimer(gm.timers, Constants::INVINCIBILITY_TICKS, static_cast<uint32_t>(TimerEvent::EFFECT_OVER), 0);
+				break;
+		}
+	}
+
+} /* namespace TextSnake */
+
+#endif /* SNAKERULES_H_ */
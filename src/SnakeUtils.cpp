@@ -8,33 +8,113 @@
 #include "SnakeUtils.h"
 
 #include <ctime>
+#include <cerrno>
 #include <cmath>
-#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <algorithm>
+#include <bitset>
+#include <charconv>
+#include <chrono>
+#include <utility>
+
+#include "SnakeRules.h"
+#include "GlyphUtils.h"
+#include "ReplayUtils.h"
+#include "JournalUtils.h"
+#include "TraceUtils.h"
+#include "StatsUtils.h"
 
 namespace TextSnake {
 
-	void Start() {
-		// Seed the random number generator.
-		srand(time(0));
+	void Start(const uint64_t seed, const char* levelFilename, const bool isWrapModeOn, const char* statsName,
+	           const bool isTracingStartup) {
+		// Time everything up to the first frame.
+		StartupTrace startupTrace;
+		StartStartupTrace(startupTrace, isTracingStartup);
 
-		// Initialize Curses.
-		CursesUtils::InitCurses(true, false, false, true, true, 0);
+		// Load the level before anything gets shown.
+		Level level;
+		if (levelFilename != nullptr && !LoadLevel(level, levelFilename)) {
+			std::fprintf(stderr, "Couldn't load level %s\n", levelFilename);
+			return;
+		}
+		EndStartupPhase(startupTrace, "level");
+
+		// Publish live stats for monitors when asked to, before curses takes the terminal so failures can be told.
+		LiveStatsPublisher statsPublisher;
+		bool isPublishingStats = false;
+		if (statsName != nullptr) {
+			if (!OpenLiveStats(statsPublisher, statsName)) {
+				if (errno == EEXIST)
+					std::fprintf(stderr, "Live stats name %s is in use, remove /dev/shm%s if no game is running with it\n", statsName, statsName);
+				else
+					std::fprintf(stderr, "Couldn't publish live stats as %s\n", statsName);
+
+				if (levelFilename != nullptr)
+					UnloadLevel(level);
+				return;
+			}
+
+			isPublishingStats = true;
+		}
+		EndStartupPhase(startupTrace, "stats");
+
+		// Initialize Curses, counting what it writes when there are stats to publish it in.
+		CursesUtils::InitCurses(true, false, false, true, true, 0, isPublishingStats);
+
+		// Catch terminal resizes.
+		CursesUtils::InstallResizeHandler();
+		EndStartupPhase(startupTrace, "curses");
 
 		// Initializations.
 		Game mainGame;
 		Snake theSnake;
 
+		// Play on the level when there's one.
+		mainGame.level = (levelFilename != nullptr) ? &level : nullptr;
+
+		// High scores get saved in the background.
+		ScoreSaver scoreSaver;
+		StartScoreSaver(scoreSaver, Constants::HIGH_SCORES_JOURNAL_FILENAME, Constants::HIGH_SCORES_FILENAME,
+		                Constants::HIGH_SCORES_COMPACTION_SIZE, Constants::MAX_HIGH_SCORES);
+		mainGame.scoreSaver = &scoreSaver;
+
+		// High scores get loaded in the background once the first frame is on screen, nothing needs them before.
+		ScoreLoader scoreLoader;
+		InitScoreLoader(scoreLoader, Constants::HIGH_SCORES_JOURNAL_FILENAME, Constants::HIGH_SCORES_FILENAME,
+		                Constants::MAX_HIGH_SCORES);
+		mainGame.scoreLoader = &scoreLoader;
+
+		// Every game gets played on the same kind of board.
+		mainGame.isWrapModeOn = isWrapModeOn;
+
+		// Cache the screen's size, the board will cover all of it unless there's a level.
+		mainGame.layout.generation = 0;
+		mainGame.layout.screenSize.x = CursesUtils::GetColumns();
+		mainGame.layout.screenSize.y = CursesUtils::GetRows();
+
+		// Seed the game's own random number generator, so its state can be saved in replays.
+		SeedRandom(mainGame.random, seed);
+
+		// No high scores until they're loaded.
+		InitLeaderboard(mainGame.highScores);
+
 		FirstInit(mainGame, theSnake);
+		EndStartupPhase(startupTrace, "game");
 
 		// Initialize all menu entries.
 		InitMenu(mainGame);
-
-		// Load high scores only once when the application is run.
-		LoadHighScores(mainGame);
+		EndStartupPhase(startupTrace, "menu");
 
 		// Make color pairs.
 		InitColors();
+		EndStartupPhase(startupTrace, "colors");
+
+		// Build every glyph once, in Unicode when the terminal can show it.
+		InitGlyphTable(glyphTable, CursesUtils::HasWideCharacters());
+		EndStartupPhase(startupTrace, "glyphs");
 
 		// Flag that tells the game loop when to quit.
 		bool quit = false;
@@ -42,12 +122,12 @@ namespace TextSnake {
 		// Used for the input handling.
 		int input = 0;
 
-		// FPS needs to be adjusted because the screen is larger than longer,
-		// which means that the snake is faster when moving vertically.
-		unsigned int adjustedFPS = Constants::DEFAULT_FPS;
+		// Records every game played, so it can be watched later on.
+		ReplayRecorder recorder;
+		recorder.isRecording = false;
 
-		// Take the time at the start of the game.
-		clock_t lastTime = clock();
+		// Take the time at the start of the game, a frame ago so the first one is drawn right away.
+		clock_t lastTime = clock() - (CLOCKS_PER_SEC / Constants::LOOP_FPS) - 1;
 
 		// Game loop.
 		while (!quit) {
@@ -57,45 +137,166 @@ namespace TextSnake {
 			clock_t deltaTime = currentTime - lastTime;
 
 			// Only run game logic in respect to the wanted frame rate.
-			if (deltaTime > (CLOCKS_PER_SEC / adjustedFPS)) {
+			if (deltaTime > (CLOCKS_PER_SEC / Constants::LOOP_FPS)) {
 				// Update the last time to be the current time.
 				lastTime = currentTime;
 
+				// Time spent on this frame, for the stats.
+				std::chrono::steady_clock::time_point frameStart;
+				if (isPublishingStats) {
+					frameStart = std::chrono::steady_clock::now();
+					CountLateTicks(statsPublisher, deltaTime);
+				}
+
+				// Whether this frame got drawn.
+				bool isRepainting = false;
+
+				// Lay everything out again when the terminal got resized.
+				if (CursesUtils::HandlePendingResize()) {
+					ResizeScreen(mainGame, CursesUtils::GetColumns(), CursesUtils::GetRows());
+
+					// The cells' shape might have changed too.
+					UpdateMoveTiming(mainGame, CursesUtils::GetCellAspectRatio());
+
+					// The recording needs to know about the new timing.
+					if (recorder.isRecording)
+						recorder.isKeyframeNeeded = true;
+				}
+
+				TraceBegin("Frame");
+
 				// Handle the input from the user.
+				TraceBegin("HandleInput");
 				HandleInput(input, mainGame, theSnake);
+				TraceEnd("HandleInput");
 
 				// Whenever the user hits the quit button the game ends, otherwise it goes on normally.
 				if (input != Constants::QUIT_BUTTON) {
-					// Clear the screen before updating and drawing the next frame.
-					CursesUtils::ClearScreen();
+					// Start recording as soon as a new game begins, before its first tick.
+					if (!recorder.isRecording && mainGame.currentState == State::SHOW_MAIN_GAME)
+						BeginRecording(recorder, mainGame, theSnake);
 
-					// Adjusting FPS.
-					adjustedFPS = AdjustFPSbasedOnDirection(theSnake);
+					// Store this tick's input before it gets simulated.
+					if (recorder.isRecording)
+						RecordTick(recorder, mainGame, theSnake, input);
 
 					// Update the game logic.
+					TraceBegin("Update");
 					Update(mainGame, theSnake, input);
-
-					// Draw the game.
-					Draw(mainGame, theSnake);
-
-					// Refresh the screen to show the up to date game.
-					CursesUtils::RefreshScreen();
+					TraceEnd("Update");
+
+					// The recording is over once the game is.
+					if (recorder.isRecording && mainGame.currentState != State::SHOW_MAIN_GAME)
+						EndRecording(recorder, Constants::REPLAY_FILENAME);
+
+					// Only repaint when there's something new to show.
+					isRepainting = UpdateScreenCache(mainGame);
+					if (isRepainting) {
+						// Clear the screen before drawing the next frame.
+						CursesUtils::ClearScreen();
+
+						// Draw the game.
+						TraceBegin("Draw");
+						Draw(mainGame, theSnake);
+						TraceEnd("Draw");
+
+						// Refresh the screen to show the up to date game.
+						TraceBegin("RefreshScreen");
+						CursesUtils::RefreshScreen();
+						TraceEnd("RefreshScreen");
+					}
 				} else {
+					// Save what has been played so far.
+					if (recorder.isRecording)
+						EndRecording(recorder, Constants::REPLAY_FILENAME);
+
 					// Quitting...
 					quit = true;
 				}
+
+				// Everything is on screen, the high scores can be read now without holding the first frame up.
+				if (!scoreLoader.isStarted) {
+					EndStartupPhase(startupTrace, "first frame");
+					StartScoreLoader(scoreLoader);
+				}
+
+				// Let the monitors know how the game is doing.
+				if (isPublishingStats) {
+					std::chrono::duration<uint64_t, std::nano> frameTime = std::chrono::steady_clock::now() - frameStart;
+					PublishGameStats(statsPublisher, mainGame, theSnake, frameTime.count(), isRepainting);
+				}
+
+				TraceEnd("Frame");
 			}
 		}
 
 		// Make sure Curses gets shut down.
 		CursesUtils::ShutdownCurses();
+
+		// Don't leave before the last high score is on disk.
+		StopScoreSaver(scoreSaver);
+
+		// The loading thread has to be done before the loader goes away, there's no point loading them now though.
+		StopScoreLoader(scoreLoader);
+
+		if (isTracingStartup) {
+			PrintStartupTrace(startupTrace, stderr);
+
+			if (!scoreLoader.isStarted) {
+				std::fprintf(stderr, "High scores: never needed, never loaded\n");
+			} else {
+				// Scores the game never asked for are still with the loader.
+				const Leaderboard& loaded = (mainGame.scoreLoader == nullptr) ? mainGame.highScores : scoreLoader.highScores;
+				std::fprintf(stderr, "High scores: %zu loaded in %.3f ms in the background, the game waited %.3f ms for them\n",
+				             GetLeaderboardSize(loaded), scoreLoader.loadNanos / 1e6, scoreLoader.waitNanos / 1e6);
+			}
+		}
+
+		if (isPublishingStats)
+			CloseLiveStats(statsPublisher);
+
+		if (mainGame.level != nullptr)
+			UnloadLevel(level);
+	}
+
+
+	void CountLateTicks(LiveStatsPublisher& publisher, const clock_t deltaTime) {
+		clock_t tickTime = CLOCKS_PER_SEC / Constants::LOOP_FPS;
+
+		// The loop normally runs right after a tick's worth of time, anything past two means it fell behind.
+		if (deltaTime >= 2 * tickTime) {
+			publisher.stats.lateTicks++;
+			publisher.stats.droppedTicks += static_cast<uint64_t>(deltaTime / tickTime) - 1;
+		}
+	}
+
+
+	void PublishGameStats(LiveStatsPublisher& publisher, const Game& game, const Snake& snake, const uint64_t frameNanos, const bool isRepainting) {
+		LiveStats& stats = publisher.stats;
+
+		stats.ticks++;
+		if (isRepainting)
+			stats.frames++;
+
+		stats.score = game.currentScore;
+		stats.length = GetTailLength(snake) + 1;
+		stats.terminalBytes = CursesUtils::GetTerminalBytes();
+
+		RecordFrameTime(publisher, frameNanos);
+
+		// The slow ones only get worked out every now and then.
+		if (stats.ticks % Constants::STATS_SLOW_UPDATE_TICKS == 0)
+			UpdateSlowStats(publisher);
+
+		PublishLiveStats(publisher);
 	}
 
 
 	void FirstInit(Game& gm, Snake& snk) {
 		// Initialize everything.
 		InitGame(gm);
-		InitSnake(snk);
+		UpdateMoveTiming(gm, CursesUtils::GetCellAspectRatio());
+		InitSnake(snk, gm);
 		SpawnApple(gm, snk);
 	}
 
@@ -105,23 +306,32 @@ namespace TextSnake {
 		CursesUtils::MakeColorPair(Constants::GREEN_ON_BLACK_ID, CursesUtils::Color::GREEN, CursesUtils::Color::BLACK);
 		// Make a red for the apple.
 		CursesUtils::MakeColorPair(Constants::RED_ON_BLACK_ID, CursesUtils::Color::RED, CursesUtils::Color::BLACK);
+		// Make a yellow for the items.
+		CursesUtils::MakeColorPair(Constants::YELLOW_ON_BLACK_ID, CursesUtils::Color::YELLOW, CursesUtils::Color::BLACK);
 	}
 
 
-	void InitSnake(Snake& s) {
-		// Get the middle point of the screen.
-		unsigned int midX = CursesUtils::GetColumns() / 2;
-		unsigned int midY = CursesUtils::GetRows() / 2;
+	void InitSnake(Snake& s, Game& g) {
+		// Get the middle point of the board.
+		unsigned int midX = g.boardSize.x / 2;
+		unsigned int midY = g.boardSize.y / 2;
 
 		// Set the snake's current and previous positions to be the middle of the screen.
 		s.currentPosition.x = midX;
 		s.currentPosition.y = midY;
 
-		s.previousPosition.x = midX;
-		s.previousPosition.y = midY;
+		// Levels tell where the snake starts.
+		const LevelSpawn* spawn = RuntimeRules::PickSpawn(g, g.random);
+		if (spawn != nullptr) {
+			s.currentPosition.x = spawn->x + Constants::X_MIN;
+			s.currentPosition.y = spawn->y + Constants::Y_MIN;
+		}
+
+		s.previousPosition.x = s.currentPosition.x;
+		s.previousPosition.y = s.currentPosition.y;
 
 		// Random number between 0 and 3.
-		int randDir = rand() % 4;
+		int randDir = static_cast<int>(RandomBelow(g.random, 4));
 
 		// Set the direction to be a random one among the 4 available ones.
 		s.currentDirection = static_cast<Direction>(randDir);
@@ -135,11 +345,22 @@ namespace TextSnake {
 		// Default speed.
 		s.speed = Constants::SNAKE_DEFAULT_SPEED;
 
+		// The snake hasn't started moving towards the next cell yet.
+		s.moveProgress = 0;
+
 		// Default color.
 		s.color = Constants::DEFAULT_COLOR;
 
-		// Tail vector should be empty.
-		if (s.tail.size() > 0)	s.tail.clear();
+		// The tail should be empty.
+		s.tailFront = 0;
+		s.tailLength = 0;
+
+		// The tail can't get longer than the board, so make room for all of it up front
+		// and never allocate while playing. Huge levels only get room for a long snake.
+		s.tail.resize(std::min(static_cast<std::size_t>(g.boardSize.x) * g.boardSize.y, Constants::MAX_RESERVED_TAIL_PIECES));
+
+		// Only the head is on the board.
+		InitOccupancy(s, g);
 	}
 
 
@@ -153,9 +374,46 @@ namespace TextSnake {
 		// Score is 0 at the start.
 		g.currentScore = 0;
 
+		// Nobody won yet.
+		g.isWon = false;
+
+		// No timers, items nor effects yet, but the first item is on its way.
+		InitTimerWheel(g.timers, Constants::RESERVED_TIMERS);
+		g.isItemOnScreen = false;
+		g.effects.speedBoost = NO_TIMER;
+		g.effects.invincibility = NO_TIMER;
+		g.effects.respawn = NO_TIMER;
+		ScheduleTimer(g.timers, Constants::ITEM_SPAWN_TICKS, static_cast<uint32_t>(TimerEvent::SPAWN_ITEM), 0);
+
+		// No animations playing either.
+		InitScripts(g);
+
+		// The board covers the whole screen, or the whole level below the HUD.
+		if (g.level != nullptr) {
+			g.boardSize.x = g.level->width + Constants::X_MIN;
+			g.boardSize.y = g.level->height + Constants::Y_MIN;
+		} else {
+			g.boardSize.x = g.layout.screenSize.x;
+			g.boardSize.y = g.layout.screenSize.y;
+		}
+		UpdateLayout(g);
+
+		// Default rules, the borders are walls unless the game was started in wrap mode.
+		g.rules.isWrapping = g.isWrapModeOn;
+		g.rules.growthPerApple = Constants::GROWTH_PER_APPLE;
+		g.rules.baseApplePoints = Constants::BASE_APPLE_POINTS;
+		g.rules.scoreMultiplier = Constants::SCORE_MULTIPLIER;
+
 		// There's no final score when initializing.
 		g.finalScore.name = "PLAYER";
 		g.finalScore.score = 0;
+		g.finalRank = 0;
+
+		// High scores are shown from the top.
+		g.highScoresPage = 0;
+
+		// Nothing has been laid out yet.
+		g.screenCache.isValid = false;
 
 		// Selector is standing still.
 		g.selectorDirection = SelectorDirection::STILL;
@@ -178,12 +436,6 @@ namespace TextSnake {
 
 
 	void InitMenu(Game& game) {
-		// Position to use.
-		Vector2D pos;
-		// Set the y position.
-		// Take into account the position of the intro.
-		pos.y = static_cast<int>(CursesUtils::GetRows() / 2) - Constants::INTRO_TEXT_OFFSET;
-
 		// Entries.
 		MenuEntry entries[Constants::TOTAL_MAIN_MENU_ENTRIES];
 
@@ -197,32 +449,71 @@ namespace TextSnake {
 
 		// Set all the entries.
 		for (std::size_t i = 0; i < Constants::TOTAL_MAIN_MENU_ENTRIES; i++) {
+			// The first entry gets automatically selected.
+			entries[i].isSelected = (i == 0);
+			entries[i].attribute = CursesUtils::Attribute::NORMAL;
+		}
+
+		// Add the entries to the vector.
+		for (std::size_t i = 0; i < Constants::TOTAL_MAIN_MENU_ENTRIES; i++)
+			game.mainMenuEntries.push_back(entries[i]);
+
+		// Place them on the screen.
+		PositionMenuEntries(game);
+	}
+
+
+	void PositionMenuEntries(Game& game) {
+		// Position to use.
+		Vector2D pos;
+		// Set the y position.
+		// Take into account the position of the intro.
+		pos.y = game.layout.screenCenter.y - Constants::INTRO_TEXT_OFFSET;
+
+		for (std::size_t i = 0; i < game.mainMenuEntries.size(); i++) {
 			// Reset the x position to void the previous movement.
-			pos.x = static_cast<int>(CursesUtils::GetColumns() / 2);
+			pos.x = game.layout.screenCenter.x;
 			// Center the entry based on the string's length.
-			pos.x -= static_cast<int>(std::strlen(entries[i].text.c_str()) / 2);
+			pos.x -= static_cast<int>(game.mainMenuEntries[i].text.length() / 2);
 
 			// The first entry will have a special offset.
-			// The first entry gets automatically selected.
-			if (i == 0) {
-				pos.y += Constants::MENU_TEXT_DIST + Constants::FIRST_ENTRY_TEXT_OFFSET;
-
-				entries[i].isSelected = true;
-			} else {
-				pos.y += Constants::MENU_TEXT_DIST;
-
-				entries[i].isSelected = false;
-			}
+			if (i == 0)	pos.y += Constants::MENU_TEXT_DIST + Constants::FIRST_ENTRY_TEXT_OFFSET;
+			else		pos.y += Constants::MENU_TEXT_DIST;
 
 			// Set the entry.
-			entries[i].position.x = pos.x;
-			entries[i].position.y = pos.y;
-			entries[i].attribute = CursesUtils::Attribute::NORMAL;
+			game.mainMenuEntries[i].position.x = pos.x;
+			game.mainMenuEntries[i].position.y = pos.y;
 		}
+	}
 
-		// Add the entries to the vector.
-		for (std::size_t i = 0; i < Constants::TOTAL_MAIN_MENU_ENTRIES; i++)
-			game.mainMenuEntries.push_back(entries[i]);
+
+	void ResizeScreen(Game& game, const int columns, const int rows) {
+		// New screen size.
+		game.layout.screenSize.x = columns;
+		game.layout.screenSize.y = rows;
+
+		// Anything drawn based on the old size is out of date.
+		game.layout.generation++;
+
+		UpdateLayout(game);
+	}
+
+
+	void UpdateLayout(Game& game) {
+		// Middle of the screen.
+		game.layout.screenCenter.x = game.layout.screenSize.x / 2;
+		game.layout.screenCenter.y = game.layout.screenSize.y / 2;
+
+		// The board keeps its size, it gets centered in the screen with empty space around it
+		// when the screen is bigger. When the screen is smaller whatever doesn't fit is cut off.
+		game.layout.boardOffset.x = std::max(0, (game.layout.screenSize.x - game.boardSize.x) / 2);
+		game.layout.boardOffset.y = std::max(0, (game.layout.screenSize.y - game.boardSize.y) / 2);
+
+		// Menu entries are centered in the screen.
+		PositionMenuEntries(game);
+
+		// Whatever was laid out for the old size has to be laid out again.
+		InvalidateScreenCache(game);
 	}
 
 
@@ -230,6 +521,12 @@ namespace TextSnake {
 		// Store the current input.
 		inpt = CursesUtils::GetCharacter();
 
+		// Act on it.
+		ApplyInput(inpt, g, s);
+	}
+
+
+	void ApplyInput(const int inpt, Game& g, Snake& s) {
 		// Check what kind of input the user entered.
 		switch (inpt) {
 			case static_cast<int>(CursesUtils::ArrowKey::UP): {
@@ -245,6 +542,12 @@ namespace TextSnake {
 
 					// Selector is moving up.
 					g.selectorDirection = SelectorDirection::UP;
+				} else if (g.currentState == State::SHOW_HIGH_SCORES) {
+					// Go to the previous page of high scores.
+					if (g.highScoresPage > 0) {
+						g.highScoresPage--;
+						InvalidateScreenCache(g);
+					}
 				}
 			}
 				break;
@@ -272,6 +575,12 @@ namespace TextSnake {
 
 					// Selector moves down.
 					g.selectorDirection = SelectorDirection::DOWN;
+				} else if (g.currentState == State::SHOW_HIGH_SCORES) {
+					// Go to the next page of high scores, if there's one.
+					if ((g.highScoresPage + 1) * Constants::MAX_HIGH_SCORES_ON_SCREEN < GetLeaderboardSize(g.highScores)) {
+						g.highScoresPage++;
+						InvalidateScreenCache(g);
+					}
 				}
 			}
 				break;
@@ -305,14 +614,18 @@ namespace TextSnake {
 	void EnterKeyPressed(Game& game, Snake& snake) {
 		// Change the current state to high scores when the user pressed enter from within the game over screen.
 		if (game.currentScreen == Screen::GAME_OVER) {
-			// Add new high score.
-			game.highScores.push_back(game.finalScore);
+			// Add new high score in its place.
+			std::size_t rank = InsertScore(game.highScores, game.finalScore);
+
+			// Only keep the best ones.
+			if (GetLeaderboardSize(game.highScores) > Constants::MAX_HIGH_SCORES)
+				RemoveLowestScore(game.highScores);
 
-			// Sort them out in descending order.
-			std::sort(game.highScores.begin(), game.highScores.end(), GetHigher);
+			// Show the page where the new high score is.
+			game.highScoresPage = rank / Constants::MAX_HIGH_SCORES_ON_SCREEN;
 
-			// Save high scores.
-			SaveHighScores(game);
+			// Save the new high score.
+			SaveHighScore(game, game.finalScore);
 
 			game.currentState = State::SHOW_HIGH_SCORES;
 
@@ -350,7 +663,8 @@ namespace TextSnake {
 				game.currentState = State::SHOW_MAIN_GAME;
 				break;
 			case Screen::HIGH_SCORES:
-				// Show the high scores.
+				// Show the high scores from the top.
+				game.highScoresPage = 0;
 				game.currentState = State::SHOW_HIGH_SCORES;
 				break;
 			case Screen::GAME_OVER:
@@ -359,87 +673,62 @@ namespace TextSnake {
 	}
 
 
-	void SaveHighScores(const Game& gm) {
-		// Make an output file stream for binary.
-		std::ofstream writeFile;
-
-		// Open the file or make a new one if it didn't exist before.
-		writeFile.open(Constants::HIGH_SCORES_FILENAME, std::ios_base::binary);
-
-		// Only write to the file if it was opened.
-		if (writeFile.is_open()) {
-			// Store the values of the vector into an array.
-			Score hScores[gm.highScores.size()];
-			std::copy(gm.highScores.begin(), gm.highScores.end(), hScores);
-
-			// Write high scores to the file.
-			writeFile.write(reinterpret_cast<char*>(hScores), sizeof(hScores));
-
-			// Close the file.
-			writeFile.close();
+	void SaveHighScore(Game& game, const Score& score) {
+		// Let the saving thread deal with the disk, the game over screen shouldn't wait for it.
+		if (game.scoreSaver != nullptr) {
+			QueueScore(*game.scoreSaver, score);
+			return;
 		}
-	}
-
 
-	bool GetHigher(const Score& score1, const Score& score2) {
-		return (score1.score > score2.score) ? true : false;
+		// Append the score to the journal, other games running at the same time can do the same safely.
+		AppendScoreToJournal(score, Constants::HIGH_SCORES_JOURNAL_FILENAME, Constants::HIGH_SCORES_FILENAME,
+		                     Constants::HIGH_SCORES_COMPACTION_SIZE, Constants::MAX_HIGH_SCORES);
 	}
 
 
-	void LoadHighScores(Game& gm) {
-		// Make an input file stream for binary.
-		std::ifstream readFile;
-
-		// Open the file in binary mode.
-		readFile.open(Constants::HIGH_SCORES_FILENAME, std::ios_base::binary);
-
-		// Only read if the file was opened.
-		if (readFile.is_open()) {
-			// Figure out the size of the file in bytes.
-			readFile.seekg(0, readFile.end);
-			long fileSizeInBytes = readFile.tellg();
-			readFile.seekg(0);
+	void EnsureHighScoresLoaded(Game& gm) {
+		if (gm.scoreLoader == nullptr)
+			return;
 
-			// Figure out how many high scores are in the file.
-			int numberOfHighScores = fileSizeInBytes / sizeof(Score);
-			// Allocate a buffer for the high scores.
-			Score hScores[numberOfHighScores];
+		// Take the leaderboard the loader built.
+		Leaderboard loaded;
+		FinishScoreLoader(*gm.scoreLoader, loaded);
+		gm.scoreLoader = nullptr;
 
-			// Read the high scores into the buffer.
-			readFile.read(reinterpret_cast<char*>(hScores), fileSizeInBytes);
+		// Scores added meanwhile are newer than every loaded one.
+		std::vector<Score> added;
+		GetAllScores(gm.highScores, added);
+		for (std::size_t i = 0; i < added.size(); i++)
+			InsertScore(loaded, added[i]);
 
-			// Put the high scores back into the vector.
-			for (std::size_t i = 0; i < numberOfHighScores; i++)
-				gm.highScores.push_back(hScores[i]);
+		// Only keep the best ones.
+		while (GetLeaderboardSize(loaded) > Constants::MAX_HIGH_SCORES)
+			RemoveLowestScore(loaded);
 
-			// Close the file.
-			readFile.close();
-		}
+		gm.highScores = std::move(loaded);
 	}
 
 
-	unsigned int AdjustFPSbasedOnDirection(const Snake& snake) {
-		// True when the direction is up or down.
-		bool isMovingVertically = (snake.currentDirection == Direction::UP) || (snake.currentDirection == Direction::DOWN);
-
-		// Get the screen width and height.
-		int width = 0;
-		int height = 0;
-		CursesUtils::GetWindowSize(width, height);
-
-		// Get the width/height ratio and make some calculations on it to get a more precise number.
-		int whRatio =  static_cast<int>(ceil(width / height)) + 2;
+	void UpdateMoveTiming(Game& game, float cellAspectRatio) {
+		// Terminals that don't tell their cells' size get the most common shape.
+		if (cellAspectRatio <= 0.0f)
+			cellAspectRatio = Constants::DEFAULT_CELL_ASPECT_RATIO;
 
-		// Calculate the new fps for the vertical movement, which is based on the height of the screen.
-		int vFPS = static_cast<int>(ceil(height / whRatio));
-
-		// When the snake is moving vertically, change the frame rate to adjust the movement speed to be equal
-		// on both horizontal and vertical directions.
-		return isMovingVertically ? vFPS : Constants::DEFAULT_FPS;
+		// Everything is measured in fractions of a cell's width, so the snake can be partway through a cell.
+		// Every frame the snake travels SNAKE_CELLS_PER_SECOND cell widths, and it takes LOOP_FPS of those
+		// to cross a cell horizontally, so it crosses SNAKE_CELLS_PER_SECOND cells per second.
+		// Cells are taller than they're wide, so crossing one vertically takes proportionally longer,
+		// which makes the snake just as fast on screen in every direction.
+		game.moveTiming.distancePerFrame = static_cast<uint64_t>(Constants::SNAKE_CELLS_PER_SECOND) * Constants::MOVE_PRECISION;
+		game.moveTiming.horizontalCellCost = static_cast<uint64_t>(Constants::LOOP_FPS) * Constants::MOVE_PRECISION;
+		game.moveTiming.verticalCellCost = static_cast<uint64_t>(Constants::LOOP_FPS * Constants::MOVE_PRECISION * cellAspectRatio + 0.5f);
 	}
 
 
 	void Update(Game& g, Snake& s, int in) {
+		// Scripts get the input before a new screen's ones start, so the key showing it doesn't reach them.
+		UpdateScripts(g, in);
+
 		// Updates the current screen when the state changes.
 		UpdateScreen(g);
 
@@ -467,27 +756,30 @@ namespace TextSnake {
 	void Draw(const Game& g, const Snake& s) {
 		// Draw the game depending on what screen the game is on.
 		switch (g.currentScreen) {
-			// Draw the main menu screen.
-			case Screen::MAIN_MENU:
-				DrawMainMenu(g);
-				break;
 			// Draw the in game screen.
 			case Screen::MAIN_GAME:
 				DrawMainGame(g, s);
 				break;
-			// Draw game over screen.
+			// The other screens never change on their own, they were laid out already.
+			case Screen::MAIN_MENU:
 			case Screen::GAME_OVER:
-				DrawGameOver(g);
-				break;
-			// Draw the high scores screen.
 			case Screen::HIGH_SCORES:
-				DrawHighScores(g);
+				DrawScreenCache(g);
 				break;
 		}
 	}
 
 
+	void SimulateTick(Game& g, Snake& s, int in) {
+		// Same as a frame of the game loop, minus the drawing.
+		ApplyInput(in, g, s);
+		Update(g, s, in);
+	}
+
+
 	void UpdateScreen(Game& game) {
+		Screen previousScreen = game.currentScreen;
+
 		// Change the current screen based on the current state.
 		switch (game.currentState) {
 			case State::SHOW_MAIN_MENU:
@@ -500,9 +792,115 @@ namespace TextSnake {
 				game.currentScreen = Screen::GAME_OVER;
 				break;
 			case State::SHOW_HIGH_SCORES:
+				// They can't be shown before they're loaded.
+				EnsureHighScoresLoaded(game);
 				game.currentScreen = Screen::HIGH_SCORES;
 				break;
 		}
+
+		// A new screen plays its own animations.
+		if (game.currentScreen != previousScreen)
+			StartScreenScripts(game);
+	}
+
+
+	void InitScripts(Game& game) {
+		Scripts& scripts = game.scripts;
+
+		// A script waits for one thing at a time, there can't be more timers than scripts.
+		InitTimerWheel(scripts.timers, static_cast<std::size_t>(ScriptId::TOTAL));
+
+		for (Script& script : scripts.list)
+			InitScript(script);
+
+		scripts.isMoveHintShown = false;
+		scripts.isSnakeHidden = false;
+	}
+
+
+	void StartScreenScripts(Game& game) {
+		Scripts& scripts = game.scripts;
+
+		// Whatever the previous screen was playing is over.
+		for (Script& script : scripts.list)
+			StopScript(scripts.timers, script);
+
+		scripts.isMoveHintShown = false;
+		scripts.isSnakeHidden = false;
+
+		if (game.currentScreen == Screen::MAIN_GAME)
+			StartScript(game, ScriptId::MOVE_HINT);
+	}
+
+
+	void StartScript(Game& game, const ScriptId id) {
+		StopScript(game.scripts.timers, game.scripts.list[static_cast<std::size_t>(id)]);
+		ResumeScript(game, id);
+	}
+
+
+	void ResumeScript(Game& game, const ScriptId id) {
+		Script& script = game.scripts.list[static_cast<std::size_t>(id)];
+
+		switch (id) {
+			case ScriptId::MOVE_HINT:
+				RunMoveHint(game, script);
+				break;
+			case ScriptId::RESPAWN_BLINK:
+				RunRespawnBlink(game, script);
+				break;
+			case ScriptId::TOTAL:
+				break;
+		}
+	}
+
+
+	void UpdateScripts(Game& game, const int input) {
+		Scripts& scripts = game.scripts;
+
+		// Wake up whoever waits for a key.
+		if (input != ERR) {
+			for (std::size_t i = 0; i < static_cast<std::size_t>(ScriptId::TOTAL); i++) {
+				if (scripts.list[i].wait == ScriptWait::INPUT)
+					ResumeScript(game, static_cast<ScriptId>(i));
+			}
+		}
+
+		// And whoever's ticks are up. Time may as well stand still while nobody waits for any,
+		// so idle screens don't even move the wheel.
+		if (scripts.timers.totalPending > 0) {
+			AdvanceTimers(scripts.timers, [&game](const uint32_t event, const uint32_t) {
+				ResumeScript(game, static_cast<ScriptId>(event));
+			});
+		}
+	}
+
+
+	void RunMoveHint(Game& game, Script& script) {
+		SCRIPT_BEGIN(script);
+
+		game.scripts.isMoveHintShown = true;
+		SCRIPT_WAIT_INPUT(script);
+		game.scripts.isMoveHintShown = false;
+
+		SCRIPT_END(script);
+	}
+
+
+	void RunRespawnBlink(Game& game, Script& script) {
+		uint32_t id = static_cast<uint32_t>(ScriptId::RESPAWN_BLINK);
+
+		SCRIPT_BEGIN(script);
+
+		for (script.counter = 0; script.counter < Constants::RESPAWN_BLINKS; script.counter++) {
+			game.scripts.isSnakeHidden = true;
+			SCRIPT_WAIT_TICKS(script, game.scripts.timers, id, Constants::RESPAWN_BLINK_TICKS);
+
+			game.scripts.isSnakeHidden = false;
+			SCRIPT_WAIT_TICKS(script, game.scripts.timers, id, Constants::RESPAWN_BLINK_TICKS);
+		}
+
+		SCRIPT_END(script);
 	}
 
 
@@ -519,12 +917,12 @@ namespace TextSnake {
 				game.mainMenuEntries[i].isSelected = false;
 
 				// Pick next index based on the selection direction.
-				int nextIndex = 0;
-				if (game.selectorDirection == SelectorDirection::UP)		nextIndex = abs(static_cast<int>(i - 1));
-				else if (game.selectorDirection == SelectorDirection::DOWN)	nextIndex = static_cast<int>(i + 1);
-
-				// Wrap around the entries when the next one isn't available.
-				int nextSelectedIndex = nextIndex % game.mainMenuEntries.size();
+				// Wrap around the entries when the next one isn't available, going up from the first
+				// entry lands on the last one.
+				std::size_t totalEntries = game.mainMenuEntries.size();
+				std::size_t nextSelectedIndex = i;
+				if (game.selectorDirection == SelectorDirection::UP)		nextSelectedIndex = (i + totalEntries - 1) % totalEntries;
+				else if (game.selectorDirection == SelectorDirection::DOWN)	nextSelectedIndex = (i + 1) % totalEntries;
 
 				// Select the next entry.
 				game.mainMenuEntries[nextSelectedIndex].isSelected = true;
@@ -536,15 +934,47 @@ namespace TextSnake {
 
 		// Selector has done moving.
 		game.selectorDirection = SelectorDirection::STILL;
+
+		// Another entry is highlighted now.
+		InvalidateScreenCache(game);
 	}
 
 
 	void UpdateMainGame(Game& game, Snake& snake) {
-		// Update snake's position.
-		TellSnakeToMove(snake, game);
+		TraceBegin("UpdateMainGame");
+
+		// Items come and go, and effects wear off.
+		UpdateTimers<RuntimeRules>(game, snake);
+
+		// The snake waits where it respawned for a moment after losing a life.
+		if (IsTimerPending(game.timers, game.effects.respawn)) {
+			TraceEnd("UpdateMainGame");
+			return;
+		}
+
+		// The snake gets a little closer to the next cell every frame, even more so when it's boosted.
+		uint64_t distance = game.moveTiming.distancePerFrame;
+		if (IsTimerPending(game.timers, game.effects.speedBoost))
+			distance *= Constants::SPEED_BOOST_FACTOR;
+
+		snake.moveProgress += distance;
+
+		// Move through as many cells as the snake got to, given how long it takes to cross one along its direction.
+		while (game.currentState == State::SHOW_MAIN_GAME) {
+			bool isMovingVertically = (snake.currentDirection == Direction::UP) || (snake.currentDirection == Direction::DOWN);
+			uint64_t cellCost = isMovingVertically ? game.moveTiming.verticalCellCost : game.moveTiming.horizontalCellCost;
+
+			if (snake.moveProgress < cellCost)
+				break;
+
+			// Whatever is left over counts towards the next cell.
+			snake.moveProgress -= cellCost;
+
+			// Run the in game logic with the rules the game was set up with.
+			UpdateMainGame<RuntimeRules>(game, snake);
+		}
 
-		// Update the tail's position.
-		UpdateTailPiecesPosition(snake);
+		TraceEnd("UpdateMainGame");
 	}
 
 
@@ -567,487 +997,698 @@ namespace TextSnake {
 		// Add the valid input to the string.
 		if (isCapitalLetter || isLowercaseLetter || isDigit)
 			game.finalScore.name += std::toupper(static_cast<char>(input));
+
+		// Show the name as it is now.
+		if (input == Constants::BACKSPACE_KEY || isCapitalLetter || isLowercaseLetter || isDigit)
+			InvalidateScreenCache(game);
+	}
+
+
+	bool UpdateScreenCache(Game& game) {
+		// The in game screen changes every frame, nothing to cache there.
+		if (game.currentScreen == Screen::MAIN_GAME)
+			return true;
+
+		// Nothing changed since the last time the screen was laid out.
+		if (game.screenCache.isValid && game.screenCache.screen == game.currentScreen)
+			return false;
+
+		// Lay out the current screen from scratch.
+		game.screenCache.texts.clear();
+		game.screenCache.screen = game.currentScreen;
+
+		switch (game.currentScreen) {
+			case Screen::MAIN_MENU:
+				LayoutMainMenu(game);
+				break;
+			case Screen::GAME_OVER:
+				LayoutGameOver(game);
+				break;
+			case Screen::HIGH_SCORES:
+				LayoutHighScores(game);
+				break;
+			case Screen::MAIN_GAME:
+				break;
+		}
+
+		game.screenCache.isValid = true;
+
+		return true;
+	}
+
+
+	void InvalidateScreenCache(Game& game) {
+		game.screenCache.isValid = false;
 	}
 
 
-	void DrawMainMenu(const Game& game) {
-		// Position.
+	void AddScreenText(Game& game, const std::string& text, const Vector2D& position, const CursesUtils::Attribute attribute) {
+		ScreenText screenText;
+		screenText.text = text;
+		screenText.position = position;
+		screenText.attribute = attribute;
+
+		game.screenCache.texts.push_back(screenText);
+	}
+
+
+	void AddCenteredScreenText(Game& game, const std::string& text, const int y, const CursesUtils::Attribute attribute) {
+		// Center the text based on the string's length.
 		Vector2D pos;
-		// Initially set to the middle of the screen.
-		pos.x = static_cast<int>(CursesUtils::GetColumns() / 2);
-		pos.y = static_cast<int>(CursesUtils::GetRows() / 2);
+		pos.x = game.layout.screenCenter.x - static_cast<int>(text.length() / 2);
+		pos.y = y;
 
-		// String to draw.
-		std::string menuString = "";
+		AddScreenText(game, text, pos, attribute);
+	}
 
-		// Intro.
 
-		// Set the intro string.
-		menuString = "TEXT SNAKE";
-		// Center the intro based on the string's length.
-		pos.x -= static_cast<int>(std::strlen(menuString.c_str()) / 2);
+	void LayoutMainMenu(Game& game) {
+		// Start from the middle of the screen.
 		// Lift the intro string up a little.
-		pos.y -= Constants::INTRO_TEXT_OFFSET;
-		// Draw the text.
-		DrawText(menuString.c_str(), pos, CursesUtils::Attribute::BOLD);
+		int y = game.layout.screenCenter.y - Constants::INTRO_TEXT_OFFSET;
+
+		// Intro.
+		AddCenteredScreenText(game, "TEXT SNAKE", y, CursesUtils::Attribute::BOLD);
 
-		// Draw the menu entries.
+		// Menu entries.
 		for (std::size_t i = 0; i < game.mainMenuEntries.size(); i++) {
-			// Draw a selected entry differently.
-			if (game.mainMenuEntries[i].isSelected)
-				DrawSelectedText(game.mainMenuEntries[i].text.c_str(),
-				                 game.mainMenuEntries[i].position);
-			else
-				DrawText(game.mainMenuEntries[i].text.c_str(),
-				         game.mainMenuEntries[i].position,
-				         game.mainMenuEntries[i].attribute);
+			const MenuEntry& entry = game.mainMenuEntries[i];
+
+			// A selected entry is underlined with a blinking marker to its left.
+			if (entry.isSelected) {
+				AddScreenText(game, entry.text, entry.position, CursesUtils::Attribute::UNDERLINE);
+
+				Vector2D markerPos;
+				markerPos.x = entry.position.x - 1;
+				markerPos.y = entry.position.y;
+				AddScreenText(game, std::string(1, Constants::SELECTED_BUTTON), markerPos, CursesUtils::Attribute::BLINK);
+			} else {
+				AddScreenText(game, entry.text, entry.position, entry.attribute);
+			}
 		}
 
 		// Quit text.
-		menuString = "You can press (q) at any point in the game to quit.";
-		// Reset the x position to void the previous movement.
-		pos.x = static_cast<int>(CursesUtils::GetColumns() / 2);
-		// Center the intro based on the string's length.
-		pos.x -= static_cast<int>(std::strlen(menuString.c_str()) / 2);
-		// Move the string down a bit.
 		// Added more offset cause it's not part of the menu, just info.
 		// Taken into account all the entries before it.
-		pos.y += (Constants::MENU_TEXT_DIST + 7) +
+		y += (Constants::MENU_TEXT_DIST + 7) +
 				(game.mainMenuEntries.size() * Constants::MENU_TEXT_DIST) +
 				Constants::FIRST_ENTRY_TEXT_OFFSET;
-
-		// Draw the text.
-		DrawText(menuString.c_str(), pos, CursesUtils::Attribute::STANDOUT);
+		AddCenteredScreenText(game, "You can press (q) at any point in the game to quit.", y, CursesUtils::Attribute::STANDOUT);
 	}
 
 
 	void DrawMainGame(const Game& game, const Snake& snake) {
-		// Draw the HUD.
+		// Where the board is on the screen this frame.
+		Vector2D view = GetBoardView(game, snake);
+
+		// Show where the walls are when the board doesn't cover the whole screen.
+		if (game.layout.boardOffset.x > 0 || game.layout.boardOffset.y > 0)
+			DrawBoardFrame(game);
+
+		// Draw the level's walls.
+		if (game.level != nullptr)
+			DrawLevelWalls(game, view);
+
+		// Draw the snake in green, or in yellow while it's invincible, unless it's blinking out.
+		// The glyphs carry their own colors.
+		Palette palette = IsTimerPending(game.timers, game.effects.invincibility) ? Palette::INVINCIBLE : Palette::NORMAL;
+		if (!game.scripts.isSnakeHidden) {
+			DrawHead(snake, view, palette);
+			DrawTail(game, snake, view, palette);
+		}
+
+		// Draw the item if there's one on screen.
+		if (game.isItemOnScreen)
+			DrawItem(game.item, view);
+
+		// Draw the apple if there's one on screen.
+		if (game.isAppleOnScreen)
+			DrawApple(game.apple, view);
+
+		// Draw the HUD on top of everything.
 		DrawHUD(game);
+	}
 
-		// Draw the snake in green.
-		CursesUtils::ToggleColorPair(Constants::GREEN_ON_BLACK_ID, true);
 
-		DrawHead(snake);
-		DrawTail(snake);
+	Vector2D GetBoardView(const Game& game, const Snake& snake) {
+		// A board that fits stays where the layout put it.
+		Vector2D view = game.layout.boardOffset;
 
-		// Turn off the color.
-		CursesUtils::ToggleColorPair(Constants::GREEN_ON_BLACK_ID, false);
+		// A bigger one scrolls to keep the snake's head in the middle, without showing anything past its borders.
+		if (game.boardSize.x > game.layout.screenSize.x)
+			view.x = std::min(0, std::max(game.layout.screenSize.x - game.boardSize.x,
+			                              game.layout.screenCenter.x - snake.currentPosition.x));
 
-		// Draw the apple if there's one on screen.
-		if (game.isAppleOnScreen) {
-			// Make it red.
-			CursesUtils::ToggleColorPair(Constants::RED_ON_BLACK_ID, true);
+		if (game.boardSize.y > game.layout.screenSize.y)
+			view.y = std::min(0, std::max(game.layout.screenSize.y - game.boardSize.y,
+			                              game.layout.screenCenter.y - snake.currentPosition.y));
+
+		return view;
+	}
+
+
+	void DrawLevelWalls(const Game& game, const Vector2D& view) {
+		const Level& level = *game.level;
+
+		// Only look at the cells on the screen, in level coordinates.
+		int firstX = std::max(0, -view.x - Constants::X_MIN);
+		int lastX = std::min(level.width, game.layout.screenSize.x - view.x - Constants::X_MIN);
+		int firstY = std::max(0, -view.y - Constants::Y_MIN);
+		int lastY = std::min(level.height, game.layout.screenSize.y - view.y - Constants::Y_MIN);
 
-			DrawApple(game.apple);
+		const CursesUtils::Glyph& wall = GetGlyph(glyphTable, Palette::NORMAL, GlyphId::LEVEL_WALL);
 
-			// Turn off the color.
-			CursesUtils::ToggleColorPair(Constants::RED_ON_BLACK_ID, false);
+		for (int y = firstY; y < lastY; y++) {
+			const uint64_t* row = level.walls + y * level.rowWords;
+
+			for (int x = firstX; x < lastX; x++) {
+				// Skip a whole word of empty cells at once.
+				if ((x & 63) == 0 && row[x >> 6] == 0) {
+					x += 63;
+					continue;
+				}
+
+				if ((row[x >> 6] >> (x & 63)) & 1)
+					CursesUtils::PrintGlyphAtPosition(wall, x + Constants::X_MIN + view.x, y + Constants::Y_MIN + view.y);
+			}
 		}
 	}
 
 
-	void DrawGameOver(const Game& game) {
-		// Position.
+	void LayoutGameOver(Game& game) {
+		// Start from the middle of the screen.
+		// Lift the intro string up a little.
+		int y = game.layout.screenCenter.y - Constants::INTRO_TEXT_OFFSET;
+
+		// Intro text, a snake filling the whole board won.
+		AddCenteredScreenText(game, game.isWon ? "YOU WON" : "GAME OVER", y, CursesUtils::Attribute::BOLD);
+
+		// Name and score, centered together.
+		std::string nameString = game.finalScore.name + "   ";
+		std::string scoreString = std::to_string(game.finalScore.score);
+
 		Vector2D pos;
-		// Initially set to the middle of the screen.
-		pos.x = static_cast<int>(CursesUtils::GetColumns() / 2);
-		pos.y = static_cast<int>(CursesUtils::GetRows() / 2);
+		pos.x = game.layout.screenCenter.x - static_cast<int>(nameString.length() / 2);
+		pos.y = y + Constants::FIRST_ENTRY_TEXT_OFFSET + Constants::MENU_TEXT_DIST;
+		AddScreenText(game, nameString, pos, CursesUtils::Attribute::BLINK);
 
-		// String to draw.
-		std::string gameOverString = "";
+		pos.x += static_cast<int>(nameString.length());
+		AddScreenText(game, scoreString, pos, CursesUtils::Attribute::NORMAL);
+		y = pos.y;
 
-		// Intro text.
-		gameOverString = "GAME OVER";
-		// Center the intro based on the string's length.
-		pos.x -= static_cast<int>(std::strlen(gameOverString.c_str()) / 2);
-		// Lift the intro string up a little.
-		pos.y -= Constants::INTRO_TEXT_OFFSET;
-		// Draw the text.
-		DrawText(gameOverString.c_str(), pos, CursesUtils::Attribute::BOLD);
-
-		// Set the high score string.
-		gameOverString = game.finalScore.name + "   ";
-		// Get the length of the above string.
-		int goLength = std::strlen(gameOverString.c_str());
-		// Recenter the position.
-		pos.x = static_cast<int>(CursesUtils::GetColumns() / 2);
-		// Center the intro based on the string's length.
-		pos.x -= static_cast<int>(goLength / 2);
-		// Move the string down.
-		pos.y += Constants::FIRST_ENTRY_TEXT_OFFSET + Constants::MENU_TEXT_DIST;
-		// Draw name.
-		DrawText(gameOverString.c_str(), pos, CursesUtils::Attribute::BLINK);
-		// Draw score.
-		pos.x += goLength;
-		DrawText(std::to_string(game.finalScore.score).c_str(), pos, CursesUtils::Attribute::NORMAL);
+		// Rank text, right below the score.
+		y += Constants::MENU_TEXT_DIST;
+		AddCenteredScreenText(game, "Rank #" + std::to_string(game.finalRank + 1), y, CursesUtils::Attribute::BOLD);
 
 		// Enter text.
-		gameOverString = "Press (enter) to confirm.";
-		// Reset the x position to void the previous movement.
-		pos.x = static_cast<int>(CursesUtils::GetColumns() / 2);
-		// Center the intro based on the string's length.
-		pos.x -= static_cast<int>(std::strlen(gameOverString.c_str()) / 2);
-		// Move the string down a bit.
 		// Added more offset cause it's not part of the menu, just info.
-		// Take into account all entries before this.
-		pos.y += Constants::MENU_TEXT_DIST + 7;
-		// Draw the text.
-		DrawText(gameOverString.c_str(), pos, CursesUtils::Attribute::UNDERLINE);
+		y += Constants::MENU_TEXT_DIST + 5;
+		AddCenteredScreenText(game, "Press (enter) to confirm.", y, CursesUtils::Attribute::UNDERLINE);
 
 		// Quit text.
-		gameOverString = "You can press (q) at any point in the game to quit.";
-		// Reset the x position to void the previous movement.
-		pos.x = static_cast<int>(CursesUtils::GetColumns() / 2);
-		// Center the intro based on the string's length.
-		pos.x -= static_cast<int>(std::strlen(gameOverString.c_str()) / 2);
-		// Move the string down a bit.
-		// Added more offset cause it's not part of the menu, just info.
-		pos.y += Constants::MENU_TEXT_DIST;
-		// Draw the text.
-		DrawText(gameOverString.c_str(), pos, CursesUtils::Attribute::STANDOUT);
+		y += Constants::MENU_TEXT_DIST;
+		AddCenteredScreenText(game, "You can press (q) at any point in the game to quit.", y, CursesUtils::Attribute::STANDOUT);
 	}
 
 
-	void DrawHighScores(const Game& game) {
-		// Position.
-		Vector2D pos;
-		// Initially set to the middle of the screen.
-		pos.x = static_cast<int>(CursesUtils::GetColumns() / 2);
-		// Set this to the very top of the screen.
-		pos.y = 0;
-
-		// String to draw.
-		std::string highScoresString = "";
+	void LayoutHighScores(Game& game) {
+		// Start at the very top of the screen.
+		int y = 0;
 
 		// Intro text.
-		highScoresString = "HIGH SCORES";
-		// Center the intro based on the string's length.
-		pos.x -= static_cast<int>(std::strlen(highScoresString.c_str()) / 2);
-		// Draw the text.
-		DrawText(highScoresString.c_str(), pos, CursesUtils::Attribute::BOLD);
+		AddCenteredScreenText(game, "HIGH SCORES", y, CursesUtils::Attribute::BOLD);
 
 		// High scores.
-		std::string highScoreStr = "";
-		for (std::size_t i = 0; i < game.highScores.size(); i++) {
-			// Don't draw more than the max to the screen.
-			if (i >= Constants::MAX_HIGH_SCORES_ON_SCREEN)
+		// Only the current page is laid out, each score is looked up by its rank.
+		std::size_t totalHighScores = GetLeaderboardSize(game.highScores);
+		std::size_t firstRank = game.highScoresPage * Constants::MAX_HIGH_SCORES_ON_SCREEN;
+
+		for (std::size_t i = firstRank; i < totalHighScores; i++) {
+			// Don't show more than the max on the screen.
+			if (i >= firstRank + Constants::MAX_HIGH_SCORES_ON_SCREEN)
 				break;
 
-			// Set the string.
-			highScoreStr = game.highScores[i].name + "   " + std::to_string(game.highScores[i].score);
+			const Score& highScore = GetScoreAtRank(game.highScores, i);
 
-			// Center the x position.
-			pos.x = static_cast<int>(CursesUtils::GetColumns() / 2);
-			// Align the string with the center based on the length of the string.
-			pos.x -= static_cast<int>(std::strlen(highScoreStr.c_str()) / 2);
 			// Lower the string a little.
-			pos.y += Constants::MENU_TEXT_DIST;
+			y += Constants::MENU_TEXT_DIST;
+			AddCenteredScreenText(game, std::to_string(i + 1) + ". " + highScore.name + "   " + std::to_string(highScore.score),
+			                      y, CursesUtils::Attribute::NORMAL);
+		}
 
-			// Draw high score.
-			DrawText(highScoreStr.c_str(), pos, CursesUtils::Attribute::NORMAL);
+		// Page text, right below the scores.
+		std::size_t totalPages = (totalHighScores + Constants::MAX_HIGH_SCORES_ON_SCREEN - 1) / Constants::MAX_HIGH_SCORES_ON_SCREEN;
+		if (totalPages > 1) {
+			y += Constants::MENU_TEXT_DIST;
+			AddCenteredScreenText(game, "Page " + std::to_string(game.highScoresPage + 1) + "/" + std::to_string(totalPages) +
+			                      "  (up/down) to change page.", y, CursesUtils::Attribute::DIM);
 		}
 
 		// Enter text.
-		highScoresString = "Press (enter) to go back to main menu.";
-		// Reset the x position to void the previous movement.
-		pos.x = static_cast<int>(CursesUtils::GetColumns() / 2);
-		// Center the intro based on the string's length.
-		pos.x -= static_cast<int>(std::strlen(highScoresString.c_str()) / 2);
-		// Move the string down a bit.
 		// Added more offset cause it's not part of the menu, just info.
-		// Take into account all entries before this.
-		pos.y += Constants::MENU_TEXT_DIST + 2;
-		// Draw the text.
-		DrawText(highScoresString.c_str(), pos, CursesUtils::Attribute::UNDERLINE);
+		y += Constants::MENU_TEXT_DIST + 2;
+		AddCenteredScreenText(game, "Press (enter) to go back to main menu.", y, CursesUtils::Attribute::UNDERLINE);
 
 		// Quit text.
-		highScoresString = "You can press (q) at any point in the game to quit.";
-		// Reset the x position to void the previous movement.
-		pos.x = static_cast<int>(CursesUtils::GetColumns() / 2);
-		// Center the intro based on the string's length.
-		pos.x -= static_cast<int>(std::strlen(highScoresString.c_str()) / 2);
-		// Move the string down a bit.
-		// Added more offset cause it's not part of the menu, just info.
-		pos.y += Constants::MENU_TEXT_DIST;
-		// Draw the text.
-		DrawText(highScoresString.c_str(), pos, CursesUtils::Attribute::STANDOUT);
+		y += Constants::MENU_TEXT_DIST;
+		AddCenteredScreenText(game, "You can press (q) at any point in the game to quit.", y, CursesUtils::Attribute::STANDOUT);
+	}
+
+
+	void DrawScreenCache(const Game& game) {
+		// Everything on the screen was laid out beforehand, just print it.
+		for (std::size_t i = 0; i < game.screenCache.texts.size(); i++) {
+			const ScreenText& screenText = game.screenCache.texts[i];
+			DrawText(screenText.text.c_str(), screenText.position, screenText.attribute);
+		}
 	}
 
 
 	void UpdateTailPiecesPosition(Snake& snake) {
 		// Get out if there is no tail.
-		if (snake.tail.size() == 0)
+		if (snake.tailLength == 0)
 			return;
 
-		// Update all the pieces' position and direction.
-		for (std::size_t i = 0; i < snake.tail.size(); i++) {
-			// The first tail piece follows the head.
-			if (i == 0) {
-				// Update previous, current position and direction.
-				snake.tail[i].previousDirection = snake.tail[i].currentDirection;
-				snake.tail[i].currentDirection = snake.previousDirection;
-
-				snake.tail[i].previousPosition.x = snake.tail[i].currentPosition.x;
-				snake.tail[i].previousPosition.y = snake.tail[i].currentPosition.y;
-				snake.tail[i].currentPosition.x = snake.previousPosition.x;
-				snake.tail[i].currentPosition.y = snake.previousPosition.y;
-
-				// Move onto the next piece.
-				continue;
-			}
+		// Every piece takes the place of the one before it, so the tail looks the same once
+		// its last piece goes right behind the head. That's all that has to move.
+		std::size_t backIndex = snake.tailFront + snake.tailLength - 1;
+		if (backIndex >= snake.tail.size())
+			backIndex -= snake.tail.size();
 
-			// Tail pieces normally follow their predecessors.
-			// Update previous, current position and direction.
-			snake.tail[i].previousDirection = snake.tail[i].currentDirection;
-			snake.tail[i].currentDirection = snake.tail[i - 1].previousDirection;
+		TailPiece piece = snake.tail[backIndex];
+		const TailPiece& first = snake.tail[snake.tailFront];
 
-			snake.tail[i].previousPosition.x = snake.tail[i].currentPosition.x;
-			snake.tail[i].previousPosition.y = snake.tail[i].currentPosition.y;
-			snake.tail[i].currentPosition.x = snake.tail[i - 1].previousPosition.x;
-			snake.tail[i].currentPosition.y = snake.tail[i - 1].previousPosition.y;
-		}
+		// The last piece leaves its cell.
+		VacateCell(snake.occupancy, piece.currentPosition);
+
+		// And follows the head, coming from where the first piece was.
+		piece.previousDirection = first.currentDirection;
+		piece.currentDirection = snake.previousDirection;
+
+		piece.previousPosition.x = first.currentPosition.x;
+		piece.previousPosition.y = first.currentPosition.y;
+		piece.currentPosition.x = snake.previousPosition.x;
+		piece.currentPosition.y = snake.previousPosition.y;
+
+		// It's the first piece now, the slot before the old first one is either free or the one it came from.
+		snake.tailFront = (snake.tailFront == 0) ? snake.tail.size() - 1 : snake.tailFront - 1;
+		snake.tail[snake.tailFront] = piece;
+
+		OccupyCell(snake.occupancy, piece.currentPosition);
 	}
 
 
 	void TellSnakeToMove(Snake& snake, Game& game) {
-		// Check the snake current direction.
-		switch (snake.currentDirection) {
-			case Direction::UP:
-				MoveSnake(snake, 0, -1, game);
-				break;
-			case Direction::RIGHT:
-				MoveSnake(snake, 1, 0, game);
-				break;
-			case Direction::DOWN:
-				MoveSnake(snake, 0, 1, game);
-				break;
-			case Direction::LEFT:
-				MoveSnake(snake, -1, 0, game);
-				break;
-		}
+		TellSnakeToMove<RuntimeRules>(snake, game);
 	}
 
 
 	void MoveSnake(Snake& snake, const int x, const int y, Game& game) {
-		// Set the previous position before we set the new one.
-		snake.previousPosition.x = snake.currentPosition.x;
-		snake.previousPosition.y = snake.currentPosition.y;
+		MoveSnake<RuntimeRules>(snake, x, y, game);
+	}
 
-		// Take the speed into account when changing the position.
-		unsigned int newX = x * snake.speed;
-		unsigned int newY = y * snake.speed;
 
-		// Set the new position.
-		snake.currentPosition.x += newX;
-		snake.currentPosition.y += newY;
+	bool DieOnCollision(Snake& snk, Game& gm) {
+		return DieOnCollision<RuntimeRules>(snk, gm);
+	}
 
-		// Check whether the snake hits a wall or itself.
-		DieOnCollision(snake, game);
 
-		// Check whether the snake ate an apple.
-		EatAppleOnCollision(snake, game);
+	void EndGame(Game& game, const bool isWon) {
+		game.isWon = isWon;
+
+		// Set the final score.
+		game.finalScore.score = game.currentScore;
+
+		// Find out where it would end up among the high scores, they have to be there for that.
+		EnsureHighScoresLoaded(game);
+		game.finalRank = GetScoreRank(game.highScores, game.finalScore.score);
+
+		// Change state to game over.
+		game.currentState = State::SHOW_GAME_OVER;
 	}
 
 
-	void DieOnCollision(Snake& snk, Game& gm) {
-		// Wall collisions.
-		// Snake position is the same as either border of the screen.
-		bool vWallCollision = (snk.currentPosition.y < Constants::Y_MIN) ||
-				(snk.currentPosition.y > CursesUtils::GetRows());
-		bool hWallCollision = (snk.currentPosition.x < Constants::X_MIN) ||
-				(snk.currentPosition.x > CursesUtils::GetColumns());
+	void ResetSnake(Snake& snake, Game& game) {
+		ResetSnake<RuntimeRules>(snake, game);
+	}
 
-		// Tail Collision.
-		bool tailCollision = false;
-		if (snk.tail.size() > 0) {
-			for (std::size_t i = 0; i < snk.tail.size(); i++) {
-				// Head position is the same as the tail piece position.
-				if ((snk.currentPosition.x == snk.tail[i].currentPosition.x) &&
-						(snk.currentPosition.y == snk.tail[i].currentPosition.y)) {
-					tailCollision = true;
 
-					// No need to check for other pieces since this one already collided.
-					break;
-				}
-			}
-		}
+	void EatAppleOnCollision(Snake& snk, Game& gm) {
+		EatAppleOnCollision<RuntimeRules>(snk, gm);
+	}
 
-		// If a collision happened, make sure to lose one life or die.
-		if (vWallCollision || hWallCollision || tailCollision) {
-			// Lose a life.
-			gm.lives--;
-
-			// When the snake has at least one life left, then reset it.
-			// On the other hand, when the snake has no more lives left, move onto the
-			// game over screen.
-			if (gm.lives > 0) {
-				ResetSnake(snk, gm);
-			} else	{
-				// Set the lives count to 0.
-				gm.lives = 0;
-
-				// Set the final score.
-				gm.finalScore.score = gm.currentScore;
-
-				// Change state to game over.
-				gm.currentState = State::SHOW_GAME_OVER;
-			}
-		}
+
+	unsigned int CalcScore(const Snake& snake, const Game& game) {
+		return CalcScore<RuntimeRules>(snake, game);
 	}
 
 
-	void ResetSnake(Snake& snake, const Game& game) {
-		// Middle of the screen.
-		int xMid = static_cast<int>(CursesUtils::GetColumns() / 2);
-		int yMid = static_cast<int>(CursesUtils::GetRows() / 2);
+	void SpawnApple(Game& game, Snake& snake) {
+		SpawnApple<RuntimeRules>(game, snake);
+	}
 
-		// Reset the snake position to the center of the screen.
-		int xPos = 0;
-		int yPos = 0;
 
-		// Random offset from the center.
-		int randomOffset = (rand() % Constants::OFFSET_FROM_MIDSCREEN) + 1;
+	bool PickRandomApplePos(Snake& s, Game& g, Vector2D& p) {
+		return PickRandomApplePos<RuntimeRules>(s, g, p);
+	}
 
-		if ((game.apple.position.x == xMid) && (game.apple.position.y == yMid)) {
-			// If an apple is located in the center, put the snake somewhere else.
-			xPos = xMid + randomOffset;
-			yPos = yMid + randomOffset;
-		} else {
-			// Snake is positioned in the center.
-			xPos = xMid;
-			yPos = yMid;
-		}
 
-		snake.currentPosition.x = xPos;
-		snake.currentPosition.y = yPos;
+	void InitItem(Item& item, const ItemKind kind, const Vector2D& p) {
+		item.kind = kind;
 
-		// Reset previous position.
-		snake.previousPosition.x = snake.currentPosition.x;
-		snake.previousPosition.y = snake.currentPosition.y;
+		// Set the item's position.
+		item.position.x = p.x;
+		item.position.y = p.y;
 
-		// Reset direction.
-		snake.currentDirection = static_cast<Direction>(rand() % 4);
-		snake.previousDirection = snake.currentDirection;
+		// Every kind looks different.
+		switch (kind) {
+			case ItemKind::BONUS_APPLE:
+				item.sprite = Constants::SPR_BONUS_APPLE;
+				break;
+			case ItemKind::SPEED_BOOST:
+				item.sprite = Constants::SPR_SPEED_BOOST;
+				break;
+			case ItemKind::INVINCIBILITY:
+				item.sprite = Constants::SPR_INVINCIBILITY;
+				break;
+		}
 
-		// Clear the tail.
-		if (snake.tail.size() > 0)	snake.tail.clear();
+		// No expiry until it's scheduled.
+		item.expiryTimer = NO_TIMER;
 	}
 
 
-	void EatAppleOnCollision(Snake& snk, Game& gm) {
-		// Snake didn't collide with an apple.
-		if ((snk.currentPosition.x != gm.apple.position.x) || (snk.currentPosition.y != gm.apple.position.y))
-			return;
+	void InitApple(Apple& a, const Vector2D& p) {
+		// Set the apple's position.
+		a.position.x = p.x;
+		a.position.y = p.y;
 
-		// Apple is no longer on the screen when the snake eats it.
-		gm.isAppleOnScreen = false;
+		// Set the apple's sprite.
+		a.sprite = Constants::SPR_APPLE;
 
-		// Increase length of the snake's tail.
-		MakeTailPiece(snk);
+		// Set the apple's default color;
+		a.color = Constants::DEFAULT_COLOR;
+	}
 
-		// Increase the score whenever the snake eats an apple.
-		gm.currentScore += CalcScore(snk);
 
-		// Spawn a new apple.
-		SpawnApple(gm, snk);
+	void MakeTailPiece(Snake& s) {
+		// Instantiate a new TailPiece and initialize it.
+		TailPiece tp;
+		tp.color = s.color;
+		tp.sprite = Constants::SPR_SNAKE_TAIL;
+
+		// Set its direction and position.
+		SetNewTailPieceDirAndPos(s, tp);
+
+		// Add the tail piece to the end of the tail.
+		PushTailPiece(s, tp);
 	}
 
 
-	unsigned int CalcScore(const Snake& snake) {
-		// My score increase formula.
-		unsigned int scoreAddition = static_cast<unsigned int>(ceil(snake.tail.size() / 2) * Constants::SCORE_MULTIPLIER);
+	void PushTailPiece(Snake& snake, const TailPiece& piece) {
+		// No room left, lay the tail out again from the start in a ring twice as big.
+		if (snake.tailLength == snake.tail.size()) {
+			std::vector<TailPiece> tail(std::max<std::size_t>(2 * snake.tail.size(), Constants::MIN_RESERVED_TAIL_PIECES));
+			for (std::size_t i = 0; i < snake.tailLength; i++)
+				tail[i] = GetTailPiece(snake, i);
+
+			snake.tail.swap(tail);
+			snake.tailFront = 0;
+		}
+
+		std::size_t index = snake.tailFront + snake.tailLength;
+		if (index >= snake.tail.size())
+			index -= snake.tail.size();
+
+		snake.tail[index] = piece;
+		snake.tailLength++;
 
-		// Return the base points in case it's the first apple the snake eats.
-		return (snake.tail.size() > 1) ? scoreAddition : Constants::BASE_APPLE_POINTS;
+		OccupyCell(snake.occupancy, piece.currentPosition);
 	}
 
 
-	void SpawnApple(Game& game, const Snake& snake) {
-		// Can't spawn an apple if there's already one on the screen.
-		if (game.isAppleOnScreen)	return;
+	namespace {
 
-		// Calculate its position.
-		Vector2D randomPos;
-		PickRandomApplePos(snake, randomPos);
+		/*
+		 * Empties a table, making sure it has room for the given cells. It only allocates when it has to grow.
+		 */
+		void ClearCellTable(CellTable& table, const std::size_t totalCells) {
+			// Never more than half full.
+			std::size_t totalSlots = 2 * std::max(totalCells, Constants::MIN_RESERVED_TAIL_PIECES);
+			unsigned int bits = 0;
+			while ((static_cast<std::size_t>(1) << bits) < totalSlots)
+				bits++;
 
-		// Initialize this apple.
-		InitApple(game.apple, randomPos);
+			if (table.cells.size() < (static_cast<std::size_t>(1) << bits)) {
+				table.cells.assign(static_cast<std::size_t>(1) << bits, Constants::EMPTY_CELL);
+				table.values.assign(static_cast<std::size_t>(1) << bits, 0);
+				table.hashShift = 64 - bits;
+			} else {
+				std::fill(table.cells.begin(), table.cells.end(), Constants::EMPTY_CELL);
+			}
 
-		// Since the apple has been created, the flag will be updated.
-		game.isAppleOnScreen = true;
-	}
+			table.totalCells = 0;
+		}
 
+		/*
+		 * Puts a cell that isn't in the table yet in it, with a value of 0, and returns its slot.
+		 * The table doubles once it would be more than half full.
+		 */
+		std::size_t AddCell(CellTable& table, const uint64_t cell) {
+			if (2 * (table.totalCells + 1) > table.cells.size()) {
+				std::vector<uint64_t> cells;
+				std::vector<uint32_t> values;
+				cells.swap(table.cells);
+				values.swap(table.values);
+
+				ClearCellTable(table, cells.size());
+				for (std::size_t i = 0; i < cells.size(); i++)
+					if (cells[i] != Constants::EMPTY_CELL)
+						table.values[AddCell(table, cells[i])] = values[i];
+			}
 
-	void PickRandomApplePos(const Snake& s, Vector2D& p) {
-		// Flag to indicate whether the random spot on the screen is free or not.
-		bool isFree = false;
+			std::size_t mask = table.cells.size() - 1;
+			std::size_t slot = GetFirstCellSlot(table, cell);
+			while (table.cells[slot] != Constants::EMPTY_CELL)
+				slot = (slot + 1) & mask;
 
-		int randomX = 0;
-		int randomY = 0;
+			table.cells[slot] = cell;
+			table.values[slot] = 0;
+			table.totalCells++;
 
-		// Keep generating a random position until we find a free spot on the screen.
-		do {
-			// Get the random position between min and max.
-			randomX = (rand() % (CursesUtils::GetColumns() - Constants::X_MIN)) + Constants::X_MIN;
-			randomY = (rand() % (CursesUtils::GetRows() - Constants::Y_MIN)) + Constants::Y_MIN;
+			return slot;
+		}
 
-			// Check every single piece of the snake, including the head, to see
-			// if it happens to be in the same spot as the random one.
+		/*
+		 * Takes the cell in a slot out of its table.
+		 * The cells after it move back into the hole when that's closer to their first slot,
+		 * so lookups never need to skip over removed cells.
+		 */
+		void RemoveCellSlot(CellTable& table, std::size_t hole) {
+			std::size_t mask = table.cells.size() - 1;
+			std::size_t slot = hole;
+
+			while (true) {
+				slot = (slot + 1) & mask;
+				if (table.cells[slot] == Constants::EMPTY_CELL)
+					break;
 
-			// Head.
-			if ((s.currentPosition.x == randomX) && (s.currentPosition.y == randomY)) {
-				isFree = false;
+				// Only a cell whose first slot isn't between the hole and where it is can move back.
+				std::size_t firstSlot = GetFirstCellSlot(table, table.cells[slot]);
+				if (((slot - firstSlot) & mask) >= ((slot - hole) & mask)) {
+					table.cells[hole] = table.cells[slot];
+					table.values[hole] = table.values[slot];
+					hole = slot;
+				}
+			}
 
-				// No need to check for the tail if the head is already in the same position as the random one.
-				break;
-			} else {
-				isFree = true;
+			table.cells[hole] = Constants::EMPTY_CELL;
+			table.totalCells--;
+		}
+
+		/*
+		 * Tells whether an apple could ever go on a cell of the board.
+		 */
+		bool IsAppleCell(const Occupancy& occupancy, const unsigned int column, const unsigned int row) {
+			const Level* level = occupancy.level;
+			return level == nullptr ||
+					(!IsLevelWall(*level, static_cast<int>(column), static_cast<int>(row)) &&
+					 IsLevelAppleZone(*level, static_cast<int>(column), static_cast<int>(row)));
+		}
+
+		/*
+		 * Drops the cells the snake took from the free ones.
+		 */
+		void DropStaleCells(Occupancy& occupancy) {
+			std::size_t totalFreeCells = 0;
+
+			for (std::size_t i = 0; i < occupancy.freeCells.size(); i++) {
+				uint64_t cell = occupancy.freeCells[i];
+				int column = static_cast<int>(cell >> 32);
+				int row = static_cast<int>(cell & 0xFFFFFFFF);
+
+				if (IsMaskBitSet(occupancy.taken.data(), occupancy.rowWords, column, row))
+					occupancy.listed[row * occupancy.rowWords + (column >> 6)] &= ~(1ull << (column & 63));
+				else
+					occupancy.freeCells[totalFreeCells++] = cell;
 			}
 
-			// Tail.
-			for (std::size_t i = 0; i < s.tail.size(); i++) {
-				if ((s.tail[i].currentPosition.x == randomX) && (s.tail[i].currentPosition.y == randomY)) {
-					isFree = false;
+			occupancy.freeCells.resize(totalFreeCells);
+			occupancy.totalStaleCells = 0;
+		}
 
-					// Don't check other pieces if this one already matches up with the random one.
-					break;
-				} else {
-					isFree = true;
+	}
+
+	void InitOccupancy(Snake& snake, const Game& game) {
+		Occupancy& occupancy = snake.occupancy;
+		occupancy.level = game.level;
+		occupancy.width = std::max(game.boardSize.x - Constants::X_MIN, 0);
+		occupancy.height = std::max(game.boardSize.y - Constants::Y_MIN, 0);
+		occupancy.rowWords = (static_cast<std::size_t>(occupancy.width) + 63) / 64;
+
+		// Every cell starts free, the bits keep their memory while the board stays the same size.
+		std::size_t totalWords = occupancy.rowWords * occupancy.height;
+		if (occupancy.taken.size() != totalWords)
+			occupancy.taken.assign(totalWords, 0);
+		else
+			std::fill(occupancy.taken.begin(), occupancy.taken.end(), 0);
+
+		ClearCellTable(occupancy.stacked, 0);
+
+		// The free cells get listed again when they're needed, the memory is kept for then.
+		occupancy.isListingFreeCells = false;
+		occupancy.freeCells.clear();
+		occupancy.totalStaleCells = 0;
+
+		// Then the snake takes its cells.
+		OccupyCell(occupancy, snake.currentPosition);
+		for (std::size_t i = 0; i < snake.tailLength; i++)
+			OccupyCell(occupancy, GetTailPiece(snake, i).currentPosition);
+	}
+
+
+	void ListFreeCells(Occupancy& occupancy) {
+		if (occupancy.isListingFreeCells)
+			return;
+
+		occupancy.listed.assign(occupancy.taken.size(), 0);
+		occupancy.freeCells.clear();
+		occupancy.totalStaleCells = 0;
+
+		// The snake's cells may all free up later on, room gets made for every cell apples go on.
+		std::size_t totalAppleCells = 0;
+
+		const Level* level = occupancy.level;
+		for (int row = 0; row < occupancy.height; row++) {
+			for (std::size_t word = 0; word < occupancy.rowWords; word++) {
+				// Cells past the end of the row don't count.
+				uint64_t appleCells = ~0ull;
+				std::size_t firstColumn = word * 64;
+				if (firstColumn + 64 > static_cast<std::size_t>(occupancy.width))
+					appleCells >>= firstColumn + 64 - occupancy.width;
+
+				// Levels tell where apples go 64 cells at a time, like the snake's bits.
+				if (level != nullptr) {
+					if (row >= level->height || word >= level->rowWords)
+						continue;
+
+					appleCells &= ~level->walls[row * level->rowWords + word];
+					if (level->totalAppleZones > 0)
+						appleCells &= level->appleZones[row * level->rowWords + word];
 				}
+
+				totalAppleCells += std::bitset<64>(appleCells).count();
+
+				std::size_t index = row * occupancy.rowWords + word;
+				uint64_t freeCells = appleCells & ~occupancy.taken[index];
+				occupancy.listed[index] = freeCells;
+
+				for (unsigned int bit = 0; freeCells != 0; bit++, freeCells >>= 1)
+					if (freeCells & 1)
+						occupancy.freeCells.push_back(GetCellKey(static_cast<unsigned int>(firstColumn + bit), row));
 			}
-		} while (!isFree);
+		}
 
-		// If we got here then we know a good random position was found.
-		p.x = randomX;
-		p.y = randomY;
+		// No cell is ever listed twice, so there's always room for it.
+		occupancy.freeCells.reserve(totalAppleCells);
+		occupancy.isListingFreeCells = true;
 	}
 
 
-	void InitApple(Apple& a, const Vector2D& p) {
-		// Set the apple's position.
-		a.position.x = p.x;
-		a.position.y = p.y;
+	void VacateSnake(Snake& snake) {
+		VacateCell(snake.occupancy, snake.currentPosition);
+		for (std::size_t i = 0; i < snake.tailLength; i++)
+			VacateCell(snake.occupancy, GetTailPiece(snake, i).currentPosition);
+	}
 
-		// Set the apple's sprite.
-		a.sprite = Constants::SPR_APPLE;
 
-		// Set the apple's default color;
-		a.color = Constants::DEFAULT_COLOR;
+	void OccupyCell(Occupancy& occupancy, const Vector2D& p) {
+		unsigned int column = static_cast<unsigned int>(p.x - Constants::X_MIN);
+		unsigned int row = static_cast<unsigned int>(p.y - Constants::Y_MIN);
+
+		if (column >= static_cast<unsigned int>(occupancy.width) || row >= static_cast<unsigned int>(occupancy.height))
+			return;
+
+		uint64_t& word = occupancy.taken[row * occupancy.rowWords + (column >> 6)];
+		uint64_t bit = 1ull << (column & 63);
+		uint64_t cell = GetCellKey(column, row);
+
+		// Another piece on a taken cell, the snake went through itself.
+		if (word & bit) {
+			std::size_t slot = FindCellSlot(occupancy.stacked, cell);
+			if (slot == Constants::NO_CELL_SLOT)
+				slot = AddCell(occupancy.stacked, cell);
+
+			occupancy.stacked.values[slot]++;
+			return;
+		}
+
+		// The cell was free until now.
+		word |= bit;
+
+		// It stays listed, but once most of the list is taken cells it's cleaned up.
+		if (occupancy.isListingFreeCells && IsMaskBitSet(occupancy.listed.data(), occupancy.rowWords, column, row)) {
+			occupancy.totalStaleCells++;
+			if (2 * occupancy.totalStaleCells > occupancy.freeCells.size())
+				DropStaleCells(occupancy);
+		}
 	}
 
 
-	void MakeTailPiece(Snake& s) {
-		// Instantiate a new TailPiece and initialize it.
-		TailPiece tp;
-		tp.color = s.color;
-		tp.sprite = Constants::SPR_SNAKE_TAIL;
+	void VacateCell(Occupancy& occupancy, const Vector2D& p) {
+		unsigned int column = static_cast<unsigned int>(p.x - Constants::X_MIN);
+		unsigned int row = static_cast<unsigned int>(p.y - Constants::Y_MIN);
 
-		// Set its direction and position.
-		SetNewTailPieceDirAndPos(s, tp);
+		if (column >= static_cast<unsigned int>(occupancy.width) || row >= static_cast<unsigned int>(occupancy.height))
+			return;
+
+		uint64_t& word = occupancy.taken[row * occupancy.rowWords + (column >> 6)];
+		uint64_t bit = 1ull << (column & 63);
+		if (!(word & bit))
+			return;
 
-		// Add the tail piece to the vector.
-		s.tail.push_back(tp);
+		// Other pieces stay on the cell.
+		uint64_t cell = GetCellKey(column, row);
+		std::size_t slot = FindCellSlot(occupancy.stacked, cell);
+		if (slot != Constants::NO_CELL_SLOT) {
+			if (--occupancy.stacked.values[slot] == 0)
+				RemoveCellSlot(occupancy.stacked, slot);
+			return;
+		}
+
+		// The last piece left, the cell is free again.
+		word &= ~bit;
+
+		if (!occupancy.isListingFreeCells)
+			return;
+
+		// Still listed from before the snake took it, or listed from now on.
+		if (IsMaskBitSet(occupancy.listed.data(), occupancy.rowWords, column, row)) {
+			occupancy.totalStaleCells--;
+		} else if (IsAppleCell(occupancy, column, row)) {
+			occupancy.listed[row * occupancy.rowWords + (column >> 6)] |= bit;
+			occupancy.freeCells.push_back(cell);
+		}
 	}
 
 
@@ -1056,14 +1697,14 @@ namespace TextSnake {
 		bool isFirstPiece = false;
 
 		// First piece will follow the head.
-		if (snake.tail.size() == 0) {
+		if (snake.tailLength == 0) {
 			tailPiece.currentDirection = snake.currentDirection;
 			tailPiece.previousDirection = snake.previousDirection;
 
 			isFirstPiece = true;
 		} else {
-			tailPiece.currentDirection = snake.tail.back().currentDirection;
-			tailPiece.previousDirection = snake.tail.back().previousDirection;
+			tailPiece.currentDirection = GetTailPiece(snake, snake.tailLength - 1).currentDirection;
+			tailPiece.previousDirection = GetTailPiece(snake, snake.tailLength - 1).previousDirection;
 
 			isFirstPiece = false;
 		}
@@ -1077,8 +1718,8 @@ namespace TextSnake {
 					tailPiece.currentPosition.x = snake.currentPosition.x;
 					tailPiece.currentPosition.y = snake.currentPosition.y + 1;
 				} else {
-					tailPiece.currentPosition.x = snake.tail.back().currentPosition.x;
-					tailPiece.currentPosition.y = snake.tail.back().currentPosition.y + 1;
+					tailPiece.currentPosition.x = GetTailPiece(snake, snake.tailLength - 1).currentPosition.x;
+					tailPiece.currentPosition.y = GetTailPiece(snake, snake.tailLength - 1).currentPosition.y + 1;
 				}
 
 				// Since this piece was just created it doesn't have a previous position yet.
@@ -1091,8 +1732,8 @@ namespace TextSnake {
 					tailPiece.currentPosition.x = snake.currentPosition.x - 1;
 					tailPiece.currentPosition.y = snake.currentPosition.y;
 				} else {
-					tailPiece.currentPosition.x = snake.tail.back().currentPosition.x - 1;
-					tailPiece.currentPosition.y = snake.tail.back().currentPosition.y;
+					tailPiece.currentPosition.x = GetTailPiece(snake, snake.tailLength - 1).currentPosition.x - 1;
+					tailPiece.currentPosition.y = GetTailPiece(snake, snake.tailLength - 1).currentPosition.y;
 				}
 
 				// Since this piece was just created it doesn't have a previous position yet.
@@ -1105,8 +1746,8 @@ namespace TextSnake {
 					tailPiece.currentPosition.x = snake.currentPosition.x;
 					tailPiece.currentPosition.y = snake.currentPosition.y - 1;
 				} else {
-					tailPiece.currentPosition.x = snake.tail.back().currentPosition.x;
-					tailPiece.currentPosition.y = snake.tail.back().currentPosition.y - 1;
+					tailPiece.currentPosition.x = GetTailPiece(snake, snake.tailLength - 1).currentPosition.x;
+					tailPiece.currentPosition.y = GetTailPiece(snake, snake.tailLength - 1).currentPosition.y - 1;
 				}
 
 				// Since this piece was just created it doesn't have a previous position yet.
@@ -1119,8 +1760,8 @@ namespace TextSnake {
 					tailPiece.currentPosition.x = snake.currentPosition.x + 1;
 					tailPiece.currentPosition.y = snake.currentPosition.y;
 				} else {
-					tailPiece.currentPosition.x = snake.tail.back().currentPosition.x + 1;
-					tailPiece.currentPosition.y = snake.tail.back().currentPosition.y;
+					tailPiece.currentPosition.x = GetTailPiece(snake, snake.tailLength - 1).currentPosition.x + 1;
+					tailPiece.currentPosition.y = GetTailPiece(snake, snake.tailLength - 1).currentPosition.y;
 				}
 
 				// Since this piece was just created it doesn't have a previous position yet.
@@ -1132,79 +1773,152 @@ namespace TextSnake {
 	}
 
 
+	void DrawBoardFrame(const Game& game) {
+		// Cells right outside the board.
+		int left = game.layout.boardOffset.x - 1;
+		int right = game.layout.boardOffset.x + game.boardSize.x;
+		int top = game.layout.boardOffset.y + Constants::Y_MIN - 1;
+		int bottom = game.layout.boardOffset.y + game.boardSize.y;
+
+		// Borders the snake goes through look open, corners and all.
+		bool isWrapping = game.rules.isWrapping;
+		GlyphId horizontal = isWrapping ? GlyphId::WRAP_HORIZONTAL : GlyphId::FRAME_HORIZONTAL;
+		GlyphId vertical = isWrapping ? GlyphId::WRAP_VERTICAL : GlyphId::FRAME_VERTICAL;
+
+		// Corners.
+		CursesUtils::PrintGlyphAtPosition(GetGlyph(glyphTable, Palette::NORMAL, isWrapping ? horizontal : GlyphId::FRAME_TOP_LEFT), left, top);
+		CursesUtils::PrintGlyphAtPosition(GetGlyph(glyphTable, Palette::NORMAL, isWrapping ? horizontal : GlyphId::FRAME_TOP_RIGHT), right, top);
+		CursesUtils::PrintGlyphAtPosition(GetGlyph(glyphTable, Palette::NORMAL, isWrapping ? horizontal : GlyphId::FRAME_BOTTOM_LEFT), left, bottom);
+		CursesUtils::PrintGlyphAtPosition(GetGlyph(glyphTable, Palette::NORMAL, isWrapping ? horizontal : GlyphId::FRAME_BOTTOM_RIGHT), right, bottom);
+
+		// Top and bottom.
+		const CursesUtils::Glyph& horizontalGlyph = GetGlyph(glyphTable, Palette::NORMAL, horizontal);
+		for (int x = left + 1; x < right; x++) {
+			CursesUtils::PrintGlyphAtPosition(horizontalGlyph, x, top);
+			CursesUtils::PrintGlyphAtPosition(horizontalGlyph, x, bottom);
+		}
+
+		// Sides.
+		const CursesUtils::Glyph& verticalGlyph = GetGlyph(glyphTable, Palette::NORMAL, vertical);
+		for (int y = top + 1; y < bottom; y++) {
+			CursesUtils::PrintGlyphAtPosition(verticalGlyph, left, y);
+			CursesUtils::PrintGlyphAtPosition(verticalGlyph, right, y);
+		}
+	}
+
+
 	void DrawHUD(const Game& game) {
 		// Lives.
 		Vector2D livesPos;
-		livesPos.x = 0;
-		livesPos.y = 0;
+		livesPos.x = game.layout.boardOffset.x;
+		livesPos.y = game.layout.boardOffset.y;
 		DrawLives(game, livesPos);
 
 		// Score.
 		Vector2D scorePos;
-		scorePos.x = CursesUtils::GetColumns() - Constants::SCORE_HUD_WIDTH;
-		scorePos.y = 0;
+		scorePos.x = game.layout.boardOffset.x + std::min(game.boardSize.x, game.layout.screenSize.x) - Constants::SCORE_HUD_WIDTH;
+		scorePos.y = game.layout.boardOffset.y;
 		DrawScore(game, scorePos);
+
+		// How to move, in between, when there's room for it.
+		int hudWidth = std::min(game.boardSize.x, game.layout.screenSize.x);
+		int hintLength = static_cast<int>(std::strlen(Constants::MOVE_HINT_TEXT));
+		if (game.scripts.isMoveHintShown && hudWidth >= hintLength + 2 * Constants::SCORE_HUD_WIDTH)
+			CursesUtils::PrintFormattedAtPosition(game.layout.boardOffset.x + (hudWidth - hintLength) / 2,
+			                                      game.layout.boardOffset.y, Constants::MOVE_HINT_TEXT);
 	}
 
 
 	void DrawScore(const Game& g, const Vector2D& pos) {
-		std::string scoreHUD = "Score: " + std::to_string(g.currentScore);
-		CursesUtils::PrintFormattedAtPosition(pos.x, pos.y, scoreHUD.c_str());
+		// Formatted on the stack, the HUD gets drawn every frame.
+		char scoreHUD[Constants::HUD_TEXT_SIZE];
+		FormatLabeledNumber(scoreHUD, sizeof(scoreHUD), "Score: ", g.currentScore);
+		CursesUtils::PrintFormattedAtPosition(pos.x, pos.y, scoreHUD);
 	}
 
 
 	void DrawLives(const Game& g, const Vector2D& pos) {
-		std::string livesHUD = "Lives: " + std::to_string(g.lives);
-		CursesUtils::PrintFormattedAtPosition(pos.x, pos.y, livesHUD.c_str());
+		// Formatted on the stack, the HUD gets drawn every frame.
+		char livesHUD[Constants::HUD_TEXT_SIZE];
+		FormatLabeledNumber(livesHUD, sizeof(livesHUD), "Lives: ", g.lives);
+		CursesUtils::PrintFormattedAtPosition(pos.x, pos.y, livesHUD);
 	}
 
 
-	void DrawHead(const Snake& snake) {
-		CursesUtils::PrintCharAtPosition(snake.sprite, snake.currentPosition.x, snake.currentPosition.y);
-	}
+	void FormatLabeledNumber(char* buffer, const std::size_t size, const char* label, const unsigned int value) {
+		// Copy as much of the label as fits, leaving room for the terminator.
+		std::size_t length = 0;
+		while (label[length] != '\0' && length + 1 < size) {
+			buffer[length] = label[length];
+			length++;
+		}
 
+		// Write the number right after the label, if it fits.
+		std::to_chars_result result = std::to_chars(buffer + length, buffer + size - 1, value);
+		if (result.ec == std::errc())
+			length = result.ptr - buffer;
 
-	void DrawTail(const Snake& snake) {
-		for (int i = 0; i < snake.tail.size(); i++)
-			CursesUtils::PrintCharAtPosition(snake.tail[i].sprite, snake.tail[i].currentPosition.x, snake.tail[i].currentPosition.y);
+		buffer[length] = '\0';
 	}
 
 
-	void DrawApple(const Apple& appl) {
-		CursesUtils::PrintCharAtPosition(appl.sprite, appl.position.x, appl.position.y);
+	void DrawHead(const Snake& snake, const Vector2D& offset, const Palette palette) {
+		// Pointing where it's going.
+		GlyphId id = static_cast<GlyphId>(static_cast<int>(GlyphId::HEAD_UP) + static_cast<int>(snake.currentDirection));
+		CursesUtils::PrintGlyphAtPosition(GetGlyph(glyphTable, palette, id),
+		                                  snake.currentPosition.x + offset.x, snake.currentPosition.y + offset.y);
 	}
 
 
-	void DrawText(const char* text, const Vector2D& position, const CursesUtils::Attribute attribute) {
-		// Turn on the attribute.
-		CursesUtils::ToggleAttribute(attribute, true);
+	void DrawTail(const Game& game, const Snake& snake, const Vector2D& offset, const Palette palette) {
+		bool isWrapping = game.rules.isWrapping;
 
-		// Print the text at the position.
-		CursesUtils::PrintFormattedAtPosition(position.x, position.y, text);
+		// Each piece joins the one ahead of it, starting with the head, and the one behind it.
+		Vector2D ahead = snake.currentPosition;
+		GlyphId id = GlyphId::BODY_LOOSE;
 
-		// Turn off the attribute.
-		CursesUtils::ToggleAttribute(attribute, false);
+		for (std::size_t i = 0; i < snake.tailLength; i++) {
+			const TailPiece& piece = GetTailPiece(snake, i);
+			const Vector2D& position = piece.currentPosition;
+
+			// Pieces piled up on the one ahead, like the ones just grown, look just like it.
+			if (position.x != ahead.x || position.y != ahead.y) {
+				unsigned int links = GetLinkBit(position, ahead, isWrapping);
+				if (i + 1 < snake.tailLength)
+					links |= GetLinkBit(position, GetTailPiece(snake, i + 1).currentPosition, isWrapping);
+
+				id = glyphTable.bodyGlyphs[links];
+			}
+
+			CursesUtils::PrintGlyphAtPosition(GetGlyph(glyphTable, palette, id), position.x + offset.x, position.y + offset.y);
+			ahead = position;
+		}
 	}
 
 
-	void DrawSelectedText(const char* text, const Vector2D& position) {
-		// Turn on the underline.
-		CursesUtils::ToggleAttribute(CursesUtils::Attribute::UNDERLINE, true);
+	void DrawApple(const Apple& appl, const Vector2D& offset) {
+		CursesUtils::PrintGlyphAtPosition(GetGlyph(glyphTable, Palette::NORMAL, GlyphId::APPLE),
+		                                  appl.position.x + offset.x, appl.position.y + offset.y);
+	}
 
-		// Draw the text.
-		CursesUtils::PrintFormattedAtPosition(position.x, position.y, text);
 
-		// Turn underline off.
-		CursesUtils::ToggleAttribute(CursesUtils::Attribute::UNDERLINE, false);
+	void DrawItem(const Item& item, const Vector2D& offset) {
+		// One glyph for each kind.
+		GlyphId id = static_cast<GlyphId>(static_cast<int>(GlyphId::BONUS_APPLE) + static_cast<int>(item.kind));
+		CursesUtils::PrintGlyphAtPosition(GetGlyph(glyphTable, Palette::NORMAL, id),
+		                                  item.position.x + offset.x, item.position.y + offset.y);
+	}
 
-		// Turn on the blink.
-		CursesUtils::ToggleAttribute(CursesUtils::Attribute::BLINK, true);
 
-		// Draw the selection marker to the left of the text.
-		CursesUtils::PrintCharAtPosition(Constants::SELECTED_BUTTON, position.x - 1, position.y);
+	void DrawText(const char* text, const Vector2D& position, const CursesUtils::Attribute attribute) {
+		// Turn on the attribute.
+		CursesUtils::ToggleAttribute(attribute, true);
+
+		// Print the text at the position.
+		CursesUtils::PrintFormattedAtPosition(position.x, position.y, text);
 
-		// Turn blink off.
-		CursesUtils::ToggleAttribute(CursesUtils::Attribute::BLINK, false);
+		// Turn off the attribute.
+		CursesUtils::ToggleAttribute(attribute, false);
 	}
 
 } /* namespace TextSnake */
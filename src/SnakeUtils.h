@@ -13,8 +13,17 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <ctime>
 
 #include "CursesUtils.h"
+#include "LeaderboardUtils.h"
+#include "RandomUtils.h"
+#include "LevelUtils.h"
+#include "StatsUtils.h"
+#include "TimerUtils.h"
+#include "ScriptUtils.h"
+#include "SaverUtils.h"
 
 namespace TextSnake {
 
@@ -26,7 +35,22 @@ namespace TextSnake {
 		static const char SPR_SNAKE_HEAD = '@';
 		static const char SPR_SNAKE_TAIL = '*';
 		static const char SPR_APPLE = 'o';
-		static const unsigned int DEFAULT_FPS = 6;
+		static const char SPR_HORIZONTAL_WALL = '-';
+		static const char SPR_VERTICAL_WALL = '|';
+		static const char SPR_LEVEL_WALL = '#';
+		static const char SPR_HORIZONTAL_WRAP = '.';
+		static const char SPR_VERTICAL_WRAP = ':';
+		static const char SPR_BONUS_APPLE = '$';
+		static const char SPR_SPEED_BOOST = '>';
+		static const char SPR_INVINCIBILITY = '+';
+		static const std::size_t MIN_RESERVED_TAIL_PIECES = 16;
+		static const std::size_t MAX_RESERVED_TAIL_PIECES = 1 << 16;
+		static const uint64_t EMPTY_CELL = ~0ull;
+		static const std::size_t NO_CELL_SLOT = ~static_cast<std::size_t>(0);
+		static const unsigned int LOOP_FPS = 60;
+		static const unsigned int SNAKE_CELLS_PER_SECOND = 6;
+		static const unsigned int MOVE_PRECISION = 1 << 16;
+		static const float DEFAULT_CELL_ASPECT_RATIO = 2.0f;
 		static const unsigned int SNAKE_DEFAULT_SPEED = 1;
 		static const CursesUtils::Color DEFAULT_COLOR = CursesUtils::Color::WHITE;
 		static const unsigned short TOTAL_LIVES = 3;
@@ -37,9 +61,23 @@ namespace TextSnake {
 		static const int X_MIN = 0;
 		static const int Y_MIN = 2;
 		static const unsigned short SCORE_HUD_WIDTH = 11;
+		static const std::size_t HUD_TEXT_SIZE = 32;
 		static const unsigned short OFFSET_FROM_MIDSCREEN = 5;
+		static const unsigned int MAX_APPLE_PICK_TRIES = 64;
 		static const unsigned int BASE_APPLE_POINTS = 10;
 		static const unsigned int SCORE_MULTIPLIER = 10;
+		static const unsigned int GROWTH_PER_APPLE = 1;
+		static const unsigned int BONUS_APPLE_POINTS = 50;
+		static const unsigned int SPEED_BOOST_FACTOR = 2;
+		static const unsigned int ITEM_SPAWN_TICKS = 8 * LOOP_FPS;
+		static const unsigned int ITEM_LIFETIME_TICKS = 5 * LOOP_FPS;
+		static const unsigned int SPEED_BOOST_TICKS = 4 * LOOP_FPS;
+		static const unsigned int INVINCIBILITY_TICKS = 4 * LOOP_FPS;
+		static const unsigned int RESPAWN_DELAY_TICKS = LOOP_FPS;
+		static const unsigned int RESPAWN_BLINK_TICKS = LOOP_FPS / 12;
+		static const unsigned int RESPAWN_BLINKS = RESPAWN_DELAY_TICKS / (2 * RESPAWN_BLINK_TICKS);
+		static const std::size_t RESERVED_TIMERS = 64;
+		static const char* MOVE_HINT_TEXT = "Arrow keys to move";
 		static const unsigned short INTRO_TEXT_OFFSET = 7;
 		static const unsigned short MENU_TEXT_DIST = 2;
 		static const unsigned short FIRST_ENTRY_TEXT_OFFSET = 2;
@@ -50,9 +88,16 @@ namespace TextSnake {
 		static const unsigned short START_LOW_LETTERS = 97;
 		static const unsigned short START_DIGITS = 48;
 		static const char* HIGH_SCORES_FILENAME = "HighScores.bin";
+		static const char* HIGH_SCORES_JOURNAL_FILENAME = "HighScores.journal";
+		static const std::size_t HIGH_SCORES_COMPACTION_SIZE = 64 * 1024;
 		static const unsigned short MAX_HIGH_SCORES_ON_SCREEN = 8;
+		static const unsigned int MAX_HIGH_SCORES = 1000000;
 		static const short GREEN_ON_BLACK_ID = 1;
 		static const short RED_ON_BLACK_ID = 2;
+		static const short YELLOW_ON_BLACK_ID = 3;
+		static const char* REPLAY_FILENAME = "LastGame.replay";
+		static const unsigned int REPLAY_KEYFRAME_INTERVAL = 256;
+		static const unsigned int REPLAY_SEEK_STEP = 5 * LOOP_FPS;
 
 
 #ifdef SNAKE_UTILS_IN_GAME_DEBUG
@@ -94,6 +139,15 @@ namespace TextSnake {
 		LEFT
 	};
 
+	/*
+	 * Sets of colors the board gets drawn in. Only the snake's colors differ between them.
+	 */
+	enum class Palette {
+		NORMAL,
+		INVINCIBLE,
+		TOTAL
+	};
+
 	/*
 	 * Represents the directions taken by the menu selector.
 	 */
@@ -103,6 +157,24 @@ namespace TextSnake {
 		DOWN
 	};
 
+	/*
+	 * What the game's timers are for.
+	 */
+	enum class TimerEvent : uint32_t {
+		SPAWN_ITEM,
+		ITEM_EXPIRED,
+		EFFECT_OVER
+	};
+
+	/*
+	 * Kinds of items showing up on the board every now and then.
+	 */
+	enum class ItemKind {
+		BONUS_APPLE,
+		SPEED_BOOST,
+		INVINCIBILITY
+	};
+
 	/*
 	 * Represents a position (x and y) in 2D space.
 	 */
@@ -123,8 +195,59 @@ namespace TextSnake {
 		CursesUtils::Color color;
 	};
 
+	/*
+	 * Hash table of cells with open addressing and linear probing, never more than half full.
+	 * A cell's key has its column in the high half and its row in the low one. The keys are kept apart
+	 * from the values, so looking for a cell goes through as few cache lines as it can.
+	 * It's for the few cells that need more than a bit, nothing that grows with the board.
+	 * cells: Key of the cell in each slot, EMPTY_CELL for a slot with none. A power of two of them.
+	 * values: What the table keeps for the cell in each slot.
+	 * totalCells: Cells in the table.
+	 * hashShift: Bits dropped off a hashed key to get its first slot.
+	 */
+	struct CellTable {
+		std::vector<uint64_t> cells;
+		std::vector<uint32_t> values;
+		std::size_t totalCells;
+		unsigned int hashShift;
+	};
+
+	/*
+	 * Which cells of the board the snake is on, so telling whether a cell is taken doesn't mean going
+	 * through the whole tail. One bit per cell, laid out like the level's masks, is allocated once per board.
+	 * Only an invincible snake ever has more than one piece on a cell, those few get counted apart.
+	 * Finding a free cell for an apple only needs a list of them once the board is too crowded for random
+	 * picks. The list is built then, from the bits and the level's masks, and kept up to date from there on:
+	 * freed cells get added, taken ones are left in it as stale until they're half of it.
+	 * level: Level whose walls and apple zones tell where apples go, nullptr when there's none.
+	 * width: Columns on the board.
+	 * height: Rows on the board, the HUD's ones left out.
+	 * rowWords: 64 bit words per row.
+	 * taken: A bit set for each cell with at least one piece on it.
+	 * stacked: Pieces past the first one on each cell that has more.
+	 * isListingFreeCells: True once the free cells are listed.
+	 * listed: A bit set for each cell in freeCells, laid out like taken.
+	 * freeCells: Cells apples go on that had no pieces on them when listed, in no particular order.
+	 * totalStaleCells: Cells in freeCells the snake took since.
+	 */
+	struct Occupancy {
+		const Level* level;
+		int width;
+		int height;
+		std::size_t rowWords;
+		std::vector<uint64_t> taken;
+		CellTable stacked;
+		bool isListingFreeCells;
+		std::vector<uint64_t> listed;
+		std::vector<uint64_t> freeCells;
+		std::size_t totalStaleCells;
+	};
+
 	/*
 	 * Represents the snake.
+	 * The tail is a ring buffer: its first piece, the one right behind the head, is at tailFront
+	 * and the other ones follow it, wrapping around the end of the vector. Moving the snake only
+	 * takes its last piece and puts it right behind the head, however long the tail is.
 	 */
 	struct Snake {
 		Vector2D currentPosition;
@@ -132,9 +255,13 @@ namespace TextSnake {
 		Direction currentDirection;
 		Direction previousDirection;
 		unsigned int speed;
+		uint64_t moveProgress;
 		char sprite;
 		CursesUtils::Color color;
 		std::vector<TailPiece> tail;
+		std::size_t tailFront;
+		std::size_t tailLength;
+		Occupancy occupancy;
 	};
 
 	/*
@@ -147,11 +274,48 @@ namespace TextSnake {
 	};
 
 	/*
-	 * Represents a score.
+	 * An item lying on the board until it gets eaten or it expires.
+	 */
+	struct Item {
+		ItemKind kind;
+		Vector2D position;
+		char sprite;
+		TimerHandle expiryTimer;
+	};
+
+	/*
+	 * Timed effects on the snake, each one lasts as long as its timer is pending.
+	 * speedBoost: The snake moves faster.
+	 * invincibility: The snake goes through its own tail.
+	 * respawn: The snake waits before moving again after losing a life.
 	 */
-	struct Score {
-		unsigned int score;
-		std::string name;
+	struct Effects {
+		TimerHandle speedBoost;
+		TimerHandle invincibility;
+		TimerHandle respawn;
+	};
+
+	/*
+	 * Scripts playing animations on top of the game.
+	 */
+	enum class ScriptId : uint32_t {
+		MOVE_HINT,
+		RESPAWN_BLINK,
+		TOTAL
+	};
+
+	/*
+	 * Scripts and what they show, the drawing code only looks at the latter.
+	 * timers: Wakes up the scripts waiting for ticks, it ticks on every screen.
+	 * list: Every script, by id.
+	 * isMoveHintShown: The HUD tells how to move, until the first key of the game.
+	 * isSnakeHidden: The snake blinks while it waits to move again after losing a life.
+	 */
+	struct Scripts {
+		TimerWheel timers;
+		Script list[static_cast<std::size_t>(ScriptId::TOTAL)];
+		bool isMoveHintShown;
+		bool isSnakeHidden;
 	};
 
 	/*
@@ -165,6 +329,56 @@ namespace TextSnake {
 		Screen relatedScreen;
 	};
 
+	/*
+	 * How long it takes the snake to cross a cell along each axis.
+	 * Distances are in fractions of a cell's width (MOVE_PRECISION is a whole width).
+	 */
+	struct MoveTiming {
+		uint64_t distancePerFrame;
+		uint64_t horizontalCellCost;
+		uint64_t verticalCellCost;
+	};
+
+	/*
+	 * Screen geometry, cached so drawing doesn't have to ask curses every frame.
+	 * It only changes when the terminal gets resized.
+	 */
+	struct Layout {
+		Vector2D screenSize;
+		Vector2D screenCenter;
+		Vector2D boardOffset;
+		unsigned int generation;
+	};
+
+	/*
+	 * A piece of text laid out on the screen.
+	 */
+	struct ScreenText {
+		std::string text;
+		Vector2D position;
+		CursesUtils::Attribute attribute;
+	};
+
+	/*
+	 * Everything shown on a screen that doesn't change every frame (menus, game over, high scores),
+	 * laid out once and drawn as it is until something on it changes.
+	 */
+	struct ScreenCache {
+		bool isValid;
+		Screen screen;
+		std::vector<ScreenText> texts;
+	};
+
+	/*
+	 * Rules the game is played with.
+	 */
+	struct GameRules {
+		bool isWrapping;
+		unsigned int growthPerApple;
+		unsigned int baseApplePoints;
+		unsigned int scoreMultiplier;
+	};
+
 	/*
 	 * Represents the game e.g. states, scores etc.
 	 */
@@ -172,13 +386,31 @@ namespace TextSnake {
 		unsigned short lives;
 		unsigned int currentScore;
 		Score finalScore;
+		std::size_t finalRank;
 		Apple apple;
 		bool isAppleOnScreen;
 		std::vector<MenuEntry> mainMenuEntries;
 		SelectorDirection selectorDirection;
-		std::vector<Score> highScores;
+		Leaderboard highScores;
+		std::size_t highScoresPage;
 		State currentState;
 		Screen currentScreen;
+		Vector2D boardSize;
+		Layout layout;
+		ScreenCache screenCache;
+		GameRules rules;
+		MoveTiming moveTiming;
+		RandomGenerator random;
+		const Level* level;
+		ScoreSaver* scoreSaver;
+		ScoreLoader* scoreLoader;
+		bool isWrapModeOn;
+		TimerWheel timers;
+		Item item;
+		bool isItemOnScreen;
+		Effects effects;
+		bool isWon;
+		Scripts scripts;
 	};
 
 
@@ -186,8 +418,31 @@ namespace TextSnake {
 
 	/*
 	 * Starts up the game.
+	 * seed: Seed for the game's random number generator, the same seed and the same inputs play the same game.
+	 * levelFilename: ASCII map to play on, nullptr to play on an empty board the size of the screen.
+	 * isWrapModeOn: True to play on a board whose borders wrap around instead of being walls.
+	 * statsName: Shared memory segment to publish live stats in, nullptr to not publish any.
+	 * isTracingStartup: True to print how long each startup phase took once the game is over.
 	 */
-	void Start();
+	void Start(const uint64_t seed, const char* levelFilename, const bool isWrapModeOn, const char* statsName,
+	           const bool isTracingStartup);
+
+	/*
+	 * Counts the ticks the game loop ran late and the ones it skipped because of it.
+	 * publisher: Live stats to update.
+	 * deltaTime: Time since the previous tick.
+	 */
+	void CountLateTicks(LiveStatsPublisher& publisher, const clock_t deltaTime);
+
+	/*
+	 * Publishes the live stats at the end of a tick.
+	 * publisher: Live stats to update.
+	 * game: Instance of the game.
+	 * snake: Instance of the snake.
+	 * frameNanos: Time spent on this tick.
+	 * isRepainting: True when this tick drew the screen.
+	 */
+	void PublishGameStats(LiveStatsPublisher& publisher, const Game& game, const Snake& snake, const uint64_t frameNanos, const bool isRepainting);
 
 	/*
 	 * Initializes everything as a brand new instance.
@@ -200,13 +455,14 @@ namespace TextSnake {
 	/*
 	 * Initializes the color pairs.
 	 */
-	inline void InitColors();
+	void InitColors();
 
 	/*
 	 * Initializes the snake's data.
 	 * s: snake to initialize.
+	 * g: game the snake belongs to.
 	 */
-	void InitSnake(Snake& s);
+	void InitSnake(Snake& s, Game& g);
 
 	/*
 	 * Initializes the game's data.
@@ -220,6 +476,26 @@ namespace TextSnake {
 	 */
 	void InitMenu(Game& game);
 
+	/*
+	 * Centers the menu entries in the screen.
+	 * game: Instance of the game.
+	 */
+	void PositionMenuEntries(Game& game);
+
+	/*
+	 * Caches the new size of the screen and lays everything out again.
+	 * game: Instance of the game.
+	 * columns: Number of columns on the screen.
+	 * rows: Number of rows on the screen.
+	 */
+	void ResizeScreen(Game& game, const int columns, const int rows);
+
+	/*
+	 * Recalculates everything in the layout that depends on the screen's and the board's size.
+	 * game: Instance of the game.
+	 */
+	void UpdateLayout(Game& game);
+
 	/*
 	 * Analyzes the input and act accordingly.
 	 * inpt: Input to write to.
@@ -228,6 +504,14 @@ namespace TextSnake {
 	 */
 	void HandleInput(int& inpt, Game& g, Snake& s);
 
+	/*
+	 * Acts on an input that has already been read.
+	 * inpt: Input to act on.
+	 * g: Instance of the game.
+	 * s: Instance of the snake.
+	 */
+	void ApplyInput(const int inpt, Game& g, Snake& s);
+
 	/*
 	 * Decides what state to go to when the enter key is pressed.
 	 * game: Game instance.
@@ -236,29 +520,28 @@ namespace TextSnake {
 	void EnterKeyPressed(Game& game, Snake& snake);
 
 	/*
-	 * Saves the high scores to a file.
-	 * gm: Instance of the game.
-	 */
-	void SaveHighScores(const Game& gm);
-
-	/*
-	 * Compares two scores and returns the higher one.
-	 * score1: First score.
-	 * score2: Second score.
+	 * Saves a new high score by appending it to the high scores journal, in the background when the game
+	 * has a saver and right away otherwise.
+	 * game: Instance of the game.
+	 * score: The score to save.
 	 */
-	bool GetHigher(const Score& score1, const Score& score2);
+	void SaveHighScore(Game& game, const Score& score);
 
 	/*
-	 * Loads the high scores into the vector.
+	 * Makes sure the high scores are in the leaderboard, taking them from the loader if they aren't yet.
+	 * It waits for the loader when it's still reading them. Nothing happens when there's no loader.
 	 * gm: Instance of the game.
 	 */
-	void LoadHighScores(Game& gm);
+	void EnsureHighScoresLoaded(Game& gm);
 
 	/*
-	 * Tweaks the FPS based on the snake direction and returns it.
-	 * snake: Instance of the snake.
+	 * Works out how long it takes the snake to cross a cell horizontally and vertically,
+	 * so it moves just as fast on screen in every direction without changing the frame rate.
+	 * It only needs to run once and whenever the terminal is resized.
+	 * game: Instance of the game.
+	 * cellAspectRatio: Height of a terminal cell divided by its width (0 or less when unknown).
 	 */
-	unsigned int AdjustFPSbasedOnDirection(const Snake& snake);
+	void UpdateMoveTiming(Game& game, float cellAspectRatio);
 
 	/*
 	 * Calls all the functions that deal with game updates.
@@ -268,6 +551,15 @@ namespace TextSnake {
 	 */
 	void Update(Game& g, Snake& s, int in);
 
+	/*
+	 * Runs a whole tick of the game (input and update) without drawing anything.
+	 * Used to simulate games headlessly e.g. when watching a replay.
+	 * g: Instance of the current game.
+	 * s: Instance of the snake.
+	 * in: The input for this tick.
+	 */
+	void SimulateTick(Game& g, Snake& s, int in);
+
 	/*
 	 * Draws the game to the screen.
 	 * g: Instance of the game.
@@ -281,6 +573,54 @@ namespace TextSnake {
 	 */
 	void UpdateScreen(Game& game);
 
+	/*
+	 * Stops every script and clears what they show, before any of them ran.
+	 * game: Instance of the game.
+	 */
+	void InitScripts(Game& game);
+
+	/*
+	 * Starts the scripts of the screen just shown, stopping the ones of the previous screen.
+	 * game: Instance of the game.
+	 */
+	void StartScreenScripts(Game& game);
+
+	/*
+	 * Starts a script over from the top, it runs right away until it waits for something.
+	 * game: Instance of the game.
+	 * id: Script to start.
+	 */
+	void StartScript(Game& game, const ScriptId id);
+
+	/*
+	 * Runs a script on from where it waited.
+	 * game: Instance of the game.
+	 * id: Script to run.
+	 */
+	void ResumeScript(Game& game, const ScriptId id);
+
+	/*
+	 * Wakes up the scripts whose wait is over: the ones waiting for a key when there's one, and the ones
+	 * waiting for ticks when they're up. Runs once per tick, on every screen.
+	 * game: Instance of the game.
+	 * input: User's input.
+	 */
+	inline void UpdateScripts(Game& game, const int input);
+
+	/*
+	 * Script telling how to move at the start of a game, until the first key gets pressed.
+	 * game: Instance of the game.
+	 * script: Where the script is at.
+	 */
+	void RunMoveHint(Game& game, Script& script);
+
+	/*
+	 * Script blinking the snake while it waits to move again after losing a life.
+	 * game: Instance of the game.
+	 * script: Where the script is at.
+	 */
+	void RunRespawnBlink(Game& game, Script& script);
+
 	/*
 	 * Runs the main menu related logic.
 	 * game: Game instance.
@@ -295,17 +635,48 @@ namespace TextSnake {
 	void UpdateGameOver(Game& game, int input);
 
 	/*
-	 * Runs the main game related logic.
+	 * Runs the main game related logic for a frame, moving the snake whenever it reaches the next cell.
 	 * game: Instance of the game.
 	 * snake: Instance of the snake.
 	 */
 	inline void UpdateMainGame(Game& game, Snake& snake);
 
 	/*
-	 * Draws the main menu related things.
+	 * Lays out the current screen again when it changed since the last time it was laid out.
+	 * game: Instance of the game.
+	 * Returns true when the screen has to be repainted.
+	 */
+	bool UpdateScreenCache(Game& game);
+
+	/*
+	 * Marks the current screen's layout as out of date, so it gets laid out and repainted again.
 	 * game: Instance of the game.
 	 */
-	void DrawMainMenu(const Game& game);
+	void InvalidateScreenCache(Game& game);
+
+	/*
+	 * Adds a piece of text to the current screen's layout.
+	 * game: Instance of the game.
+	 * text: Text to show.
+	 * position: Where the text starts.
+	 * attribute: Attribute to draw the text with.
+	 */
+	void AddScreenText(Game& game, const std::string& text, const Vector2D& position, const CursesUtils::Attribute attribute);
+
+	/*
+	 * Adds a piece of text horizontally centered in the screen to the current screen's layout.
+	 * game: Instance of the game.
+	 * text: Text to show.
+	 * y: Row the text goes in.
+	 * attribute: Attribute to draw the text with.
+	 */
+	void AddCenteredScreenText(Game& game, const std::string& text, const int y, const CursesUtils::Attribute attribute);
+
+	/*
+	 * Lays out the main menu.
+	 * game: Instance of the game.
+	 */
+	void LayoutMainMenu(Game& game);
 
 	/*
 	 * Draws the game related things.
@@ -315,16 +686,22 @@ namespace TextSnake {
 	void DrawMainGame(const Game& game, const Snake& snake);
 
 	/*
-	 * Draws the game over screen.
+	 * Lays out the game over screen.
+	 * game: Instance of the game.
+	 */
+	void LayoutGameOver(Game& game);
+
+	/*
+	 * Lays out the high scores screen.
 	 * game: Instance of the game.
 	 */
-	void DrawGameOver(const Game& game);
+	void LayoutHighScores(Game& game);
 
 	/*
-	 * Draws the high scores screen.
+	 * Draws the current screen as it was laid out.
 	 * game: Instance of the game.
 	 */
-	void DrawHighScores(const Game& game);
+	void DrawScreenCache(const Game& game);
 
 	/*
 	 * Updates the position of every piece of the snake's tail so they're ready for the next frame.
@@ -351,8 +728,16 @@ namespace TextSnake {
 	 * and if it did, it will lose one life.
 	 * snk: Instance of the snake.
 	 * gm: Instance of the game.
+	 * Returns true when the snake collided.
 	 */
-	void DieOnCollision(Snake& snk, Game& gm);
+	bool DieOnCollision(Snake& snk, Game& gm);
+
+	/*
+	 * Ends the game and moves on to the game over screen.
+	 * game: Instance of the game.
+	 * isWon: True when the snake filled the board, false when it ran out of lives.
+	 */
+	void EndGame(Game& game, const bool isWon);
 
 	/*
 	 * Resets the snake when it collides with something other than apples
@@ -360,7 +745,7 @@ namespace TextSnake {
 	 * snake: Instance of the snake.
 	 * game: Instance of the game.
 	 */
-	void ResetSnake(Snake& snake, const Game& game);
+	void ResetSnake(Snake& snake, Game& game);
 
 	/*
 	 * On collision with an apple, the snake will eat it and increase its score.
@@ -372,23 +757,34 @@ namespace TextSnake {
 	/*
 	 * Calculates the score based on the snake's length.
 	 * snake: Instance of the snake.
+	 * game: Instance of the game.
 	 */
-	unsigned int CalcScore(const Snake& snake);
+	unsigned int CalcScore(const Snake& snake, const Game& game);
 
 	/*
 	 * Spawns an apple whenever it's possible.
 	 * game: Instance of the game.
 	 * snake: Instance of the snake.
 	 */
-	void SpawnApple(Game& game, const Snake& snake);
+	void SpawnApple(Game& game, Snake& snake);
 
 	/*
 	 * Picks a random position on the screen free of any obstacles
 	 * and assigns it to the given argument.
 	 * s: Instance of the snake.
+	 * g: Instance of the game.
 	 * p: Position to fill in.
+	 * Returns false when there's no free position left on the board.
 	 */
-	void PickRandomApplePos(const Snake& s, Vector2D& p);
+	bool PickRandomApplePos(Snake& s, Game& g, Vector2D& p);
+
+	/*
+	 * Initializes an item's data.
+	 * item: Item to initialize.
+	 * kind: What kind of item it is.
+	 * p: horizontal and vertical position on the screen.
+	 */
+	void InitItem(Item& item, const ItemKind kind, const Vector2D& p);
 
 	/*
 	 * Initializes an apple's data
@@ -403,6 +799,137 @@ namespace TextSnake {
 	 */
 	void MakeTailPiece(Snake& s);
 
+	/*
+	 * Adds a piece to the end of the snake's tail.
+	 * The tail only allocates when it's longer than it ever was.
+	 * snake: Instance of the snake.
+	 * piece: Piece to add.
+	 */
+	void PushTailPiece(Snake& snake, const TailPiece& piece);
+
+	/*
+	 * Returns how many pieces the snake's tail has.
+	 * snake: Instance of the snake.
+	 */
+	inline std::size_t GetTailLength(const Snake& snake) {
+		return snake.tailLength;
+	}
+
+	/*
+	 * Returns a piece of the snake's tail, counting from the head.
+	 * snake: Instance of the snake.
+	 * i: Index of the piece, below the tail's length.
+	 */
+	inline const TailPiece& GetTailPiece(const Snake& snake, const std::size_t i) {
+		std::size_t index = snake.tailFront + i;
+		if (index >= snake.tail.size())
+			index -= snake.tail.size();
+
+		return snake.tail[index];
+	}
+
+	/*
+	 * Key of a cell in a CellTable, counted from the board's first cell.
+	 * column: The cell's column on the board.
+	 * row: The cell's row on the board.
+	 */
+	inline uint64_t GetCellKey(const unsigned int column, const unsigned int row) {
+		return (static_cast<uint64_t>(column) << 32) | row;
+	}
+
+	/*
+	 * Slot a cell gets looked for from in a table.
+	 * Fibonacci hashing spreads the neighbouring cells a snake takes all over the table.
+	 * table: Table to look in.
+	 * cell: The cell's key.
+	 */
+	inline std::size_t GetFirstCellSlot(const CellTable& table, const uint64_t cell) {
+		return static_cast<std::size_t>((cell * 0x9E3779B97F4A7C15ull) >> table.hashShift);
+	}
+
+	/*
+	 * Finds a cell in a table.
+	 * table: Table to look in.
+	 * cell: The cell's key.
+	 * Returns the cell's slot, NO_CELL_SLOT when it isn't in the table.
+	 */
+	inline std::size_t FindCellSlot(const CellTable& table, const uint64_t cell) {
+		if (table.totalCells == 0)
+			return Constants::NO_CELL_SLOT;
+
+		std::size_t mask = table.cells.size() - 1;
+		std::size_t slot = GetFirstCellSlot(table, cell);
+
+		// The table is never full, so there's always an empty slot to stop at.
+		while (table.cells[slot] != Constants::EMPTY_CELL) {
+			if (table.cells[slot] == cell)
+				return slot;
+
+			slot = (slot + 1) & mask;
+		}
+
+		return Constants::NO_CELL_SLOT;
+	}
+
+	/*
+	 * Counts the snake's pieces on the cell, head included.
+	 * Cells outside the board never have any.
+	 * occupancy: The snake's occupancy.
+	 * x: The cell's column.
+	 * y: The cell's row.
+	 */
+	inline unsigned int CountOccupants(const Occupancy& occupancy, const int x, const int y) {
+		// Cells before the board turn into huge unsigned numbers, one comparison per axis is enough.
+		unsigned int column = static_cast<unsigned int>(x - Constants::X_MIN);
+		unsigned int row = static_cast<unsigned int>(y - Constants::Y_MIN);
+
+		if (column >= static_cast<unsigned int>(occupancy.width) || row >= static_cast<unsigned int>(occupancy.height))
+			return 0;
+
+		if (!IsMaskBitSet(occupancy.taken.data(), occupancy.rowWords, static_cast<int>(column), static_cast<int>(row)))
+			return 0;
+
+		// Almost always a single piece, unless the snake went through itself.
+		std::size_t slot = FindCellSlot(occupancy.stacked, GetCellKey(column, row));
+		return (slot != Constants::NO_CELL_SLOT) ? 1 + occupancy.stacked.values[slot] : 1;
+	}
+
+	/*
+	 * Sets the snake's occupancy up for the board and counts the head and every piece of the tail in it.
+	 * The bits only get allocated when the board's size changed, otherwise they're cleared, 64 cells at a time.
+	 * The free cells aren't listed until they're needed again.
+	 * snake: Instance of the snake.
+	 * game: Instance of the game.
+	 */
+	void InitOccupancy(Snake& snake, const Game& game);
+
+	/*
+	 * Lists every cell an apple could go on that the snake isn't on, unless they're listed already.
+	 * It goes through the bits and the level's masks a word at a time, and it's only done once random picks keep missing.
+	 * occupancy: The snake's occupancy.
+	 */
+	void ListFreeCells(Occupancy& occupancy);
+
+	/*
+	 * Takes the snake's head and every piece of its tail off their cells, in time proportional to the snake.
+	 * snake: Instance of the snake.
+	 */
+	void VacateSnake(Snake& snake);
+
+	/*
+	 * Counts one more piece of the snake on a cell, nothing happens outside the board.
+	 * occupancy: The snake's occupancy.
+	 * p: The cell.
+	 */
+	void OccupyCell(Occupancy& occupancy, const Vector2D& p);
+
+	/*
+	 * Counts one less piece of the snake on a cell, nothing happens outside the board.
+	 * occupancy: The snake's occupancy.
+	 * p: The cell.
+	 */
+	void VacateCell(Occupancy& occupancy, const Vector2D& p);
+
 	/*
 	 * Sets the direction and position of a newly created tail piece.
 	 * snake: Instance of the snake.
@@ -410,6 +937,27 @@ namespace TextSnake {
 	 */
 	void SetNewTailPieceDirAndPos(const Snake& snake, TailPiece& tailPiece);
 
+	/*
+	 * Returns where the board starts on the screen for this frame.
+	 * Boards bigger than the screen scroll to follow the snake.
+	 * game: Instance of the game.
+	 * snake: Instance of the snake.
+	 */
+	Vector2D GetBoardView(const Game& game, const Snake& snake);
+
+	/*
+	 * Draws the level's walls that are on the screen.
+	 * game: Instance of the game, it has to have a level.
+	 * view: Where the board starts on the screen.
+	 */
+	void DrawLevelWalls(const Game& game, const Vector2D& view);
+
+	/*
+	 * Draws the walls around the board, used when the board is smaller than the screen.
+	 * game: Instance of the game.
+	 */
+	void DrawBoardFrame(const Game& game);
+
 	/*
 	 * Draws the HUD.
 	 * game: Instance of the game.
@@ -431,22 +979,45 @@ namespace TextSnake {
 	inline void DrawLives(const Game& g, const Vector2D& pos);
 
 	/*
-	 * Draws the snake's head.
+	 * Writes a label followed by a number into a buffer, without allocating.
+	 * The result gets cut short when it doesn't fit, it's always null terminated.
+	 * buffer: Where to write.
+	 * size: Size of the buffer.
+	 * label: Text before the number.
+	 * value: Number to write.
+	 */
+	void FormatLabeledNumber(char* buffer, const std::size_t size, const char* label, const unsigned int value);
+
+	/*
+	 * Draws the snake's head, pointing where it's going.
 	 * snake: Instance of the snake.
+	 * offset: Where the board starts on the screen.
+	 * palette: Colors to draw it in.
 	 */
-	inline void DrawHead(const Snake& snake);
+	inline void DrawHead(const Snake& snake, const Vector2D& offset, const Palette palette);
 
 	/*
-	 * Draws the tail pieces.
+	 * Draws the tail pieces, each one joined to its neighbours.
+	 * game: Instance of the game, for whether the board wraps.
 	 * snake: Instance of the snake.
+	 * offset: Where the board starts on the screen.
+	 * palette: Colors to draw it in.
 	 */
-	inline void DrawTail(const Snake& snake);
+	inline void DrawTail(const Game& game, const Snake& snake, const Vector2D& offset, const Palette palette);
 
 	/*
 	 * Draws an apple.
 	 * appl: Apple to draw.
+	 * offset: Where the board starts on the screen.
 	 */
-	inline void DrawApple(const Apple& appl);
+	inline void DrawApple(const Apple& appl, const Vector2D& offset);
+
+	/*
+	 * Draws an item.
+	 * item: Item to draw.
+	 * offset: Where the board starts on the screen.
+	 */
+	inline void DrawItem(const Item& item, const Vector2D& offset);
 
 	/*
 	 * Draws the given text at the given position with the given attribute.
@@ -456,14 +1027,6 @@ namespace TextSnake {
 	 */
 	inline void DrawText(const char* text, const Vector2D& position, const CursesUtils::Attribute attribute);
 
-	/*
-	 * Draws the given text at the given position underlined.
-	 * It also draws a little blinking selection marker next to it.
-	 * text: Text to write.
-	 * position: Where to draw the text.
-	 */
-	void DrawSelectedText(const char* text, const Vector2D& position);
-
 
 } /* namespace TextSnake */
 
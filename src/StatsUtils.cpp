@@ -0,0 +1,171 @@
+/*
+ * StatsUtils.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#include "StatsUtils.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace TextSnake {
+
+	namespace {
+
+		// "TSST" in little endian.
+		const uint32_t STATS_MAGIC = 0x54535354;
+		const uint32_t STATS_VERSION = 1;
+
+	}
+
+	bool OpenLiveStats(LiveStatsPublisher& publisher, const char* name) {
+		publisher.segment = nullptr;
+		publisher.name = name;
+		std::memset(&publisher.stats, 0, sizeof(publisher.stats));
+		publisher.totalFrameSamples = 0;
+
+		// Never take over a segment someone else made, it may well be another game's.
+		int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+		if (fd < 0)
+			return false;
+
+		// The segment is this game's from here on, so it's the one to remove it if anything goes wrong.
+		if (ftruncate(fd, sizeof(LiveStatsSegment)) != 0) {
+			int error = errno;
+			close(fd);
+			shm_unlink(name);
+			errno = error;
+			return false;
+		}
+
+		void* memory = mmap(nullptr, sizeof(LiveStatsSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		int error = errno;
+		close(fd);
+
+		if (memory == MAP_FAILED) {
+			shm_unlink(name);
+			errno = error;
+			return false;
+		}
+
+		// The segment starts zeroed, the counters only need their object lifetime started.
+		publisher.segment = new (memory) LiveStatsSegment();
+		publisher.segment->magic = STATS_MAGIC;
+		publisher.segment->version = STATS_VERSION;
+
+		publisher.stats.pid = static_cast<uint64_t>(getpid());
+		PublishLiveStats(publisher);
+
+		return true;
+	}
+
+
+	void CloseLiveStats(LiveStatsPublisher& publisher) {
+		if (publisher.segment == nullptr)
+			return;
+
+		munmap(publisher.segment, sizeof(LiveStatsSegment));
+		shm_unlink(publisher.name.c_str());
+		publisher.segment = nullptr;
+	}
+
+
+	void RecordFrameTime(LiveStatsPublisher& publisher, const uint64_t nanos) {
+		publisher.frameNanos[publisher.totalFrameSamples & (Constants::STATS_FRAME_SAMPLES - 1)] = nanos;
+		publisher.totalFrameSamples++;
+	}
+
+
+	void UpdateSlowStats(LiveStatsPublisher& publisher) {
+		// Work the p99 out on a copy, so the samples stay in the order they came in.
+		std::size_t totalSamples = static_cast<std::size_t>(std::min<uint64_t>(publisher.totalFrameSamples, Constants::STATS_FRAME_SAMPLES));
+		if (totalSamples > 0) {
+			uint64_t samples[Constants::STATS_FRAME_SAMPLES];
+			std::copy(publisher.frameNanos, publisher.frameNanos + totalSamples, samples);
+
+			std::size_t rank = (totalSamples * 99) / 100;
+			std::nth_element(samples, samples + rank, samples + totalSamples);
+			publisher.stats.p99FrameNanos = samples[rank];
+		}
+	}
+
+
+	void PublishLiveStats(LiveStatsPublisher& publisher) {
+		LiveStatsSegment& segment = *publisher.segment;
+		const LiveStats& stats = publisher.stats;
+
+		// An odd sequence tells the readers a write is going on.
+		uint64_t sequence = segment.sequence.load(std::memory_order_relaxed);
+		segment.sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		segment.pid.store(stats.pid, std::memory_order_relaxed);
+		segment.ticks.store(stats.ticks, std::memory_order_relaxed);
+		segment.frames.store(stats.frames, std::memory_order_relaxed);
+		segment.lateTicks.store(stats.lateTicks, std::memory_order_relaxed);
+		segment.droppedTicks.store(stats.droppedTicks, std::memory_order_relaxed);
+		segment.terminalBytes.store(stats.terminalBytes, std::memory_order_relaxed);
+		segment.p99FrameNanos.store(stats.p99FrameNanos, std::memory_order_relaxed);
+		segment.score.store(stats.score, std::memory_order_relaxed);
+		segment.length.store(stats.length, std::memory_order_relaxed);
+
+		// Even again, the counters are consistent.
+		segment.sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+
+	const LiveStatsSegment* AttachLiveStats(const char* name) {
+		int fd = shm_open(name, O_RDONLY, 0);
+		if (fd < 0)
+			return nullptr;
+
+		void* memory = mmap(nullptr, sizeof(LiveStatsSegment), PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+
+		if (memory == MAP_FAILED)
+			return nullptr;
+
+		const LiveStatsSegment* segment = static_cast<const LiveStatsSegment*>(memory);
+		if (segment->magic != STATS_MAGIC || segment->version != STATS_VERSION) {
+			munmap(memory, sizeof(LiveStatsSegment));
+			return nullptr;
+		}
+
+		return segment;
+	}
+
+
+	void ReadLiveStats(const LiveStatsSegment& segment, LiveStats& stats) {
+		while (true) {
+			uint64_t sequence = segment.sequence.load(std::memory_order_acquire);
+
+			// The game is writing right now.
+			if (sequence & 1)
+				continue;
+
+			stats.pid = segment.pid.load(std::memory_order_relaxed);
+			stats.ticks = segment.ticks.load(std::memory_order_relaxed);
+			stats.frames = segment.frames.load(std::memory_order_relaxed);
+			stats.lateTicks = segment.lateTicks.load(std::memory_order_relaxed);
+			stats.droppedTicks = segment.droppedTicks.load(std::memory_order_relaxed);
+			stats.terminalBytes = segment.terminalBytes.load(std::memory_order_relaxed);
+			stats.p99FrameNanos = segment.p99FrameNanos.load(std::memory_order_relaxed);
+			stats.score = segment.score.load(std::memory_order_relaxed);
+			stats.length = segment.length.load(std::memory_order_relaxed);
+
+			// The copy only counts when nothing got written meanwhile.
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (segment.sequence.load(std::memory_order_relaxed) == sequence)
+				return;
+		}
+	}
+
+} /* namespace TextSnake */
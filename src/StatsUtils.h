@@ -0,0 +1,137 @@
+/*
+ * StatsUtils.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#ifndef STATSUTILS_H_
+#define STATSUTILS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace TextSnake {
+
+	namespace Constants {
+		// Frame times kept to work the p99 out from. Must be a power of 2.
+		static const std::size_t STATS_FRAME_SAMPLES = 1024;
+		// Ticks between two p99 updates, it's too slow to work out every tick.
+		static const unsigned int STATS_SLOW_UPDATE_TICKS = 60;
+	} /* namespace Constants */
+
+	/*
+	 * Live stats are published in a POSIX shared memory segment, so monitors can sample a running
+	 * game as often as they like without touching its terminal.
+	 *
+	 * The segment is guarded by a sequence lock: the game bumps the sequence to an odd number,
+	 * writes the counters and bumps it to an even number again. Readers copy the counters and
+	 * retry whenever the sequence was odd or changed meanwhile, so the game never waits on them.
+	 * Every counter is a lock free atomic, which keeps the layout valid across processes.
+	 */
+
+	/*
+	 * Layout of the shared memory segment.
+	 */
+	struct LiveStatsSegment {
+		uint32_t magic;
+		uint32_t version;
+		std::atomic<uint64_t> sequence;
+		std::atomic<uint64_t> pid;
+		std::atomic<uint64_t> ticks;
+		std::atomic<uint64_t> frames;
+		std::atomic<uint64_t> lateTicks;
+		std::atomic<uint64_t> droppedTicks;
+		std::atomic<uint64_t> terminalBytes;
+		std::atomic<uint64_t> p99FrameNanos;
+		std::atomic<uint64_t> score;
+		std::atomic<uint64_t> length;
+	};
+
+	/*
+	 * Plain copy of the counters.
+	 * ticks: Game loop iterations that ran the game logic.
+	 * frames: Ticks that repainted the screen.
+	 * lateTicks: Ticks that started more than a whole tick late.
+	 * droppedTicks: Ticks skipped altogether because the loop was running late.
+	 * terminalBytes: Bytes curses wrote to the terminal, 0 when they couldn't be counted.
+	 * p99FrameNanos: 99th percentile of the time spent on the latest frames.
+	 * score: Current score.
+	 * length: Current length of the snake, head included.
+	 */
+	struct LiveStats {
+		uint64_t pid;
+		uint64_t ticks;
+		uint64_t frames;
+		uint64_t lateTicks;
+		uint64_t droppedTicks;
+		uint64_t terminalBytes;
+		uint64_t p99FrameNanos;
+		uint64_t score;
+		uint64_t length;
+	};
+
+	/*
+	 * Publishing end, owned by the game.
+	 */
+	struct LiveStatsPublisher {
+		LiveStatsSegment* segment;
+		std::string name;
+		LiveStats stats;
+		uint64_t frameNanos[Constants::STATS_FRAME_SAMPLES];
+		uint64_t totalFrameSamples;
+	};
+
+	/*
+	 * Creates the shared memory segment and starts publishing.
+	 * publisher: Publisher to set up.
+	 * name: Name of the segment, like "/textsnake".
+	 * Returns false when the segment couldn't be created, errno tells why. EEXIST means the name is in use,
+	 * the segment is left alone then.
+	 */
+	bool OpenLiveStats(LiveStatsPublisher& publisher, const char* name);
+
+	/*
+	 * Removes the shared memory segment.
+	 * publisher: Publisher to close.
+	 */
+	void CloseLiveStats(LiveStatsPublisher& publisher);
+
+	/*
+	 * Keeps how long a frame took, for the p99.
+	 * publisher: Publisher to use.
+	 * nanos: Time spent on the frame.
+	 */
+	void RecordFrameTime(LiveStatsPublisher& publisher, const uint64_t nanos);
+
+	/*
+	 * Works out the slow counters again, the p99 frame time.
+	 * publisher: Publisher to use.
+	 */
+	void UpdateSlowStats(LiveStatsPublisher& publisher);
+
+	/*
+	 * Copies the publisher's counters into the segment.
+	 * publisher: Publisher to use.
+	 */
+	void PublishLiveStats(LiveStatsPublisher& publisher);
+
+	/*
+	 * Maps an existing segment, read only.
+	 * name: Name of the segment.
+	 * Returns nullptr when there's no such segment or it isn't a stats one.
+	 */
+	const LiveStatsSegment* AttachLiveStats(const char* name);
+
+	/*
+	 * Takes a consistent copy of the counters.
+	 * segment: Segment to read.
+	 * stats: Copy to fill in.
+	 */
+	void ReadLiveStats(const LiveStatsSegment& segment, LiveStats& stats);
+
+} /* namespace TextSnake */
+
+#endif /* STATSUTILS_H_ */
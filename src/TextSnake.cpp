@@ -6,12 +6,102 @@
 // Description : Snake game in C++, Ansi-style
 //============================================================================
 
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+
 #include "SnakeUtils.h"
+#include "ReplayUtils.h"
+#include "TraceUtils.h"
+
+int main(int argc, char* argv[]) {
+
+	// A different game every time, unless a seed is given.
+	uint64_t seed = static_cast<uint64_t>(std::time(0));
+	// Empty board the size of the screen, unless a level is given.
+	const char* levelFilename = nullptr;
+	// No live stats, unless a shared memory segment is given.
+	const char* statsName = nullptr;
+	// Walls all around the board, unless wrap mode is asked for.
+	bool isWrapModeOn = false;
+	// Nothing printed about the startup, unless asked for.
+	bool isTracingStartup = false;
+	// No trace of the game loop, unless a file is given.
+	const char* traceFilename = nullptr;
+	// The game gets played, unless a replay is given to watch or to measure.
+	const char* replayFilename = nullptr;
+	bool isBenchmarkingReplay = false;
+
+	for (int i = 1; i < argc; i++) {
+		// Come out on the other side of the board when going through a border.
+		if (std::strcmp(argv[i], "--wrap") == 0) {
+			isWrapModeOn = true;
+			continue;
+		}
+
+		// Tell how long it took to get the first frame on screen, once the game is over.
+		if (std::strcmp(argv[i], "--startup-trace") == 0) {
+			isTracingStartup = true;
+			continue;
+		}
+
+		// Every other option takes a value.
+		if (i + 1 >= argc) {
+			std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+			return 1;
+		}
+
+		if (std::strcmp(argv[i], "--replay") == 0) {
+			// Watch a recorded game.
+			replayFilename = argv[i + 1];
+			isBenchmarkingReplay = false;
+		} else if (std::strcmp(argv[i], "--replay-bench") == 0) {
+			// Measure how fast a recorded game can be simulated.
+			replayFilename = argv[i + 1];
+			isBenchmarkingReplay = true;
+		} else if (std::strcmp(argv[i], "--seed") == 0) {
+			char* end = nullptr;
+			seed = std::strtoull(argv[i + 1], &end, 0);
+
+			if (end == argv[i + 1] || *end != '\0') {
+				std::fprintf(stderr, "Invalid seed: %s\n", argv[i + 1]);
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--level") == 0) {
+			levelFilename = argv[i + 1];
+		} else if (std::strcmp(argv[i], "--trace") == 0) {
+			// Record the game loop's phases for chrome://tracing or Perfetto.
+			traceFilename = argv[i + 1];
+		} else if (std::strcmp(argv[i], "--stats") == 0) {
+			// Publish live stats for snake_stat and other monitors.
+			statsName = argv[i + 1];
+		} else {
+			std::fprintf(stderr, "Usage: %s [--seed <n>] [--level <map>] [--wrap] [--trace <file>] [--startup-trace] [--stats </name>] | --replay <file> | --replay-bench <file>\n", argv[0]);
+			return 1;
+		}
+
+		// Skip the value.
+		i++;
+	}
+
+	// Only start tracing once every argument is known to be good, so nothing returns before the trace is written.
+	if (traceFilename != nullptr)
+		TextSnake::StartTracing(traceFilename);
 
-int main() {
+	if (replayFilename == nullptr) {
+		// Play the game.
+		TextSnake::Start(seed, levelFilename, isWrapModeOn, statsName, isTracingStartup);
+	} else if (isBenchmarkingReplay) {
+		TextSnake::BenchmarkReplay(replayFilename);
+	} else {
+		TextSnake::PlayReplay(replayFilename);
+	}
 
-	// Play the game.
-	TextSnake::Start();
+	// Write the trace, if one was asked for.
+	if (!TextSnake::StopTracing())
+		std::fprintf(stderr, "Couldn't write the trace\n");
 
 	return 0;
 }
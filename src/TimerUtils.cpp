@@ -0,0 +1,155 @@
+/*
+ * TimerUtils.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#include "TimerUtils.h"
+
+namespace TextSnake {
+
+	namespace {
+
+		/*
+		 * Puts a timer in the slot matching how far away it expires.
+		 */
+		void InsertTimer(TimerWheel& wheel, const int32_t index) {
+			Timer& timer = wheel.timers[index];
+			uint64_t delay = timer.expiry - wheel.currentTick;
+
+			// Find the lowest level reaching far enough.
+			unsigned int level = 0;
+			while (level + 1 < Constants::TIMER_WHEEL_LEVELS &&
+			       delay >= (uint64_t(1) << ((level + 1) * Constants::TIMER_WHEEL_SLOT_BITS)))
+				level++;
+
+			// Timers beyond the last level wait in its furthest slot and get placed again once it cascades.
+			uint64_t position = timer.expiry;
+			uint64_t levelReach = uint64_t(1) << ((level + 1) * Constants::TIMER_WHEEL_SLOT_BITS);
+			if (delay >= levelReach)
+				position = wheel.currentTick + levelReach - 1;
+
+			unsigned int slotIndex = (position >> (level * Constants::TIMER_WHEEL_SLOT_BITS)) & (Constants::TIMER_WHEEL_SLOTS - 1);
+			int32_t& head = wheel.slots[level][slotIndex];
+
+			// Push it in front of the slot's list.
+			timer.slot = static_cast<int32_t>(level * Constants::TIMER_WHEEL_SLOTS + slotIndex);
+			timer.previous = -1;
+			timer.next = head;
+			if (head >= 0)
+				wheel.timers[head].previous = index;
+			head = index;
+		}
+
+		/*
+		 * Takes a timer out of its slot's list.
+		 */
+		void UnlinkTimer(TimerWheel& wheel, const int32_t index) {
+			Timer& timer = wheel.timers[index];
+
+			if (timer.previous >= 0)
+				wheel.timers[timer.previous].next = timer.next;
+			else
+				wheel.slots[timer.slot / Constants::TIMER_WHEEL_SLOTS][timer.slot % Constants::TIMER_WHEEL_SLOTS] = timer.next;
+
+			if (timer.next >= 0)
+				wheel.timers[timer.next].previous = timer.previous;
+
+			timer.previous = -1;
+			timer.next = -1;
+		}
+
+	}
+
+	void InitTimerWheel(TimerWheel& wheel, const std::size_t reservedTimers) {
+		wheel.currentTick = 0;
+
+		for (unsigned int level = 0; level < Constants::TIMER_WHEEL_LEVELS; level++)
+			for (unsigned int slot = 0; slot < Constants::TIMER_WHEEL_SLOTS; slot++)
+				wheel.slots[level][slot] = -1;
+
+		// Keeps its memory when the wheel gets reused.
+		wheel.timers.clear();
+		wheel.timers.reserve(reservedTimers);
+
+		wheel.freeList = -1;
+		wheel.totalPending = 0;
+	}
+
+
+	TimerHandle ScheduleTimer(TimerWheel& wheel, uint64_t delay, const uint32_t event, const uint32_t payload) {
+		// A timer for this very tick would land in the slot being expired.
+		if (delay == 0)
+			delay = 1;
+
+		// Reuse a free entry, or grow the pool.
+		int32_t index = wheel.freeList;
+		if (index >= 0) {
+			wheel.freeList = wheel.timers[index].next;
+		} else {
+			Timer timer;
+			timer.generation = 0;
+			index = static_cast<int32_t>(wheel.timers.size());
+			wheel.timers.push_back(timer);
+		}
+
+		Timer& timer = wheel.timers[index];
+		timer.expiry = wheel.currentTick + delay;
+		timer.event = event;
+		timer.payload = payload;
+
+		InsertTimer(wheel, index);
+		wheel.totalPending++;
+
+		TimerHandle handle;
+		handle.index = index;
+		handle.generation = timer.generation;
+
+		return handle;
+	}
+
+
+	bool CancelTimer(TimerWheel& wheel, TimerHandle& handle) {
+		bool isPending = IsTimerPending(wheel, handle);
+
+		if (isPending)
+			ReleaseTimer(wheel, handle.index);
+
+		handle = NO_TIMER;
+
+		return isPending;
+	}
+
+
+	void CascadeTimers(TimerWheel& wheel, const unsigned int level) {
+		unsigned int slotIndex = (wheel.currentTick >> (level * Constants::TIMER_WHEEL_SLOT_BITS)) & (Constants::TIMER_WHEEL_SLOTS - 1);
+
+		// Take the whole list out first, its timers go to other slots.
+		int32_t index = wheel.slots[level][slotIndex];
+		wheel.slots[level][slotIndex] = -1;
+
+		while (index >= 0) {
+			int32_t next = wheel.timers[index].next;
+			InsertTimer(wheel, index);
+			index = next;
+		}
+	}
+
+
+	void ReleaseTimer(TimerWheel& wheel, const int32_t index) {
+		UnlinkTimer(wheel, index);
+
+		// Stale handles won't match it anymore.
+		Timer& timer = wheel.timers[index];
+		timer.slot = -1;
+		timer.generation++;
+
+		// The free list goes through next.
+		timer.next = wheel.freeList;
+		wheel.freeList = index;
+
+		wheel.totalPending--;
+	}
+
+} /* namespace TextSnake */
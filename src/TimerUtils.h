@@ -0,0 +1,165 @@
+/*
+ * TimerUtils.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#ifndef TIMERUTILS_H_
+#define TIMERUTILS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace TextSnake {
+
+	namespace Constants {
+		static const unsigned int TIMER_WHEEL_LEVELS = 4;
+		static const unsigned int TIMER_WHEEL_SLOT_BITS = 6;
+		static const unsigned int TIMER_WHEEL_SLOTS = 1 << TIMER_WHEEL_SLOT_BITS;
+	} /* namespace Constants */
+
+	/*
+	 * Hierarchical timer wheel counting in ticks.
+	 *
+	 * Level 0 has a slot for each of the next 64 ticks, level 1 a slot for each of the next 64 blocks
+	 * of 64 ticks, and so on, so 4 levels reach 2^24 ticks ahead (further timers wait on the last level).
+	 * Every slot is a doubly linked list threaded through the timers' pool, which makes scheduling and
+	 * cancelling O(1). Each tick only looks at one level 0 slot, and every 64 ticks one slot of an upper
+	 * level gets spread over the level below, so a tick costs the same however many timers are pending.
+	 *
+	 * The wheel is plain data, it can be copied byte for byte along with the rest of the game.
+	 */
+
+	/*
+	 * A pending timer, or a free entry of the pool.
+	 */
+	struct Timer {
+		uint64_t expiry;
+		uint32_t event;
+		uint32_t payload;
+		int32_t previous;
+		int32_t next;
+		int32_t slot;
+		uint32_t generation;
+	};
+
+	/*
+	 * Refers to a scheduled timer. It goes stale once the timer expires or gets cancelled.
+	 */
+	struct TimerHandle {
+		int32_t index;
+		uint32_t generation;
+	};
+
+	/*
+	 * The wheel itself.
+	 */
+	struct TimerWheel {
+		uint64_t currentTick;
+		int32_t slots[Constants::TIMER_WHEEL_LEVELS][Constants::TIMER_WHEEL_SLOTS];
+		std::vector<Timer> timers;
+		int32_t freeList;
+		uint32_t totalPending;
+	};
+
+	/*
+	 * Handle that never refers to a timer.
+	 */
+	static const TimerHandle NO_TIMER = { -1, 0 };
+
+	/*
+	 * Empties the wheel and starts counting from tick 0.
+	 * wheel: Wheel to set up.
+	 * reservedTimers: Timers that can be pending at once before the pool has to grow.
+	 */
+	void InitTimerWheel(TimerWheel& wheel, const std::size_t reservedTimers);
+
+	/*
+	 * Schedules a timer.
+	 * wheel: Wheel to use.
+	 * delay: Ticks until it expires, at least 1.
+	 * event: What the timer is for, handed back when it expires.
+	 * payload: Anything else the event needs.
+	 * Returns the timer's handle.
+	 */
+	TimerHandle ScheduleTimer(TimerWheel& wheel, uint64_t delay, const uint32_t event, const uint32_t payload);
+
+	/*
+	 * Cancels a timer and makes its handle refer to nothing.
+	 * wheel: Wheel to use.
+	 * handle: Handle of the timer.
+	 * Returns false when the timer already expired or got cancelled.
+	 */
+	bool CancelTimer(TimerWheel& wheel, TimerHandle& handle);
+
+	/*
+	 * Moves the timers of the given level's current slot down to the level below.
+	 * It's called by AdvanceTimers.
+	 * wheel: Wheel to use.
+	 * level: Level to cascade, above 0.
+	 */
+	void CascadeTimers(TimerWheel& wheel, const unsigned int level);
+
+	/*
+	 * Takes a timer out of its slot and gives it back to the pool.
+	 * wheel: Wheel to use.
+	 * index: Index of the timer.
+	 */
+	void ReleaseTimer(TimerWheel& wheel, const int32_t index);
+
+	/*
+	 * Tells whether a timer is still pending.
+	 * wheel: Wheel to use.
+	 * handle: Handle of the timer.
+	 */
+	inline bool IsTimerPending(const TimerWheel& wheel, const TimerHandle& handle) {
+		return handle.index >= 0 &&
+		       wheel.timers[handle.index].generation == handle.generation &&
+		       wheel.timers[handle.index].slot >= 0;
+	}
+
+	/*
+	 * Returns the ticks left before a timer expires, 0 when it isn't pending.
+	 * wheel: Wheel to use.
+	 * handle: Handle of the timer.
+	 */
+	inline uint64_t GetTimerTicksLeft(const TimerWheel& wheel, const TimerHandle& handle) {
+		return IsTimerPending(wheel, handle) ? wheel.timers[handle.index].expiry - wheel.currentTick : 0;
+	}
+
+	/*
+	 * Moves the wheel one tick forward and calls the handler with every timer expiring on it.
+	 * The handler gets the timer's event and payload, and may schedule or cancel timers.
+	 * wheel: Wheel to move.
+	 * handler: Called as handler(event, payload).
+	 */
+	template <typename Handler>
+	void AdvanceTimers(TimerWheel& wheel, Handler&& handler) {
+		wheel.currentTick++;
+
+		// Whenever a level wraps around, the level above spreads its next slot over it.
+		for (unsigned int level = 1; level < Constants::TIMER_WHEEL_LEVELS; level++) {
+			if ((wheel.currentTick & ((uint64_t(1) << (level * Constants::TIMER_WHEEL_SLOT_BITS)) - 1)) != 0)
+				break;
+
+			CascadeTimers(wheel, level);
+		}
+
+		// Everything in this tick's slot expires now.
+		// New timers are at least a tick away, so none of them can land in this slot meanwhile.
+		int32_t& slot = wheel.slots[0][wheel.currentTick & (Constants::TIMER_WHEEL_SLOTS - 1)];
+		while (slot >= 0) {
+			int32_t index = slot;
+			uint32_t event = wheel.timers[index].event;
+			uint32_t payload = wheel.timers[index].payload;
+
+			ReleaseTimer(wheel, index);
+			handler(event, payload);
+		}
+	}
+
+} /* namespace TextSnake */
+
+#endif /* TIMERUTILS_H_ */
@@ -0,0 +1,189 @@
+/*
+ * TraceUtils.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#include "TraceUtils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace TextSnake {
+
+	std::atomic<bool> isTracing(false);
+
+	namespace {
+
+		// Where the trace goes once it stops.
+		std::string traceFilename;
+
+		// Time every timestamp is relative to.
+		std::chrono::steady_clock::time_point traceStart;
+
+		// Every thread's ring, guarded by the mutex. Only touched the first time a thread records.
+		std::mutex ringsMutex;
+		std::vector<std::unique_ptr<TraceRing>> rings;
+
+		// Goes up every time tracing stops and the rings get released, so threads know theirs is gone.
+		std::atomic<uint64_t> ringsGeneration(0);
+
+		// Calling thread's ring and the generation it belongs to, made the first time it records.
+		thread_local TraceRing* threadRing = nullptr;
+		thread_local uint64_t threadRingGeneration = 0;
+
+		/*
+		 * Returns the calling thread's ring, making and registering it if needed.
+		 */
+		TraceRing& GetThreadRing() {
+			uint64_t generation = ringsGeneration.load(std::memory_order_acquire);
+
+			if (threadRing == nullptr || threadRingGeneration != generation) {
+				std::unique_ptr<TraceRing> ring(new TraceRing);
+				ring->head.store(0, std::memory_order_relaxed);
+
+				std::lock_guard<std::mutex> lock(ringsMutex);
+				ring->threadId = static_cast<uint32_t>(rings.size()) + 1;
+
+				threadRing = ring.get();
+				threadRingGeneration = generation;
+				rings.push_back(std::move(ring));
+			}
+
+			return *threadRing;
+		}
+
+		/*
+		 * Releases every ring, threads make a new one the next time they record.
+		 */
+		void ReleaseRings() {
+			std::lock_guard<std::mutex> lock(ringsMutex);
+			rings.clear();
+			ringsGeneration.fetch_add(1, std::memory_order_release);
+		}
+
+		/*
+		 * Writes the events of a ring, from the oldest one still in it.
+		 * Ends whose begin got overwritten are left out, so the timeline doesn't end up unbalanced.
+		 */
+		void WriteRing(FILE* file, const TraceRing& ring, bool& isFirstEvent) {
+			uint64_t head = ring.head.load(std::memory_order_acquire);
+			uint64_t first = (head > Constants::TRACE_RING_SIZE) ? head - Constants::TRACE_RING_SIZE : 0;
+
+			// Name the thread on the timeline.
+			std::fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+			             isFirstEvent ? "" : ",", ring.threadId, (ring.threadId == 1) ? "Game loop" : "Worker");
+			isFirstEvent = false;
+
+			unsigned int depth = 0;
+			for (uint64_t i = first; i < head; i++) {
+				const TraceEvent& event = ring.events[i & (Constants::TRACE_RING_SIZE - 1)];
+
+				if (event.phase == 'B') {
+					depth++;
+				} else {
+					if (depth == 0)
+						continue;
+					depth--;
+				}
+
+				// Timestamps are in microseconds.
+				std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+				             event.name, event.phase, event.timestamp / 1000.0, ring.threadId);
+			}
+		}
+
+	}
+
+	void StartTracing(const char* filename) {
+		traceFilename = filename;
+		traceStart = std::chrono::steady_clock::now();
+
+		// Set up this thread's ring now rather than in the middle of a frame.
+		GetThreadRing();
+
+		isTracing.store(true, std::memory_order_release);
+	}
+
+
+	bool StopTracing() {
+		if (!isTracing.exchange(false))
+			return true;
+
+		FILE* file = std::fopen(traceFilename.c_str(), "w");
+		if (file == nullptr) {
+			ReleaseRings();
+			return false;
+		}
+
+		std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+		{
+			std::lock_guard<std::mutex> lock(ringsMutex);
+			bool isFirstEvent = true;
+			for (std::size_t i = 0; i < rings.size(); i++)
+				WriteRing(file, *rings[i], isFirstEvent);
+		}
+
+		std::fprintf(file, "\n]}\n");
+
+		// Every ring is written, none of them is needed anymore.
+		ReleaseRings();
+
+		return std::fclose(file) == 0;
+	}
+
+
+	void RecordTraceEvent(const char* name, const char phase) {
+		TraceRing& ring = GetThreadRing();
+
+		// Only this thread writes to the ring, the release store publishes the event to whoever writes the trace.
+		uint64_t head = ring.head.load(std::memory_order_relaxed);
+		TraceEvent& event = ring.events[head & (Constants::TRACE_RING_SIZE - 1)];
+
+		event.name = name;
+		event.timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - traceStart).count());
+		event.phase = phase;
+
+		ring.head.store(head + 1, std::memory_order_release);
+	}
+
+
+	void StartStartupTrace(StartupTrace& trace, const bool isOn) {
+		trace.isOn = isOn;
+		trace.phases.clear();
+		trace.start = std::chrono::steady_clock::now();
+		trace.phaseStart = trace.start;
+	}
+
+
+	void EndStartupPhase(StartupTrace& trace, const char* name) {
+		if (!trace.isOn)
+			return;
+
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		std::chrono::duration<uint64_t, std::nano> phaseTime = now - trace.phaseStart;
+
+		trace.phases.push_back({name, phaseTime.count()});
+		trace.phaseStart = now;
+	}
+
+
+	void PrintStartupTrace(const StartupTrace& trace, FILE* file) {
+		if (!trace.isOn)
+			return;
+
+		std::chrono::duration<double, std::milli> totalTime = trace.phaseStart - trace.start;
+		std::fprintf(file, "Startup took %.3f ms\n", totalTime.count());
+
+		for (const StartupPhase& phase : trace.phases)
+			std::fprintf(file, "  %-16s %10.3f ms\n", phase.name, phase.nanos / 1e6);
+	}
+
+} /* namespace TextSnake */
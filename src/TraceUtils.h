@@ -0,0 +1,141 @@
+/*
+ * TraceUtils.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ */
+
+#ifndef TRACEUTILS_H_
+#define TRACEUTILS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace TextSnake {
+
+	namespace Constants {
+		// Events kept per thread, the oldest ones get overwritten once it's full. Must be a power of 2.
+		static const std::size_t TRACE_RING_SIZE = 1 << 18;
+	} /* namespace Constants */
+
+	/*
+	 * Records when each phase of the game loop begins and ends, and writes them as Chrome trace event JSON,
+	 * which chrome://tracing and Perfetto show on a timeline.
+	 * Every thread records into its own ring buffer, so recording never takes a lock.
+	 * Event names have to be string literals, only their pointers get stored.
+	 */
+
+	/*
+	 * A single begin or end of a phase.
+	 */
+	struct TraceEvent {
+		const char* name;
+		uint64_t timestamp;
+		char phase;
+	};
+
+	/*
+	 * Events recorded by one thread.
+	 * Only the owning thread writes to it, head tells how many events it ever recorded.
+	 */
+	struct TraceRing {
+		TraceEvent events[Constants::TRACE_RING_SIZE];
+		std::atomic<uint64_t> head;
+		uint32_t threadId;
+	};
+
+	/*
+	 * True while tracing, checked before recording anything so tracing costs a single branch when it's off.
+	 */
+	extern std::atomic<bool> isTracing;
+
+	/*
+	 * Starts tracing, the events get written to the given file when tracing stops.
+	 * It also sets up the calling thread's ring, so recording from it won't allocate later on.
+	 * filename: Name of the JSON file to write.
+	 */
+	void StartTracing(const char* filename);
+
+	/*
+	 * Stops tracing, writes every recorded event and releases every thread's ring.
+	 * Other threads must be done recording by then.
+	 * Returns false when the file couldn't be written.
+	 */
+	bool StopTracing();
+
+	/*
+	 * Stores an event in the calling thread's ring.
+	 * name: Name of the phase.
+	 * phase: 'B' when it begins, 'E' when it ends.
+	 */
+	void RecordTraceEvent(const char* name, const char phase);
+
+	/*
+	 * Marks the beginning of a phase.
+	 * name: Name of the phase.
+	 */
+	inline void TraceBegin(const char* name) {
+		if (isTracing.load(std::memory_order_relaxed))
+			RecordTraceEvent(name, 'B');
+	}
+
+	/*
+	 * Marks the end of a phase.
+	 * name: Name of the phase.
+	 */
+	inline void TraceEnd(const char* name) {
+		if (isTracing.load(std::memory_order_relaxed))
+			RecordTraceEvent(name, 'E');
+	}
+
+	/*
+	 * A startup phase and how long it took.
+	 */
+	struct StartupPhase {
+		const char* name;
+		uint64_t nanos;
+	};
+
+	/*
+	 * Breaks the time it takes to get the first frame on screen down by phase.
+	 * Phases follow each other, each one lasts from the end of the previous one.
+	 * start: When startup began.
+	 * phaseStart: When the current phase began.
+	 * phases: Phases done so far.
+	 * isOn: Whether anything gets recorded.
+	 */
+	struct StartupTrace {
+		std::chrono::steady_clock::time_point start;
+		std::chrono::steady_clock::time_point phaseStart;
+		std::vector<StartupPhase> phases;
+		bool isOn;
+	};
+
+	/*
+	 * Starts timing the startup, the first phase begins right away.
+	 * trace: Trace to start.
+	 * isOn: Whether to record anything at all.
+	 */
+	void StartStartupTrace(StartupTrace& trace, const bool isOn);
+
+	/*
+	 * Ends the current phase, the next one begins right away.
+	 * trace: Started trace.
+	 * name: Name of the phase, it has to be a string literal.
+	 */
+	void EndStartupPhase(StartupTrace& trace, const char* name);
+
+	/*
+	 * Prints every phase and the total time they took.
+	 * trace: Trace to print.
+	 * file: Where to print it.
+	 */
+	void PrintStartupTrace(const StartupTrace& trace, FILE* file);
+
+} /* namespace TextSnake */
+
+#endif /* TRACEUTILS_H_ */
@@ -0,0 +1,104 @@
+/*
+ * SnakeStat.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: danielgrieco
+ *
+ * snake_stat: prints the live stats a game started with --stats publishes, vmstat style.
+ * It only maps the segment read only, the game never waits on it.
+ * Build it together with src/StatsUtils.cpp:
+ *
+ *   g++ -std=c++17 -O2 tools/SnakeStat.cpp src/StatsUtils.cpp -o snake_stat
+ *   ./snake_stat /textsnake          one line per second
+ *   ./snake_stat /textsnake 100      one line every 100 milliseconds
+ *   ./snake_stat /textsnake 0        a single line
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "../src/StatsUtils.h"
+
+using namespace TextSnake;
+
+namespace {
+
+	// Time between two lines when none is given.
+	const unsigned long DEFAULT_INTERVAL_MS = 1000;
+
+	// Lines between two headers.
+	const unsigned int HEADER_EVERY_LINES = 20;
+
+	/*
+	 * Prints the columns' names.
+	 */
+	void PrintHeader() {
+		std::printf("%8s %10s %10s %8s %8s %8s %12s %9s %8s %8s\n",
+		            "pid", "ticks", "frames", "ticks/s", "late", "dropped", "bytes", "p99 ms", "score", "length");
+	}
+
+	/*
+	 * Prints a line of stats.
+	 */
+	void PrintStats(const LiveStats& stats, const double ticksPerSecond) {
+		std::printf("%8llu %10llu %10llu %8.1f %8llu %8llu %12llu %9.3f %8llu %8llu\n",
+		            static_cast<unsigned long long>(stats.pid),
+		            static_cast<unsigned long long>(stats.ticks),
+		            static_cast<unsigned long long>(stats.frames),
+		            ticksPerSecond,
+		            static_cast<unsigned long long>(stats.lateTicks),
+		            static_cast<unsigned long long>(stats.droppedTicks),
+		            static_cast<unsigned long long>(stats.terminalBytes),
+		            stats.p99FrameNanos / 1000000.0,
+		            static_cast<unsigned long long>(stats.score),
+		            static_cast<unsigned long long>(stats.length));
+	}
+
+}
+
+
+int main(int argc, char* argv[]) {
+	if (argc < 2 || argc > 3) {
+		std::fprintf(stderr, "Usage: %s </name> [interval_ms]\n", argv[0]);
+		return 1;
+	}
+
+	unsigned long intervalMs = (argc == 3) ? std::strtoul(argv[2], nullptr, 10) : DEFAULT_INTERVAL_MS;
+
+	const LiveStatsSegment* segment = AttachLiveStats(argv[1]);
+	if (segment == nullptr) {
+		std::fprintf(stderr, "No live stats in %s, is the game running with --stats %s?\n", argv[1], argv[1]);
+		return 1;
+	}
+
+	LiveStats stats;
+	ReadLiveStats(*segment, stats);
+
+	PrintHeader();
+
+	if (intervalMs == 0) {
+		PrintStats(stats, 0.0);
+		return 0;
+	}
+
+	for (unsigned int line = 1; ; line++) {
+		uint64_t ticksBefore = stats.ticks;
+
+		usleep(static_cast<useconds_t>(intervalMs * 1000));
+		ReadLiveStats(*segment, stats);
+
+		if (line % HEADER_EVERY_LINES == 0)
+			PrintHeader();
+
+		PrintStats(stats, (stats.ticks - ticksBefore) * 1000.0 / intervalMs);
+		std::fflush(stdout);
+
+		// Stop once the game is gone.
+		if (kill(static_cast<pid_t>(stats.pid), 0) != 0 && errno == ESRCH)
+			return 0;
+	}
+}